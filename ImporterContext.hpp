@@ -27,6 +27,7 @@
 
 #include <list>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace onnx2trt
 {
@@ -44,10 +45,17 @@ class ImporterContext final : public IImporterContext
     StringMap<float> mTensorRangeMins;
     StringMap<float> mTensorRangeMaxes;
     StringMap<nvinfer1::DataType> mLayerPrecisions;
+    std::unordered_set<std::string> mLoggedWarnings; // Warnings that should only be emitted once per model.
+    StringMap<size_t> mTensorConsumerCounts;
+    StringMap<::ONNX_NAMESPACE::NodeProto const*> mTensorConsumers;
+    StringMap<std::vector<int>> mFoldedPads;
+    StringMap<nvinfer1::IFullyConnectedLayer*> mBiaslessFullyConnectedLayers;
+    StringMap<nvinfer1::IScaleLayer*> mShiftlessScaleLayers;
     StringMap<size_t>
         mTensorNameCounts; // Keep track of how many times a tensor name shows up, to avoid duplicate naming in TRT.
     StringMap<size_t>
         mLayerNameCounts; // Keep track of how many times a tensor name shows up, to avoid duplicate naming in TRT.
+    int32_t mMaxLoopScanOutputLength{0}; // A parser option, so it is kept by reset().
 public:
     ImporterContext(nvinfer1::INetworkDefinition* network, nvinfer1::ILogger* logger)
         : _network(network)
@@ -78,6 +86,30 @@ public:
     {
         return mLayerPrecisions;
     }
+    virtual std::unordered_set<std::string>& loggedWarnings() override
+    {
+        return mLoggedWarnings;
+    }
+    virtual StringMap<size_t>& tensorConsumerCounts() override
+    {
+        return mTensorConsumerCounts;
+    }
+    virtual StringMap<::ONNX_NAMESPACE::NodeProto const*>& tensorConsumers() override
+    {
+        return mTensorConsumers;
+    }
+    virtual StringMap<std::vector<int>>& foldedPads() override
+    {
+        return mFoldedPads;
+    }
+    virtual StringMap<nvinfer1::IFullyConnectedLayer*>& biaslessFullyConnectedLayers() override
+    {
+        return mBiaslessFullyConnectedLayers;
+    }
+    virtual StringMap<nvinfer1::IScaleLayer*>& shiftlessScaleLayers() override
+    {
+        return mShiftlessScaleLayers;
+    }
 
     // This actually handles weights as well, but is named this way to be consistent with the tensors()
     virtual void registerTensor(TensorOrWeights tensor, const std::string& basename) override
@@ -130,6 +162,15 @@ public:
         return *_logger;
     }
 
+    virtual int32_t maxLoopScanOutputLength() const override
+    {
+        return mMaxLoopScanOutputLength;
+    }
+    void setMaxLoopScanOutputLength(int32_t length)
+    {
+        mMaxLoopScanOutputLength = length;
+    }
+
     virtual ShapedWeights createTempWeights(ShapedWeights::DataType type, nvinfer1::Dims shape) override
     {
         ShapedWeights weights(type, nullptr, shape);
@@ -182,6 +223,29 @@ public:
     {
         return _user_outputs;
     }
+    // Drops all state from previously imported models, freeing any temporary weights, and retargets the context
+    // at the given network.
+    void reset(nvinfer1::INetworkDefinition* network)
+    {
+        _network = network;
+        _temp_bufs.clear();
+        _user_inputs.clear();
+        _user_outputs.clear();
+        _opsets.clear();
+        mTensors.clear();
+        mTensorLocations.clear();
+        mTensorRangeMins.clear();
+        mTensorRangeMaxes.clear();
+        mLayerPrecisions.clear();
+        mLoggedWarnings.clear();
+        mTensorConsumerCounts.clear();
+        mTensorConsumers.clear();
+        mFoldedPads.clear();
+        mBiaslessFullyConnectedLayers.clear();
+        mShiftlessScaleLayers.clear();
+        mTensorNameCounts.clear();
+        mLayerNameCounts.clear();
+    }
     void clearOpsets()
     {
         _opsets.clear();
@@ -22,6 +22,7 @@
 
 #include "ModelImporter.hpp"
 #include "OnnxAttrs.hpp"
+#include "SubGraphPartitioner.hpp"
 #include "onnx2trt_utils.hpp"
 #include "onnx_utils.hpp"
 #include "toposort.hpp"
@@ -81,6 +82,39 @@ Status setStringMap(
     return Status::success();
 }
 
+// Counts the reads of every value of a graph and its nested subgraphs, and records the last node reading it. Graph
+// outputs count as a read.
+void countTensorConsumers(::ONNX_NAMESPACE::GraphProto const& graph, StringMap<size_t>& counts,
+    StringMap<::ONNX_NAMESPACE::NodeProto const*>& consumers)
+{
+    for (auto const& node : graph.node())
+    {
+        for (auto const& input : node.input())
+        {
+            if (!input.empty())
+            {
+                ++counts[input];
+                consumers[input] = &node;
+            }
+        }
+        for (auto const& attr : node.attribute())
+        {
+            if (attr.has_g())
+            {
+                countTensorConsumers(attr.g(), counts, consumers);
+            }
+            for (auto const& subgraph : attr.graphs())
+            {
+                countTensorConsumers(subgraph, counts, consumers);
+            }
+        }
+    }
+    for (auto const& output : graph.output())
+    {
+        ++counts[output.name()];
+    }
+}
+
 Status parseGraph(
     IImporterContext* ctx, const ::ONNX_NAMESPACE::GraphProto& graph, bool deserializingINetwork, int* currentNode)
 {
@@ -288,6 +322,177 @@ Status deserialize_onnx_model(int fd, bool is_serialized_as_text, ::ONNX_NAMESPA
     return Status::success();
 }
 
+CheckerInput describeWeights(::ONNX_NAMESPACE::TensorProto const& weights)
+{
+    CheckerInput desc;
+    desc.isNull = false;
+    desc.isWeights = true;
+    desc.dtype = weights.data_type();
+    desc.rank = weights.dims().size();
+    desc.weights = &weights;
+    return desc;
+}
+
+// Describes a tensor about which nothing else is known.
+CheckerInput describeUnknownTensor()
+{
+    CheckerInput desc;
+    desc.isNull = false;
+    return desc;
+}
+
+CheckerInput describeValue(::ONNX_NAMESPACE::ValueInfoProto const& value)
+{
+    CheckerInput desc;
+    desc.isNull = false;
+    auto const& tensorType = value.type().tensor_type();
+    desc.dtype = tensorType.elem_type();
+    if (tensorType.has_shape())
+    {
+        desc.rank = tensorType.shape().dim().size();
+    }
+    return desc;
+}
+
+// Determines the ONNX data type of a node output from the op semantics, for outputs without a value_info entry.
+int32_t inferOutputType(::ONNX_NAMESPACE::NodeProto const& node, std::vector<CheckerInput> const& inputs)
+{
+    static const std::unordered_set<std::string> boolOps{"And", "Equal", "Greater", "IsInf", "IsNaN", "Less", "Not",
+        "Or", "Xor"};
+    static const std::unordered_set<std::string> int64Ops{"ArgMax", "ArgMin", "NonZero", "Shape", "Size"};
+    const std::string& op = node.op_type();
+    if (op == "Cast")
+    {
+        return OnnxAttrs(node, nullptr).get<int>("to", ::ONNX_NAMESPACE::TensorProto::UNDEFINED);
+    }
+    if (boolOps.count(op))
+    {
+        return ::ONNX_NAMESPACE::TensorProto::BOOL;
+    }
+    if (int64Ops.count(op))
+    {
+        return ::ONNX_NAMESPACE::TensorProto::INT64;
+    }
+    for (auto const& input : inputs)
+    {
+        if (!input.isNull)
+        {
+            return input.dtype;
+        }
+    }
+    return ::ONNX_NAMESPACE::TensorProto::UNDEFINED;
+}
+
+bool analyzeGraph(::ONNX_NAMESPACE::ModelProto const& model, std::vector<size_t> const& topoOrder,
+    std::vector<bool>& supported, std::vector<Status>& errors)
+{
+    ::ONNX_NAMESPACE::GraphProto const& graph = model.graph();
+    int64_t opset = 1;
+    for (auto const& opsetImport : model.opset_import())
+    {
+        if (model.opset_import().size() == 1 || opsetImport.domain().empty() || opsetImport.domain() == "ai.onnx")
+        {
+            opset = opsetImport.version();
+        }
+    }
+
+    // Type and rank information for intermediate values, where the exporter provided it.
+    string_map<CheckerInput> valueInfos;
+    for (auto const& value : graph.value_info())
+    {
+        valueInfos[value.name()] = describeValue(value);
+    }
+    for (auto const& value : graph.output())
+    {
+        valueInfos[value.name()] = describeValue(value);
+    }
+
+    string_map<CheckerInput> values;
+    for (auto const& initializer : graph.initializer())
+    {
+        values[initializer.name()] = describeWeights(initializer);
+    }
+    std::unordered_set<std::string> unsupportedInputs;
+    for (auto const& input : graph.input())
+    {
+        if (values.count(input.name()))
+        {
+            continue;
+        }
+        values[input.name()] = describeValue(input);
+        nvinfer1::DataType trtDtype;
+        nvinfer1::Dims trtDims;
+        if (!convertDtype(input.type().tensor_type().elem_type(), &trtDtype)
+            || !convertOnnxDims(input.type().tensor_type().shape().dim(), trtDims))
+        {
+            unsupportedInputs.insert(input.name());
+        }
+    }
+
+    const string_map<NodeImporter>& opImporters = getBuiltinOpImporterMap();
+    const string_map<NodeChecker>& opCheckers = getBuiltinOpCheckerMap();
+    bool allSupported{true};
+    for (size_t nodeIndex : topoOrder)
+    {
+        auto const& node = graph.node(nodeIndex);
+        std::vector<CheckerInput> nodeInputs;
+        Status status = Status::success();
+        for (auto const& inputName : node.input())
+        {
+            if (inputName.empty())
+            {
+                nodeInputs.emplace_back();
+                continue;
+            }
+            if (unsupportedInputs.count(inputName))
+            {
+                status = MAKE_ERROR("Unsupported network input: " + inputName, ErrorCode::kUNSUPPORTED_GRAPH);
+            }
+            // Inputs defined outside of the graph (e.g. in an enclosing scope) are treated as tensors.
+            nodeInputs.push_back(values.count(inputName) ? values.at(inputName) : describeUnknownTensor());
+        }
+
+        if (!opImporters.count(node.op_type()))
+        {
+            status = MAKE_ERROR("No importer registered for op: " + node.op_type(), ErrorCode::kUNSUPPORTED_NODE);
+        }
+        else if (status.is_success() && opCheckers.count(node.op_type()))
+        {
+            status = opCheckers.at(node.op_type())(opset, node, nodeInputs);
+        }
+
+        supported[nodeIndex] = status.is_success();
+        if (status.is_error())
+        {
+            status.setNode(nodeIndex);
+            errors.push_back(status);
+            allSupported = false;
+        }
+
+        // Describe the outputs so that consumers can be checked.
+        for (int i = 0; i < node.output().size(); ++i)
+        {
+            const auto& outputName = node.output(i);
+            if (node.op_type() == "Constant")
+            {
+                OnnxAttrs attrs(node, nullptr);
+                if (attrs.count("value"))
+                {
+                    values[outputName] = describeWeights(attrs.at("value")->t());
+                    continue;
+                }
+            }
+            CheckerInput desc = valueInfos.count(outputName) ? valueInfos.at(outputName) : describeUnknownTensor();
+            if (desc.dtype == ::ONNX_NAMESPACE::TensorProto::UNDEFINED)
+            {
+                desc.dtype = inferOutputType(node, nodeInputs);
+            }
+            values[outputName] = desc;
+        }
+    }
+    return allSupported;
+}
+
 bool ModelImporter::supportsModel(
     void const* serialized_onnx_model, size_t serialized_onnx_model_size, SubGraphCollection_t& sub_graph_collection)
 {
@@ -344,7 +549,6 @@ bool ModelImporter::supportsModel(
         return false;
     };
 
-    bool newSubGraph(true);
     // Sort and partition supported subgraphs
     std::vector<size_t> topological_order;
     if (!toposort(model.graph().node(), &topological_order))
@@ -352,6 +556,7 @@ bool ModelImporter::supportsModel(
         cout << "Failed to sort model topologically, exiting ..." << endl;
         return false;
     }
+    std::vector<bool> supported(model.graph().node_size());
     for (int node_idx : topological_order)
     {
         ::ONNX_NAMESPACE::NodeProto const& node = model.graph().node(node_idx);
@@ -362,32 +567,39 @@ bool ModelImporter::supportsModel(
         bool registered = supportsOperator(node.op_type().c_str());
         bool containsInput = (input_node.empty()) ? false : checkForInput(node);
         bool containsIndex = node_idx == error_node;
-        if (registered && !containsInput && !containsIndex)
-        {
-            if (newSubGraph)
-            {
-                // If it is the beginning of a new subGraph, we start a new vector
-                sub_graph_collection.emplace_back();
-                // Mark all new graphs as "unknown"
-                sub_graph_collection.back().second = false;
-                newSubGraph = false;
-            }
-            // We add the new node to the last graph
-            sub_graph_collection.back().first.emplace_back(node_idx);
-        }
-        else
-        {
-            // This is not a supported node, reset newSubGraph
-            newSubGraph = true;
-            allSupported = false;
-        }
+        supported[node_idx] = registered && !containsInput && !containsIndex;
+        allSupported &= supported[node_idx];
+    }
+
+    // Mark all new graphs as "unknown", unless the whole graph is supported.
+    partitionSubGraphs(model.graph(), supported, allSupported, kMIN_SUBGRAPH_COST, sub_graph_collection);
+    return allSupported;
+}
+
+bool analyzeModel(void const* serialized_onnx_model, size_t serialized_onnx_model_size,
+    SubGraphCollection_t& sub_graph_collection, std::vector<Status>& errors)
+{
+    ::ONNX_NAMESPACE::ModelProto model;
+    bool is_serialized_as_text = false;
+    Status status
+        = deserialize_onnx_model(serialized_onnx_model, serialized_onnx_model_size, is_serialized_as_text, &model);
+    if (status.is_error())
+    {
+        errors.push_back(status);
+        return false;
     }
 
-    // Only mark the subgraph as supported if there is one supported subgraph.
-    if (allSupported)
+    ::ONNX_NAMESPACE::GraphProto const& graph = model.graph();
+    std::vector<size_t> topological_order;
+    if (!toposort(graph.node(), &topological_order))
     {
-        sub_graph_collection.back().second = true;
+        errors.push_back(MAKE_ERROR("Failed to sort model topologically", ErrorCode::kINVALID_GRAPH));
+        return false;
     }
+
+    std::vector<bool> supported(graph.node_size());
+    bool allSupported = analyzeGraph(model, topological_order, supported, errors);
+    partitionSubGraphs(graph, supported, true, kMIN_SUBGRAPH_COST, sub_graph_collection);
     return allSupported;
 }
 
@@ -413,7 +625,32 @@ bool ModelImporter::parseWithWeightDescriptors(void const* serialized_onnx_model
         _errors.push_back(status);
         return false;
     }
-    status = this->importModel(model, weight_count, weight_descriptors);
+    return importAndRecordErrors(model, weight_count, weight_descriptors);
+}
+
+bool ModelImporter::parse(void const* serialized_onnx_model, size_t serialized_onnx_model_size)
+{
+    return this->parseWithWeightDescriptors(serialized_onnx_model, serialized_onnx_model_size, 0, nullptr);
+}
+
+bool ModelImporter::parseModelProto(::ONNX_NAMESPACE::ModelProto const& model)
+{
+    _current_node = -1;
+    return importAndRecordErrors(model, 0, nullptr);
+}
+
+bool ModelImporter::parseModelProto(::ONNX_NAMESPACE::ModelProto&& model)
+{
+    _current_node = -1;
+    // Note: Moving the model into our list transfers ownership of the weight arrays without copying them.
+    _onnx_models.emplace_back(std::move(model));
+    return importAndRecordErrors(_onnx_models.back(), 0, nullptr);
+}
+
+bool ModelImporter::importAndRecordErrors(::ONNX_NAMESPACE::ModelProto const& model, uint32_t weight_count,
+    onnxTensorDescriptorV1 const* weight_descriptors)
+{
+    Status status = this->importModel(model, weight_count, weight_descriptors);
     if (status.is_error())
     {
         status.setNode(_current_node);
@@ -423,9 +660,21 @@ bool ModelImporter::parseWithWeightDescriptors(void const* serialized_onnx_model
     return true;
 }
 
-bool ModelImporter::parse(void const* serialized_onnx_model, size_t serialized_onnx_model_size)
+void ModelImporter::reset()
 {
-    return this->parseWithWeightDescriptors(serialized_onnx_model, serialized_onnx_model_size, 0, nullptr);
+    // Note: The context must be reset first, since its tensors may reference weights owned by the stored models.
+    _importer_ctx.reset(_importer_ctx.network());
+    _onnx_models.clear();
+    _errors.clear();
+    _current_node = -1;
+}
+
+bool ModelImporter::parseNext(
+    nvinfer1::INetworkDefinition& network, void const* serialized_onnx_model, size_t serialized_onnx_model_size)
+{
+    reset();
+    _importer_ctx.reset(&network);
+    return this->parse(serialized_onnx_model, serialized_onnx_model_size);
 }
 
 void removeShapeTensorCasts(IImporterContext* ctx)
@@ -459,7 +708,7 @@ Status ModelImporter::importModel(
     auto* ctx = &_importer_ctx;
     _importer_ctx.clearOpsets();
     // Initialize plugin registry
-    initLibNvInferPlugins(static_cast<void*>(&ctx->logger()), "ONNXTRT_NAMESPACE");
+    initPluginLibrary();
     for (int i = 0; i < model.opset_import().size(); ++i)
     {
         std::string domain = model.opset_import(i).domain();
@@ -482,6 +731,8 @@ Status ModelImporter::importModel(
         _importer_ctx.registerTensor(TensorOrWeights{}, output.name());
     }
 
+    countTensorConsumers(graph, _importer_ctx.tensorConsumerCounts(), _importer_ctx.tensorConsumers());
+
     _current_node = -1;
     TRT_CHECK(importInputs(&_importer_ctx, graph, &_importer_ctx.tensors(), weight_count, weight_descriptors));
     TRT_CHECK(parseGraph(&_importer_ctx, graph, model.producer_name() == "TensorRT", &_current_node));
@@ -627,49 +878,40 @@ bool ModelImporter::parseFromFile(const char* onnxModelFile, int verbosity)
         cout << "----------------------------------------------------------------" << endl;
     }
 
-    { //...Read input file, parse it
-        std::ifstream onnx_file(onnxModelFile, std::ios::binary | std::ios::ate);
-        std::streamsize file_size = onnx_file.tellg();
-        onnx_file.seekg(0, std::ios::beg);
-        std::vector<char> onnx_buf(file_size);
-        if (!onnx_file.read(onnx_buf.data(), onnx_buf.size()))
-        {
-            cerr << "ERROR: Failed to read from file " << onnxModelFile << endl;
-            return false;
-        }
-        if (!parse(onnx_buf.data(), onnx_buf.size()))
+    // The parser takes over the model, along with its weights, rather than re-reading and deserializing the file.
+    if (!parseModelProto(std::move(onnx_model)))
+    {
+        ::ONNX_NAMESPACE::ModelProto const& parsed_model = _onnx_models.back();
+        int nerror = getNbErrors();
+        for (int i = 0; i < nerror; ++i)
         {
-            int nerror = getNbErrors();
-            for (int i = 0; i < nerror; ++i)
+            nvonnxparser::IParserError const* error = getError(i);
+            if (error->node() != -1)
             {
-                nvonnxparser::IParserError const* error = getError(i);
-                if (error->node() != -1)
+                ::ONNX_NAMESPACE::NodeProto const& node = parsed_model.graph().node(error->node());
+                cerr << "While parsing node number " << error->node() << " [" << node.op_type();
+                if (node.output().size() && verbosity >= (int) nvinfer1::ILogger::Severity::kVERBOSE)
                 {
-                    ::ONNX_NAMESPACE::NodeProto const& node = onnx_model.graph().node(error->node());
-                    cerr << "While parsing node number " << error->node() << " [" << node.op_type();
-                    if (node.output().size() && verbosity >= (int) nvinfer1::ILogger::Severity::kVERBOSE)
-                    {
-                        cerr << " -> \"" << node.output(0) << "\"";
-                    }
-                    cerr << "]:" << endl;
-                    if (verbosity >= (int) nvinfer1::ILogger::Severity::kVERBOSE)
-                    {
-                        cout << "--- Begin node ---" << endl;
-                        cout << node << endl;
-                        cout << "--- End node ---" << endl;
-                    }
+                    cerr << " -> \"" << node.output(0) << "\"";
+                }
+                cerr << "]:" << endl;
+                if (verbosity >= (int) nvinfer1::ILogger::Severity::kVERBOSE)
+                {
+                    cout << "--- Begin node ---" << endl;
+                    cout << node << endl;
+                    cout << "--- End node ---" << endl;
                 }
-                cerr << "ERROR: " << error->file() << ":" << error->line() << " In function " << error->func() << ":\n"
-                     << "[" << static_cast<int>(error->code()) << "] " << error->desc() << endl;
             }
-            return false;
+            cerr << "ERROR: " << error->file() << ":" << error->line() << " In function " << error->func() << ":\n"
+                 << "[" << static_cast<int>(error->code()) << "] " << error->desc() << endl;
         }
+        return false;
+    }
 
-        if (verbosity >= (int) nvinfer1::ILogger::Severity::kVERBOSE)
-        {
-            cout << " ----- Parsing of ONNX model " << onnxModelFile << " is Done ---- " << endl;
-        }
-    } //...End Reading input file, parsing it
+    if (verbosity >= (int) nvinfer1::ILogger::Severity::kVERBOSE)
+    {
+        cout << " ----- Parsing of ONNX model " << onnxModelFile << " is Done ---- " << endl;
+    }
     return true;
 }
 
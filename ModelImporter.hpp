@@ -25,6 +25,7 @@
 #include "ImporterContext.hpp"
 #include "NvInferPlugin.h"
 #include "NvOnnxParser.h"
+#include "builtin_op_checkers.hpp"
 #include "builtin_op_importers.hpp"
 #include "onnx_utils.hpp"
 #include "utils.hpp"
@@ -35,6 +36,11 @@ namespace onnx2trt
 Status parseGraph(IImporterContext* ctx, const ::ONNX_NAMESPACE::GraphProto& graph, bool deserializingINetwork = false,
     int* currentNode = nullptr);
 
+// Checks the nodes of a serialized model against the importer and checker registries, without building any layers.
+// Unsupported nodes and errors are appended to errors.
+bool analyzeModel(void const* serialized_onnx_model, size_t serialized_onnx_model_size,
+    SubGraphCollection_t& sub_graph_collection, std::vector<Status>& errors);
+
 class ModelImporter : public nvonnxparser::IParser
 {
 protected:
@@ -48,15 +54,24 @@ private:
     int _current_node;
     std::vector<Status> _errors;
 
+    // Imports a deserialized model, recording any error. The model must outlive the network.
+    bool importAndRecordErrors(::ONNX_NAMESPACE::ModelProto const& model, uint32_t weight_count,
+        onnxTensorDescriptorV1 const* weight_descriptors);
+
 public:
     ModelImporter(nvinfer1::INetworkDefinition* network, nvinfer1::ILogger* logger)
         : _op_importers(getBuiltinOpImporterMap())
         , _importer_ctx(network, logger)
+        , _current_node(-1)
     {
     }
     bool parseWithWeightDescriptors(void const* serialized_onnx_model, size_t serialized_onnx_model_size,
         uint32_t weight_count, onnxTensorDescriptorV1 const* weight_descriptors) override;
     bool parse(void const* serialized_onnx_model, size_t serialized_onnx_model_size) override;
+    // Back nvonnxparser::parseModelProto(), which is not part of IParser so that its layout does not depend on
+    // ONNX_NAMESPACE.
+    bool parseModelProto(::ONNX_NAMESPACE::ModelProto const& model);
+    bool parseModelProto(::ONNX_NAMESPACE::ModelProto&& model);
     bool supportsModel(void const* serialized_onnx_model, size_t serialized_onnx_model_size,
         SubGraphCollection_t& sub_graph_collection) override;
 
@@ -86,6 +101,13 @@ public:
     {
         _errors.clear();
     }
+    void reset() override;
+    bool parseNext(nvinfer1::INetworkDefinition& network, void const* serialized_onnx_model,
+        size_t serialized_onnx_model_size) override;
+    void setMaxLoopScanOutputLength(int32_t length) override
+    {
+        _importer_ctx.setMaxLoopScanOutputLength(length);
+    }
 
     //...LG: Move the implementation to .cpp
     bool parseFromFile(const char* onnxModelFile, int verbosity) override;
@@ -34,3 +34,36 @@ extern "C" int getNvOnnxParserVersion()
 {
     return NV_ONNX_PARSER_VERSION;
 }
+
+extern "C" bool analyzeNvOnnxModel_INTERNAL(void const* serialized_onnx_model, size_t serialized_onnx_model_size,
+    void* sub_graph_collection_, void* unsupported_nodes_, int version)
+{
+    auto sub_graph_collection = static_cast<SubGraphCollection_t*>(sub_graph_collection_);
+    auto unsupported_nodes = static_cast<std::vector<nvonnxparser::UnsupportedNode>*>(unsupported_nodes_);
+    std::vector<onnx2trt::Status> errors;
+    bool supported
+        = onnx2trt::analyzeModel(serialized_onnx_model, serialized_onnx_model_size, *sub_graph_collection, errors);
+    if (unsupported_nodes)
+    {
+        for (auto const& error : errors)
+        {
+            unsupported_nodes->push_back({error.node(), error.code(), error.desc()});
+        }
+    }
+    return supported;
+}
+
+extern "C" bool parseNvOnnxModelProto_INTERNAL(void* parser_, void* model_, bool take_ownership, int version)
+{
+    auto importer = dynamic_cast<onnx2trt::ModelImporter*>(static_cast<nvonnxparser::IParser*>(parser_));
+    if (!importer)
+    {
+        return false;
+    }
+    auto model = static_cast<::ONNX_NAMESPACE::ModelProto*>(model_);
+    if (take_ownership)
+    {
+        return importer->parseModelProto(std::move(*model));
+    }
+    return importer->parseModelProto(static_cast<::ONNX_NAMESPACE::ModelProto const&>(*model));
+}
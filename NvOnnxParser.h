@@ -25,6 +25,7 @@
 
 #include "NvInfer.h"
 #include <stddef.h>
+#include <string>
 #include <vector>
 
 #define NV_ONNX_PARSER_MAJOR 0
@@ -48,6 +49,14 @@ typedef std::pair<std::vector<size_t>, bool> SubGraph_t;
 typedef std::vector<SubGraph_t> SubGraphCollection_t;
 
 class onnxTensorDescriptorV1;
+
+#ifdef ONNX_NAMESPACE
+namespace ONNX_NAMESPACE
+{
+class ModelProto;
+}
+#endif // ONNX_NAMESPACE
+
 //!
 //! \namespace nvonnxparser
 //!
@@ -111,9 +120,31 @@ protected:
     virtual ~IParserError() {}
 };
 
+/** \struct UnsupportedNode
+ *
+ * \brief a node that analyzeModel() found TensorRT cannot import
+ */
+struct UnsupportedNode
+{
+    /** \brief index of the ONNX model node, or -1 if the model as a whole
+     *         could not be analyzed
+     */
+    int node;
+    /** \brief the error code
+     */
+    ErrorCode code;
+    /** \brief the precondition of the importer that the node violates
+     */
+    std::string desc;
+};
+
 /** \class IParser
  *
  * \brief an object for parsing ONNX models into a TensorRT network definition
+ *
+ * A single parser must not be used from multiple threads at once, but
+ * independent parsers (each writing to its own network) may parse models
+ * concurrently, provided that the logger they share is thread-safe.
  */
 class IParser
 {
@@ -146,6 +177,11 @@ public:
     virtual bool parseFromFile(const char* onnxModelFile, int verbosity) = 0;
 
     /** \brief Check whether TensorRT supports a particular ONNX model
+     *
+     * If only part of the model is supported, the supported nodes are grouped
+     * into as few subgraphs as possible without making any subgraph depend on
+     * its own outputs. Subgraphs that are too cheap to be worth offloading are
+     * left out of the collection.
      *
      * \param serialized_onnx_model Pointer to the serialized ONNX model
      * \param serialized_onnx_model_size Size of the serialized ONNX model
@@ -203,6 +239,51 @@ public:
      * \see getNbErrors() getError() IParserError
      */
     virtual void clearErrors() = 0;
+    /** \brief Release all state held from prior calls to \p parse
+     *
+     * Frees the parser's copies of previously parsed models (including the
+     * weights they own), all temporary weights created during import and all
+     * recorded errors. The networks populated by prior calls to \p parse
+     * reference these weights, so this must only be called once they are no
+     * longer needed (e.g. after the engine has been built).
+     *
+     * \see parseNext()
+     */
+    virtual void reset() = 0;
+    /** \brief Reset the parser and parse a serialized ONNX model into a new network
+     *
+     * Equivalent to calling reset(), retargeting the parser at \p network and
+     * then calling parse(). This allows a single parser to convert many models
+     * back to back.
+     *
+     * \param network The network definition that the parser will write to
+     * \param serialized_onnx_model Pointer to the serialized ONNX model
+     * \param serialized_onnx_model_size Size of the serialized ONNX model
+     *        in bytes
+     * \return true if the model was parsed successfully
+     * \see reset() getNbErrors() getError()
+     */
+    virtual bool parseNext(nvinfer1::INetworkDefinition& network,
+                           void const* serialized_onnx_model,
+                           size_t serialized_onnx_model_size)
+        = 0;
+    /** \brief Set the length of Loop scan outputs when the number of
+     *         iterations has no known bound
+     *
+     * Scan outputs of a Loop are written to buffers whose length must be
+     * known before the loop runs. That length is the trip count, or N + 1 if
+     * the loop condition is (iteration_num < N), since the body computes the
+     * condition of the next iteration. Loops with neither, which only
+     * stop on their condition, get buffers of this length, and must not run
+     * more iterations than that. Scan outputs are always trimmed to the
+     * number of iterations actually run.
+     *
+     * This is a parser option, so it is not cleared by reset().
+     *
+     * \param length The maximum number of iterations, or 0 for the default
+     *        of 1024
+     */
+    virtual void setMaxLoopScanOutputLength(int32_t length) = 0;
 
 protected:
     virtual ~IParser() {}
@@ -212,6 +293,9 @@ protected:
 
 extern "C" TENSORRTAPI void* createNvOnnxParser_INTERNAL(void* network, void* logger, int version);
 extern "C" TENSORRTAPI int getNvOnnxParserVersion();
+extern "C" TENSORRTAPI bool analyzeNvOnnxModel_INTERNAL(void const* serialized_onnx_model,
+    size_t serialized_onnx_model_size, void* sub_graph_collection, void* unsupported_nodes, int version);
+extern "C" TENSORRTAPI bool parseNvOnnxModelProto_INTERNAL(void* parser, void* model, bool take_ownership, int version);
 
 namespace nvonnxparser
 {
@@ -247,6 +331,78 @@ inline IParser* createParser(nvinfer1::INetworkDefinition& network,
         createNvOnnxParser_INTERNAL(&network, &logger, NV_ONNX_PARSER_VERSION));
 }
 
+/** \brief Check which nodes of an ONNX model TensorRT supports, without
+ *         building any TensorRT layers
+ *
+ * Every node is checked against the static preconditions of its importer
+ * (weight vs. tensor inputs, data types, opset and attribute values).
+ * Unlike IParser::supportsModel(), this needs no parser, network or builder,
+ * and so does not require a GPU.
+ *
+ * Note that, as with IParser::supportsOperator(), a node passing these
+ * checks may still fail to import due to conditions only known while
+ * building the network (e.g. shape-dependent restrictions).
+ *
+ * \param serialized_onnx_model Pointer to the serialized ONNX model
+ * \param serialized_onnx_model_size Size of the serialized ONNX model
+ *        in bytes
+ * \param sub_graph_collection Container to hold the supported subgraphs,
+ *        partitioned as in IParser::supportsModel()
+ * \param unsupported_nodes If not null, receives every unsupported node
+ *        and the reason it is unsupported
+ * \return true if every node of the model is supported
+ */
+inline bool analyzeModel(void const* serialized_onnx_model,
+                         size_t serialized_onnx_model_size,
+                         SubGraphCollection_t& sub_graph_collection,
+                         std::vector<UnsupportedNode>* unsupported_nodes = nullptr)
+{
+    return analyzeNvOnnxModel_INTERNAL(serialized_onnx_model, serialized_onnx_model_size,
+        &sub_graph_collection, unsupported_nodes, NV_ONNX_PARSER_VERSION);
+}
+
+#ifdef ONNX_NAMESPACE
+/** \brief Parse an in-memory ONNX model into the network of a parser
+ *
+ * Imports \p model directly, avoiding the serialize/deserialize round trip
+ * of IParser::parse(). No copy of the model is made: the network references
+ * the weights stored in \p model, so it must outlive any use of the network
+ * (e.g. until the engine has been built).
+ *
+ * These are free functions rather than IParser methods, so that IParser is
+ * the same class whether or not ONNX_NAMESPACE is defined. They are only
+ * available to code built against the same ONNX protobuf definitions (and
+ * ONNX_NAMESPACE) as the parser.
+ *
+ * \param parser A parser created by createParser()
+ * \param model The ONNX model
+ * \return true if the model was parsed successfully
+ * \see IParser::getNbErrors() IParser::getError()
+ */
+inline bool parseModelProto(IParser& parser, ::ONNX_NAMESPACE::ModelProto const& model)
+{
+    return parseNvOnnxModelProto_INTERNAL(
+        &parser, const_cast<::ONNX_NAMESPACE::ModelProto*>(&model), false, NV_ONNX_PARSER_VERSION);
+}
+
+/** \brief Parse an in-memory ONNX model into the network of a parser,
+ *         taking ownership of it
+ *
+ * As above, except that the parser takes over the contents of \p model
+ * (including its weight storage) without copying them, and keeps them
+ * until IParser::reset() or IParser::destroy() is called.
+ *
+ * \param parser A parser created by createParser()
+ * \param model The ONNX model, left empty on return
+ * \return true if the model was parsed successfully
+ * \see IParser::getNbErrors() IParser::getError()
+ */
+inline bool parseModelProto(IParser& parser, ::ONNX_NAMESPACE::ModelProto&& model)
+{
+    return parseNvOnnxModelProto_INTERNAL(&parser, &model, true, NV_ONNX_PARSER_VERSION);
+}
+#endif // ONNX_NAMESPACE
+
 } // namespace
 
 } // namespace nvonnxparser
@@ -100,40 +100,85 @@ void transpose2DWeights(ShapedWeights const& weights, nvinfer1::Dims const& new_
     }
 }
 
+// Permutes weights of any rank and data type, copying one element of elementSize bytes at a time.
+void transposeNDWeights(ShapedWeights const& weights, nvinfer1::Permutation const& perm, size_t elementSize,
+    ShapedWeights* result)
+{
+    const int nbDims = weights.shape.nbDims;
+    // Strides of the source weights, in elements, reordered to follow the dimensions of the result.
+    int64_t srcStrides[nvinfer1::Dims::MAX_DIMS];
+    int64_t stride = 1;
+    for (int d = nbDims - 1; d >= 0; --d)
+    {
+        srcStrides[d] = stride;
+        stride *= weights.shape.d[d];
+    }
+    int64_t permutedStrides[nvinfer1::Dims::MAX_DIMS];
+    for (int d = 0; d < nbDims; ++d)
+    {
+        permutedStrides[d] = srcStrides[perm.order[d]];
+    }
+
+    uint8_t const* src = static_cast<uint8_t const*>(weights.values);
+    uint8_t* dst = static_cast<uint8_t*>(result->values);
+    const size_t count = weights.count();
+    int64_t index[nvinfer1::Dims::MAX_DIMS] = {};
+    int64_t srcOffset = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::memcpy(dst + i * elementSize, src + srcOffset * elementSize, elementSize);
+        // Advance the index into the result, like an odometer, keeping the source offset in step.
+        for (int d = nbDims - 1; d >= 0; --d)
+        {
+            srcOffset += permutedStrides[d];
+            if (++index[d] < result->shape.d[d])
+            {
+                break;
+            }
+            srcOffset -= index[d] * permutedStrides[d];
+            index[d] = 0;
+        }
+    }
+}
+
 bool transposeWeights(ShapedWeights const& weights, nvinfer1::Permutation const& perm, ShapedWeights* result)
 {
     nvinfer1::Dims shape = weights.shape;
     nvinfer1::Dims new_shape;
     new_shape.nbDims = shape.nbDims;
+    bool seen[nvinfer1::Dims::MAX_DIMS] = {};
     for (int d = 0; d < shape.nbDims; ++d)
     {
+        if (perm.order[d] < 0 || perm.order[d] >= shape.nbDims || seen[perm.order[d]])
+        {
+            return false;
+        }
+        seen[perm.order[d]] = true;
         new_shape.d[d] = shape.d[perm.order[d]];
         result->shape.d[d] = new_shape.d[d];
     }
-    // TODO: Need to generalize this transpose implementation
-    assert(perm.order[0] == 1 && perm.order[1] == 0);
 
-    if (shape.nbDims == 2)
+    if (shape.nbDims == 2 && perm.order[0] == 1 && perm.order[1] == 0)
     {
         if (weights.type == ::ONNX_NAMESPACE::TensorProto::FLOAT)
         {
             transpose2DWeights<float>(weights, new_shape, result);
+            return true;
         }
         else if (weights.type == ::ONNX_NAMESPACE::TensorProto::FLOAT16)
         {
             transpose2DWeights<uint16_t>(weights, new_shape, result);
-        }
-        else
-        {
-            return false;
+            return true;
         }
     }
-    else
+
+    const int elementSize = getDtypeSize(weights.type);
+    if (elementSize <= 0)
     {
-        // TODO: Implement general transposes and multiple data types
-        // Unsupported weights transpose
+        // Unsupported weights type
         return false;
     }
+    transposeNDWeights(weights, perm, elementSize, result);
     return true;
 }
 
@@ -0,0 +1,355 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SubGraphPartitioner.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace onnx2trt
+{
+
+namespace
+{
+
+constexpr int64_t kFREE_OP_COST = 0;
+constexpr int64_t kLIGHT_OP_COST = 1;
+constexpr int64_t kMEDIUM_OP_COST = 10;
+constexpr int64_t kHEAVY_OP_COST = 100;
+
+void collectInputNames(::ONNX_NAMESPACE::GraphProto const& graph, std::unordered_set<std::string>& names);
+
+// Collects the names of all values read by a node, including those read by its subgraphs.
+void collectInputNames(::ONNX_NAMESPACE::NodeProto const& node, std::unordered_set<std::string>& names)
+{
+    for (auto const& input : node.input())
+    {
+        names.insert(input);
+    }
+    for (auto const& attr : node.attribute())
+    {
+        if (attr.has_g())
+        {
+            collectInputNames(attr.g(), names);
+        }
+        for (auto const& subgraph : attr.graphs())
+        {
+            collectInputNames(subgraph, names);
+        }
+    }
+}
+
+void collectInputNames(::ONNX_NAMESPACE::GraphProto const& graph, std::unordered_set<std::string>& names)
+{
+    for (auto const& node : graph.node())
+    {
+        collectInputNames(node, names);
+    }
+}
+
+// Supported nodes are grouped into regions using a union-find forest over node indices. Unsupported nodes remain
+// singletons. The graph contracted by region is kept acyclic: two regions are only merged when there is no path
+// between them that passes through a node outside of both.
+class SubGraphPartitioner
+{
+public:
+    SubGraphPartitioner(::ONNX_NAMESPACE::GraphProto const& graph, std::vector<bool> const& supported)
+        : mGraph(graph)
+        , mSupported(supported)
+        , mNbNodes(graph.node_size())
+        , mProducers(mNbNodes)
+        , mConsumers(mNbNodes)
+        , mTopoPos(mNbNodes)
+        , mParent(mNbNodes)
+        , mMembers(mNbNodes)
+        , mMinPos(mNbNodes)
+        , mMaxPos(mNbNodes)
+    {
+    }
+
+    bool partition(bool markSupported, int64_t minCost, SubGraphCollection_t& sub_graph_collection)
+    {
+        if (!buildDependencies())
+        {
+            return false;
+        }
+        for (size_t node = 0; node < mNbNodes; ++node)
+        {
+            mParent[node] = node;
+            mMembers[node] = {node};
+            mMinPos[node] = mTopoPos[node];
+            mMaxPos[node] = mTopoPos[node];
+        }
+
+        // Grow regions along dependencies first, so that producers and consumers end up together.
+        for (size_t node : mOrder)
+        {
+            if (!mSupported[node])
+            {
+                continue;
+            }
+            for (size_t producer : mProducers[node])
+            {
+                if (mSupported[producer])
+                {
+                    tryMerge(findRegion(producer), findRegion(node));
+                }
+            }
+        }
+
+        // Then merge regions that are independent of one another, or only connected through each other.
+        std::vector<size_t> regions = supportedRegions();
+        for (size_t i = 0; i < regions.size(); ++i)
+        {
+            for (size_t j = i + 1; j < regions.size(); ++j)
+            {
+                size_t first = findRegion(regions[i]);
+                size_t second = findRegion(regions[j]);
+                if (first != second)
+                {
+                    tryMerge(first, second);
+                }
+            }
+        }
+
+        // A subgraph covering the whole graph is always kept, however cheap.
+        regions = supportedRegions();
+        bool wholeGraph = regions.size() == 1 && mMembers[regions.front()].size() == mNbNodes;
+        for (size_t region : regions)
+        {
+            std::vector<size_t>& members = mMembers[region];
+            if (!wholeGraph && regionCost(members) < minCost)
+            {
+                continue;
+            }
+            std::sort(
+                members.begin(), members.end(), [this](size_t a, size_t b) { return mTopoPos[a] < mTopoPos[b]; });
+            sub_graph_collection.emplace_back(members, markSupported);
+        }
+        return true;
+    }
+
+private:
+    // Builds the node-level dependency graph and orders it topologically. Returns false on a cycle.
+    bool buildDependencies()
+    {
+        std::unordered_map<std::string, size_t> producerOf;
+        for (size_t node = 0; node < mNbNodes; ++node)
+        {
+            for (auto const& output : mGraph.node(node).output())
+            {
+                producerOf[output] = node;
+            }
+        }
+        for (size_t node = 0; node < mNbNodes; ++node)
+        {
+            std::unordered_set<std::string> inputs;
+            collectInputNames(mGraph.node(node), inputs);
+            std::unordered_set<size_t> producers;
+            for (auto const& input : inputs)
+            {
+                auto it = producerOf.find(input);
+                if (it != producerOf.end() && it->second != node && producers.insert(it->second).second)
+                {
+                    mProducers[node].push_back(it->second);
+                    mConsumers[it->second].push_back(node);
+                }
+            }
+        }
+
+        // Kahn's algorithm, taking ready nodes in graph order to keep the result close to the original order.
+        std::vector<size_t> pending(mNbNodes);
+        std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ready;
+        for (size_t node = 0; node < mNbNodes; ++node)
+        {
+            pending[node] = mProducers[node].size();
+            if (pending[node] == 0)
+            {
+                ready.push(node);
+            }
+        }
+        while (!ready.empty())
+        {
+            size_t node = ready.top();
+            ready.pop();
+            mTopoPos[node] = mOrder.size();
+            mOrder.push_back(node);
+            for (size_t consumer : mConsumers[node])
+            {
+                if (--pending[consumer] == 0)
+                {
+                    ready.push(consumer);
+                }
+            }
+        }
+        return mOrder.size() == mNbNodes;
+    }
+
+    size_t findRegion(size_t node)
+    {
+        while (mParent[node] != node)
+        {
+            mParent[node] = mParent[mParent[node]];
+            node = mParent[node];
+        }
+        return node;
+    }
+
+    // Returns true if a path leaves region `from` and reaches region `to` through at least one node outside of both.
+    // Since edges only point forward in topological order, nodes positioned after the last node of `to` are pruned.
+    bool reachesIndirectly(size_t from, size_t to)
+    {
+        std::vector<size_t> stack;
+        std::unordered_set<size_t> visited;
+        auto visitConsumers = [&](size_t node, bool outside) {
+            for (size_t consumer : mConsumers[node])
+            {
+                size_t region = findRegion(consumer);
+                if (region == to)
+                {
+                    if (outside)
+                    {
+                        return true;
+                    }
+                    continue;
+                }
+                if (region != from && mTopoPos[consumer] < mMaxPos[to] && visited.insert(consumer).second)
+                {
+                    stack.push_back(consumer);
+                }
+            }
+            return false;
+        };
+        for (size_t node : mMembers[from])
+        {
+            visitConsumers(node, false);
+        }
+        while (!stack.empty())
+        {
+            size_t node = stack.back();
+            stack.pop_back();
+            if (visitConsumers(node, true))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void tryMerge(size_t first, size_t second)
+    {
+        if (first == second || reachesIndirectly(first, second) || reachesIndirectly(second, first))
+        {
+            return;
+        }
+        if (mMembers[first].size() < mMembers[second].size())
+        {
+            std::swap(first, second);
+        }
+        mParent[second] = first;
+        mMembers[first].insert(mMembers[first].end(), mMembers[second].begin(), mMembers[second].end());
+        mMembers[second].clear();
+        mMinPos[first] = std::min(mMinPos[first], mMinPos[second]);
+        mMaxPos[first] = std::max(mMaxPos[first], mMaxPos[second]);
+    }
+
+    // Returns the roots of all regions of supported nodes, ordered by their first node.
+    std::vector<size_t> supportedRegions()
+    {
+        std::vector<size_t> regions;
+        for (size_t node : mOrder)
+        {
+            if (mSupported[node] && findRegion(node) == node)
+            {
+                regions.push_back(node);
+            }
+        }
+        std::sort(regions.begin(), regions.end(), [this](size_t a, size_t b) { return mMinPos[a] < mMinPos[b]; });
+        return regions;
+    }
+
+    int64_t regionCost(std::vector<size_t> const& members) const
+    {
+        int64_t cost = 0;
+        for (size_t node : members)
+        {
+            cost += estimateNodeCost(mGraph.node(node));
+        }
+        return cost;
+    }
+
+    ::ONNX_NAMESPACE::GraphProto const& mGraph;
+    std::vector<bool> const& mSupported;
+    size_t mNbNodes;
+    std::vector<std::vector<size_t>> mProducers;
+    std::vector<std::vector<size_t>> mConsumers;
+    std::vector<size_t> mOrder;   // Nodes in topological order.
+    std::vector<size_t> mTopoPos; // Position of each node in mOrder.
+    std::vector<size_t> mParent;
+    std::vector<std::vector<size_t>> mMembers; // Nodes of each region, valid for region roots only.
+    std::vector<size_t> mMinPos;               // Topological extent of each region, valid for region roots only.
+    std::vector<size_t> mMaxPos;
+};
+
+} // anonymous namespace
+
+int64_t estimateNodeCost(::ONNX_NAMESPACE::NodeProto const& node)
+{
+    static const std::unordered_set<std::string> freeOps{"Constant", "ConstantOfShape", "Dropout", "Flatten",
+        "Identity", "Reshape", "Shape", "Size", "Squeeze", "Unsqueeze"};
+    static const std::unordered_set<std::string> mediumOps{"ArgMax", "ArgMin", "AveragePool", "BatchNormalization",
+        "CumSum", "GlobalAveragePool", "GlobalLpPool", "GlobalMaxPool", "Hardmax", "If", "InstanceNormalization",
+        "LogSoftmax", "Loop", "LpNormalization", "LpPool", "LRN", "MaxPool", "ReduceL1", "ReduceL2",
+        "ReduceLogSum", "ReduceLogSumExp", "ReduceMax", "ReduceMean", "ReduceMin", "ReduceProd", "ReduceSum",
+        "ReduceSumSquare", "Resize", "Scan", "Softmax", "TopK", "Upsample"};
+    static const std::unordered_set<std::string> heavyOps{"Conv", "ConvTranspose", "Einsum", "Gemm", "GRU", "LSTM",
+        "MatMul", "MatMulInteger", "QLinearConv", "QLinearMatMul", "RNN"};
+
+    const std::string& op = node.op_type();
+    int64_t cost = freeOps.count(op) ? kFREE_OP_COST
+        : mediumOps.count(op)        ? kMEDIUM_OP_COST
+        : heavyOps.count(op)         ? kHEAVY_OP_COST
+                                     : kLIGHT_OP_COST;
+    for (auto const& attr : node.attribute())
+    {
+        if (attr.has_g())
+        {
+            for (auto const& bodyNode : attr.g().node())
+            {
+                cost += estimateNodeCost(bodyNode);
+            }
+        }
+    }
+    return cost;
+}
+
+bool partitionSubGraphs(::ONNX_NAMESPACE::GraphProto const& graph, std::vector<bool> const& supported,
+    bool markSupported, int64_t minCost, SubGraphCollection_t& sub_graph_collection)
+{
+    SubGraphPartitioner partitioner(graph, supported);
+    return partitioner.partition(markSupported, minCost, sub_graph_collection);
+}
+
+} // namespace onnx2trt
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2020, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "NvOnnxParser.h"
+
+#include <cstdint>
+#include <onnx/onnx_pb.h>
+#include <vector>
+
+namespace onnx2trt
+{
+
+// Partial subgraphs whose estimated cost is below this are left to the host framework, since the cost of moving
+// their inputs and outputs across the device boundary outweighs running them in TensorRT. One unit is roughly the
+// cost of an elementwise op.
+constexpr int64_t kMIN_SUBGRAPH_COST = 10;
+
+// Returns a rough relative compute cost of a node, based on its op type. Nodes with subgraphs (Loop, If, Scan)
+// include the cost of their bodies.
+int64_t estimateNodeCost(::ONNX_NAMESPACE::NodeProto const& node);
+
+// Groups the supported nodes of a graph into subgraphs that can each be offloaded as one TensorRT network.
+//
+// Supported nodes connected by a dependency are grown into regions, and regions are then merged (whether or not
+// they are connected) as long as no path leaves one region and re-enters the other, which would make the merged
+// subgraph depend on its own output. Subgraphs that do not cover the whole graph and cost less than minCost in
+// total are dropped. Nodes within each subgraph, and the subgraphs themselves, are in topological order.
+//
+// Dependencies through the implicit inputs of nested subgraphs (e.g. a Loop body reading an outer value) are
+// taken into account. Returns false, leaving sub_graph_collection untouched, if the graph contains a cycle.
+bool partitionSubGraphs(::ONNX_NAMESPACE::GraphProto const& graph, std::vector<bool> const& supported,
+    bool markSupported, int64_t minCost, SubGraphCollection_t& sub_graph_collection);
+
+} // namespace onnx2trt
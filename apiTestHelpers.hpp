@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+// Model builders and engine runners shared by the API tests, which generate their models in-process.
+
+#include <NvInfer.h>
+#include <onnx/onnx_pb.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <unistd.h> // For ::getopt
+#include <utility>
+#include <vector>
+#ifdef API_TEST_WITH_CUDA
+#include <cuda_runtime.h>
+#endif
+#include "NvOnnxParser.h"
+#include "common.hpp"
+
+namespace apitest {
+
+// Returns an empty model that imports the default ONNX domain at the given opset.
+inline ::ONNX_NAMESPACE::ModelProto makeModel(const char* graphName, int64_t opset = 11) {
+  ::ONNX_NAMESPACE::ModelProto model;
+  model.set_ir_version(::ONNX_NAMESPACE::IR_VERSION);
+  model.add_opset_import()->set_version(opset);
+  model.mutable_graph()->set_name(graphName);
+  return model;
+}
+
+// Describes a graph input or output. Dimensions of -1 become symbolic dimensions, which are named after their
+// position so that inputs and outputs of the same shape share them. If dims is null, the shape is left unknown.
+inline void addValueInfo(::ONNX_NAMESPACE::ValueInfoProto* info, const char* name, std::vector<int64_t> const* dims,
+                         int32_t type = ::ONNX_NAMESPACE::TensorProto::FLOAT) {
+  info->set_name(name);
+  auto* tensorType = info->mutable_type()->mutable_tensor_type();
+  tensorType->set_elem_type(type);
+  if (!dims) {
+    return;
+  }
+  auto* shape = tensorType->mutable_shape();
+  for (size_t i = 0; i < dims->size(); ++i) {
+    if ((*dims)[i] < 0) {
+      shape->add_dim()->set_dim_param("d" + std::to_string(i));
+    } else {
+      shape->add_dim()->set_dim_value((*dims)[i]);
+    }
+  }
+}
+
+inline void addInput(::ONNX_NAMESPACE::GraphProto* graph, const char* name, std::vector<int64_t> const& dims,
+                     int32_t type = ::ONNX_NAMESPACE::TensorProto::FLOAT) {
+  addValueInfo(graph->add_input(), name, &dims, type);
+}
+
+// Outputs are declared without a shape unless one is given, leaving it to the importer.
+inline void addOutput(::ONNX_NAMESPACE::GraphProto* graph, const char* name,
+                      std::vector<int64_t> const* dims = nullptr,
+                      int32_t type = ::ONNX_NAMESPACE::TensorProto::FLOAT) {
+  addValueInfo(graph->add_output(), name, dims, type);
+}
+
+// Adds a 1D initializer holding values.
+inline ::ONNX_NAMESPACE::TensorProto* addInitializer(::ONNX_NAMESPACE::GraphProto* graph, const char* name,
+                                                     std::vector<float> const& values) {
+  ::ONNX_NAMESPACE::TensorProto* tensor = graph->add_initializer();
+  tensor->set_name(name);
+  tensor->set_data_type(::ONNX_NAMESPACE::TensorProto::FLOAT);
+  tensor->add_dims(values.size());
+  for (float value : values) {
+    tensor->add_float_data(value);
+  }
+  return tensor;
+}
+
+inline ::ONNX_NAMESPACE::TensorProto* addInitializer(::ONNX_NAMESPACE::GraphProto* graph, const char* name,
+                                                     std::vector<int64_t> const& values) {
+  ::ONNX_NAMESPACE::TensorProto* tensor = graph->add_initializer();
+  tensor->set_name(name);
+  tensor->set_data_type(::ONNX_NAMESPACE::TensorProto::INT64);
+  tensor->add_dims(values.size());
+  for (int64_t value : values) {
+    tensor->add_int64_data(value);
+  }
+  return tensor;
+}
+
+// Adds a scalar initializer, whose value the caller sets.
+inline ::ONNX_NAMESPACE::TensorProto* addScalarInitializer(::ONNX_NAMESPACE::GraphProto* graph, const char* name,
+                                                           ::ONNX_NAMESPACE::TensorProto::DataType type) {
+  ::ONNX_NAMESPACE::TensorProto* tensor = graph->add_initializer();
+  tensor->set_name(name);
+  tensor->set_data_type(type);
+  return tensor;
+}
+
+// Adds a node after the existing ones, so nodes must be added in topological order.
+inline ::ONNX_NAMESPACE::NodeProto* addNode(::ONNX_NAMESPACE::GraphProto* graph, const char* opType,
+                                            std::vector<std::string> const& inputs,
+                                            std::vector<std::string> const& outputs) {
+  ::ONNX_NAMESPACE::NodeProto* node = graph->add_node();
+  node->set_op_type(opType);
+  for (std::string const& input : inputs) {
+    node->add_input(input);
+  }
+  for (std::string const& output : outputs) {
+    node->add_output(output);
+  }
+  return node;
+}
+
+inline ::ONNX_NAMESPACE::AttributeProto* addAttribute(::ONNX_NAMESPACE::NodeProto* node, const char* name,
+                                                      ::ONNX_NAMESPACE::AttributeProto::AttributeType type) {
+  ::ONNX_NAMESPACE::AttributeProto* attribute = node->add_attribute();
+  attribute->set_name(name);
+  attribute->set_type(type);
+  return attribute;
+}
+
+inline void addFloatAttribute(::ONNX_NAMESPACE::NodeProto* node, const char* name, float value) {
+  addAttribute(node, name, ::ONNX_NAMESPACE::AttributeProto::FLOAT)->set_f(value);
+}
+
+inline void addIntAttribute(::ONNX_NAMESPACE::NodeProto* node, const char* name, int64_t value) {
+  addAttribute(node, name, ::ONNX_NAMESPACE::AttributeProto::INT)->set_i(value);
+}
+
+inline void addStringAttribute(::ONNX_NAMESPACE::NodeProto* node, const char* name, const char* value) {
+  addAttribute(node, name, ::ONNX_NAMESPACE::AttributeProto::STRING)->set_s(value);
+}
+
+inline void addGraphAttribute(::ONNX_NAMESPACE::NodeProto* node, const char* name,
+                              ::ONNX_NAMESPACE::GraphProto const& graph) {
+  *addAttribute(node, name, ::ONNX_NAMESPACE::AttributeProto::GRAPH)->mutable_g() = graph;
+}
+
+struct Options {
+  float tolerance = 1e-3f;
+  bool verbose = false;
+};
+
+// Parses the options common to the numerical API tests. Returns false if the program should exit, after -h.
+inline bool parseOptions(int argc, char* argv[], Options& options, void (*print_usage)()) {
+  int c;
+  while ((c = getopt(argc, argv, "t:vh")) != -1) {
+    switch (c) {
+    case 't':
+      options.tolerance = atof(optarg);
+      break;
+    case 'v':
+      options.verbose = true;
+      break;
+    case 'h':
+      print_usage();
+      return false;
+    }
+  }
+  return true;
+}
+
+// Parses model into the parser's network, printing the parser errors on failure. The parser takes ownership of the
+// model, whose weights the network references until the engine is built.
+inline bool parseModel(nvonnxparser::IParser& parser, ::ONNX_NAMESPACE::ModelProto model,
+                       const char* indent = "  ") {
+  if (nvonnxparser::parseModelProto(parser, std::move(model))) {
+    return true;
+  }
+  for (int i = 0; i < parser.getNbErrors(); ++i) {
+    std::cerr << indent << parser.getError(i)->desc() << std::endl;
+  }
+  std::cerr << indent << "FAILED to parse" << std::endl;
+  return false;
+}
+
+// Builds the engine, or returns null (rather than throwing like common::infer_object) if TensorRT cannot.
+inline std::shared_ptr<nvinfer1::ICudaEngine> buildEngine(nvinfer1::IBuilder& builder,
+                                                          nvinfer1::INetworkDefinition& network,
+                                                          nvinfer1::IBuilderConfig& config,
+                                                          const char* indent = "  ") {
+  std::shared_ptr<nvinfer1::ICudaEngine> engine(builder.buildEngineWithConfig(network, config),
+                                                common::InferDeleter());
+  if (!engine) {
+    std::cerr << indent << "FAILED to build" << std::endl;
+  }
+  return engine;
+}
+
+// Adds an optimization profile covering the given dimensions of one input.
+inline void addProfile(nvinfer1::IBuilder& builder, nvinfer1::IBuilderConfig& config, const char* input,
+                       nvinfer1::Dims const& min, nvinfer1::Dims const& opt, nvinfer1::Dims const& max) {
+  nvinfer1::IOptimizationProfile* profile = builder.createOptimizationProfile();
+  profile->setDimensions(input, nvinfer1::OptProfileSelector::kMIN, min);
+  profile->setDimensions(input, nvinfer1::OptProfileSelector::kOPT, opt);
+  profile->setDimensions(input, nvinfer1::OptProfileSelector::kMAX, max);
+  config.addOptimizationProfile(profile);
+}
+
+inline nvinfer1::Dims makeDims(std::vector<int> const& values) {
+  nvinfer1::Dims dims{};
+  dims.nbDims = static_cast<int>(values.size());
+  std::copy(values.begin(), values.end(), dims.d);
+  return dims;
+}
+
+inline size_t volume(nvinfer1::Dims const& dims) {
+  size_t count = 1;
+  for (int i = 0; i < dims.nbDims; ++i) {
+    count *= std::max(dims.d[i], 0);
+  }
+  return count;
+}
+
+inline std::vector<float> randomValues(size_t count, std::mt19937& rng, float low = -4.f, float high = 4.f) {
+  std::uniform_real_distribution<float> distribution(low, high);
+  std::vector<float> values(count);
+  for (float& value : values) {
+    value = distribution(rng);
+  }
+  return values;
+}
+
+inline float maxAbsError(std::vector<float> const& actual, std::vector<float> const& expected) {
+  float maxError = actual.size() == expected.size() ? 0.f : INFINITY;
+  for (size_t i = 0; i < std::min(actual.size(), expected.size()); ++i) {
+    maxError = std::max(maxError, std::abs(actual[i] - expected[i]));
+  }
+  return maxError;
+}
+
+// A tensor in host memory. Values are kept as floats; INT32 bindings are converted on the way in and out.
+struct HostTensor {
+  nvinfer1::Dims dims;
+  std::vector<float> values;
+};
+
+#ifdef API_TEST_WITH_CUDA
+// Runs the engine with the given inputs, bound by name, and fills outputs with every output binding. Returns false if
+// an input is missing, the input dimensions are rejected, or a CUDA call or the execution fails.
+inline bool execute(nvinfer1::IExecutionContext& context, std::map<std::string, HostTensor> const& inputs,
+                    std::map<std::string, HostTensor>& outputs) {
+  nvinfer1::ICudaEngine const& engine = context.getEngine();
+  const int nbBindings = engine.getNbBindings();
+  for (int b = 0; b < nbBindings; ++b) {
+    if (engine.bindingIsInput(b)) {
+      auto input = inputs.find(engine.getBindingName(b));
+      if (input == inputs.end() || !context.setBindingDimensions(b, input->second.dims)) {
+        return false;
+      }
+    }
+  }
+  if (!context.allInputDimensionsSpecified()) {
+    return false;
+  }
+
+  std::vector<void*> bindings(nbBindings, nullptr);
+  bool ok = true;
+  for (int b = 0; ok && b < nbBindings; ++b) {
+    const bool isInt = engine.getBindingDataType(b) == nvinfer1::DataType::kINT32;
+    if (engine.bindingIsInput(b)) {
+      std::vector<float> const& values = inputs.at(engine.getBindingName(b)).values;
+      std::vector<int32_t> intValues(values.begin(), values.end());
+      const void* host = isInt ? static_cast<const void*>(intValues.data()) : values.data();
+      ok = cudaMalloc(&bindings[b], std::max<size_t>(values.size(), 1) * sizeof(float)) == cudaSuccess
+          && cudaMemcpy(bindings[b], host, values.size() * sizeof(float), cudaMemcpyHostToDevice) == cudaSuccess;
+    } else {
+      const nvinfer1::Dims dims = context.getBindingDimensions(b);
+      ok = cudaMalloc(&bindings[b], std::max<size_t>(volume(dims), 1) * sizeof(float)) == cudaSuccess;
+    }
+  }
+  ok = ok && context.executeV2(bindings.data());
+  for (int b = 0; ok && b < nbBindings; ++b) {
+    if (engine.bindingIsInput(b)) {
+      continue;
+    }
+    HostTensor& output = outputs[engine.getBindingName(b)];
+    output.dims = context.getBindingDimensions(b);
+    output.values.resize(volume(output.dims));
+    if (engine.getBindingDataType(b) == nvinfer1::DataType::kINT32) {
+      std::vector<int32_t> intValues(output.values.size());
+      ok = cudaMemcpy(intValues.data(), bindings[b], intValues.size() * sizeof(int32_t), cudaMemcpyDeviceToHost)
+          == cudaSuccess;
+      std::copy(intValues.begin(), intValues.end(), output.values.begin());
+    } else {
+      ok = cudaMemcpy(output.values.data(), bindings[b], output.values.size() * sizeof(float),
+                      cudaMemcpyDeviceToHost) == cudaSuccess;
+    }
+  }
+  for (void* binding : bindings) {
+    cudaFree(binding);
+  }
+  return ok;
+}
+#endif // API_TEST_WITH_CUDA
+
+} // namespace apitest
@@ -0,0 +1,416 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include "builtin_op_checkers.hpp"
+#include "OnnxAttrs.hpp"
+
+#include <algorithm> // For std::equal
+#include <cstring>   // For std::memcpy
+#include <string>
+
+namespace onnx2trt
+{
+
+namespace
+{
+
+string_map<NodeChecker>& getMutableBuiltinOpCheckerMap()
+{
+    static string_map<NodeChecker> builtin_op_checkers;
+    return builtin_op_checkers;
+}
+
+} // namespace
+
+const string_map<NodeChecker>& getBuiltinOpCheckerMap()
+{
+    return getMutableBuiltinOpCheckerMap();
+}
+
+namespace
+{
+
+#define IGNORE_UNUSED_GLOBAL(x)                                                                                        \
+    static void _ignore_unused2_##x();                                                                                 \
+    static void _ignore_unused1_##x()                                                                                  \
+    {                                                                                                                  \
+        (void) _ignore_unused2_##x;                                                                                    \
+        (void) x;                                                                                                      \
+    }                                                                                                                  \
+    static void _ignore_unused2_##x()                                                                                  \
+    {                                                                                                                  \
+        (void) _ignore_unused1_##x;                                                                                    \
+    }                                                                                                                  \
+    struct SwallowSemicolon##x                                                                                         \
+    {                                                                                                                  \
+    }
+
+#define DEFINE_BUILTIN_OP_CHECKER(op)                                                                                  \
+    Status check##op(int64_t opset, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<CheckerInput> const& inputs); \
+    static const bool op##_registered_builtin_op_checker = registerBuiltinOpChecker(#op, check##op);                   \
+    IGNORE_UNUSED_GLOBAL(op##_registered_builtin_op_checker);                                                          \
+    Status check##op(int64_t opset, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<CheckerInput> const& inputs)
+
+bool registerBuiltinOpChecker(std::string op, NodeChecker const& checker)
+{
+    bool inserted = getMutableBuiltinOpCheckerMap().insert({op, checker}).second;
+    assert(inserted);
+    return inserted;
+}
+
+bool isIntType(int32_t dtype)
+{
+    // INT64 values are cast down to INT32 during import.
+    return dtype == ::ONNX_NAMESPACE::TensorProto::INT32 || dtype == ::ONNX_NAMESPACE::TensorProto::INT64;
+}
+
+bool isBoolType(int32_t dtype)
+{
+    return dtype == ::ONNX_NAMESPACE::TensorProto::BOOL;
+}
+
+bool isSet(std::vector<CheckerInput> const& inputs, size_t index)
+{
+    return index < inputs.size() && !inputs.at(index).isNull;
+}
+
+bool isWeights(std::vector<CheckerInput> const& inputs, size_t index)
+{
+    return isSet(inputs, index) && inputs.at(index).isWeights;
+}
+
+int64_t weightsCount(::ONNX_NAMESPACE::TensorProto const& weights)
+{
+    int64_t count = 1;
+    for (auto dim : weights.dims())
+    {
+        count *= dim;
+    }
+    return count;
+}
+
+// Reads the first element of a FLOAT initializer. Returns false if the value could not be read.
+bool readFirstFloat(::ONNX_NAMESPACE::TensorProto const& weights, float* value)
+{
+    if (weights.data_type() != ::ONNX_NAMESPACE::TensorProto::FLOAT)
+    {
+        return false;
+    }
+    if (weights.float_data_size() > 0)
+    {
+        *value = weights.float_data(0);
+        return true;
+    }
+    if (weights.raw_data().size() >= sizeof(float))
+    {
+        std::memcpy(value, weights.raw_data().data(), sizeof(float));
+        return true;
+    }
+    return false;
+}
+
+Status checkRecurrentActivations(::ONNX_NAMESPACE::NodeProto const& node, int numActivations)
+{
+    OnnxAttrs attrs(node, nullptr);
+    if (attrs.get<std::string>("direction", "forward") != "bidirectional")
+    {
+        return Status::success();
+    }
+    // Only explicitly specified activations can differ between the two directions.
+    auto activations = attrs.get<std::vector<std::string>>("activations", {});
+    if (static_cast<int>(activations.size()) == 2 * numActivations)
+    {
+        ASSERT(std::equal(activations.begin(), activations.begin() + numActivations,
+                   activations.begin() + numActivations)
+                && "The parser does not currently support cases where activations for the reverse pass do not match "
+                   "the forward pass.",
+            ErrorCode::kUNSUPPORTED_NODE);
+    }
+    for (const char* key : {"activation_alpha", "activation_beta"})
+    {
+        auto params = attrs.get<std::vector<float>>(key, {});
+        if (static_cast<int>(params.size()) == 2 * numActivations)
+        {
+            ASSERT(std::equal(params.begin(), params.begin() + numActivations, params.begin() + numActivations)
+                    && "The parser does not currently support cases where activations for the reverse pass do not "
+                       "match the forward pass.",
+                ErrorCode::kUNSUPPORTED_NODE);
+        }
+    }
+    return Status::success();
+}
+
+// QuantizeLinear and DequantizeLinear are folded into weights or dynamic ranges where possible, and otherwise imported
+// as scale layers, which need a zero point. Both need constant scales and zero points.
+Status checkQuantization(std::vector<CheckerInput> const& inputs)
+{
+    ASSERT(inputs.size() == 2 || inputs.size() == 3, nvonnxparser::ErrorCode::kINVALID_NODE);
+    ASSERT(isWeights(inputs, 1), nvonnxparser::ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(isWeights(inputs, 2) || (!isSet(inputs, 2) && isWeights(inputs, 0)),
+        nvonnxparser::ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Clip)
+{
+    if (opset >= 11)
+    {
+        ASSERT((!isSet(inputs, 1) || isWeights(inputs, 1)) && "Clip min value must be an initializer!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        ASSERT((!isSet(inputs, 2) || isWeights(inputs, 2)) && "Clip max value must be an initializer!",
+            ErrorCode::kUNSUPPORTED_NODE);
+    }
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Conv)
+{
+    ASSERT(!isWeights(inputs, 0), ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(!isSet(inputs, 2) || isWeights(inputs, 2), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(ConvTranspose)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    ASSERT(inputs.at(0).rank == -1 || inputs.at(0).rank >= 3, ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(isWeights(inputs, 1), ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(!isSet(inputs, 2) || isWeights(inputs, 2), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(DepthToSpace)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    ASSERT(inputs.at(0).rank == -1 || inputs.at(0).rank == 4, ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(!isBoolType(inputs.at(0).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(DequantizeLinear)
+{
+    return checkQuantization(inputs);
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Dropout)
+{
+    // Error if opset version >= 10 as boolean not supported right now
+    ASSERT(node.output().size() == 1 || opset < 10, ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Expand)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    ASSERT(!isBoolType(inputs.at(0).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Gather)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    ASSERT(!isBoolType(inputs.at(0).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Gemm)
+{
+    ASSERT(inputs.size() >= 2, ErrorCode::kINVALID_NODE);
+    ASSERT(!isIntType(inputs.at(0).dtype) && !isIntType(inputs.at(1).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(GRU)
+{
+    return checkRecurrentActivations(node, 2);
+}
+
+DEFINE_BUILTIN_OP_CHECKER(InstanceNormalization)
+{
+    ASSERT(isWeights(inputs, 1), ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(isWeights(inputs, 2), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(LSTM)
+{
+    OnnxAttrs attrs(node, nullptr);
+    ASSERT(attrs.get<int>("input_forget", 0) == 0 && "Coupled input/forget is unsupported in the LSTM converter",
+        ErrorCode::kUNSUPPORTED_NODE);
+    return checkRecurrentActivations(node, 3);
+}
+
+DEFINE_BUILTIN_OP_CHECKER(MatMul)
+{
+    ASSERT(inputs.size() >= 2, ErrorCode::kINVALID_NODE);
+    ASSERT(!isIntType(inputs.at(0).dtype) && !isIntType(inputs.at(1).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Pad)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    ASSERT(inputs.at(0).rank == -1 || inputs.at(0).rank >= 4, ErrorCode::kUNSUPPORTED_NODE);
+    OnnxAttrs attrs(node, nullptr);
+    float value{0.f};
+    if (opset < 11)
+    {
+        value = attrs.get<float>("value", 0.f);
+    }
+    else
+    {
+        ASSERT(isWeights(inputs, 1), ErrorCode::kUNSUPPORTED_NODE);
+        if (isSet(inputs, 2))
+        {
+            ASSERT(isWeights(inputs, 2), ErrorCode::kUNSUPPORTED_NODE);
+            if (inputs.at(2).weights)
+            {
+                ASSERT(weightsCount(*inputs.at(2).weights) == 1, ErrorCode::kINVALID_NODE);
+                readFirstFloat(*inputs.at(2).weights, &value);
+            }
+        }
+    }
+    ASSERT(attrs.get<std::string>("mode", "constant") == "constant" && value == 0.f
+            && "This version of TensorRT only supports constant 0 padding!",
+        ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(PRelu)
+{
+    ASSERT(inputs.size() == 2, ErrorCode::kINVALID_NODE);
+    ASSERT(!isIntType(inputs.at(0).dtype) && !isIntType(inputs.at(1).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(QuantizeLinear)
+{
+    return checkQuantization(inputs);
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Resize)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    // TRT does not support INT32 nor BOOL input types for this node
+    ASSERT(!isIntType(inputs.at(0).dtype) && !isBoolType(inputs.at(0).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(inputs.at(0).rank != 0, ErrorCode::kUNSUPPORTED_NODE);
+    OnnxAttrs attrs(node, nullptr);
+    auto mode = attrs.get<std::string>("mode", "nearest");
+    ASSERT((mode == "nearest" || mode == "linear" || mode == "cubic") && "Unknown resize mode!",
+        ErrorCode::kINVALID_NODE);
+    if (opset >= 11)
+    {
+        auto transformationMode = attrs.get<std::string>("coordinate_transformation_mode", "half_pixel");
+        ASSERT(transformationMode != "tf_crop_and_resize" && "TensorRT does not support tf_crop_and_resize!",
+            ErrorCode::kUNSUPPORTED_NODE);
+        if (inputs.size() == 4)
+        {
+            return Status::success();
+        }
+    }
+    ASSERT(isWeights(inputs, opset >= 11 ? 2 : 1) && "Resize scales must be an initializer!",
+        ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(RNN)
+{
+    return checkRecurrentActivations(node, 1);
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Slice)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    ASSERT(!isBoolType(inputs.at(0).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(SpaceToDepth)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    ASSERT(inputs.at(0).rank == -1 || inputs.at(0).rank == 4, ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(!isBoolType(inputs.at(0).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Split)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    ASSERT(!isBoolType(inputs.at(0).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Tile)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    ASSERT(!isBoolType(inputs.at(0).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(TopK)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    ASSERT(!isIntType(inputs.at(0).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    if (opset >= 10)
+    {
+        // Don't support TopK with k as a tensor
+        ASSERT(isWeights(inputs, 1), ErrorCode::kUNSUPPORTED_NODE);
+        ASSERT(!inputs.at(1).weights || weightsCount(*inputs.at(1).weights) == 1, ErrorCode::kUNSUPPORTED_NODE);
+    }
+    else
+    {
+        OnnxAttrs attrs(node, nullptr);
+        ASSERT(attrs.count("k"), ErrorCode::kINVALID_NODE);
+    }
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Upsample)
+{
+    ASSERT(inputs.size() >= 1, ErrorCode::kINVALID_NODE);
+    // TRT does not support BOOL input types for this node
+    ASSERT(!isIntType(inputs.at(0).dtype) && !isBoolType(inputs.at(0).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    OnnxAttrs attrs(node, nullptr);
+    if (opset >= 9)
+    {
+        ASSERT(inputs.size() == 2, ErrorCode::kINVALID_NODE);
+        ASSERT(isWeights(inputs, 1), ErrorCode::kUNSUPPORTED_NODE);
+        ASSERT(inputs.at(1).dtype == ::ONNX_NAMESPACE::TensorProto::FLOAT, ErrorCode::kINVALID_NODE);
+    }
+    else
+    {
+        ASSERT(attrs.count("scales"), ErrorCode::kUNSUPPORTED_NODE);
+    }
+    auto mode = attrs.get<std::string>("mode", "nearest");
+    ASSERT(mode == "nearest" || mode == "linear", ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+DEFINE_BUILTIN_OP_CHECKER(Where)
+{
+    ASSERT(inputs.size() >= 3, ErrorCode::kINVALID_NODE);
+    ASSERT(!isBoolType(inputs.at(1).dtype) && !isBoolType(inputs.at(2).dtype), ErrorCode::kUNSUPPORTED_NODE);
+    return Status::success();
+}
+
+} // namespace
+
+} // namespace onnx2trt
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#pragma once
+
+#include "Status.hpp"
+#include "utils.hpp"
+
+#include <functional>
+#include <onnx/onnx_pb.h>
+#include <vector>
+
+namespace onnx2trt
+{
+
+// Describes a node input as seen during support analysis, where no TensorRT objects are created.
+struct CheckerInput
+{
+    bool isNull{true};                                     // Optional input that was not supplied.
+    bool isWeights{false};                                 // Initializer or output of a Constant node.
+    int32_t dtype{::ONNX_NAMESPACE::TensorProto::UNDEFINED}; // ONNX data type, or UNDEFINED if unknown.
+    int rank{-1};                                          // Number of dimensions, or -1 if unknown.
+    ::ONNX_NAMESPACE::TensorProto const* weights{nullptr}; // Weight values, if known.
+};
+
+// A checker verifies the static preconditions of the importer for the same op, without building any layers.
+// It returns an error describing the first precondition that is violated. inputs has one entry per input listed by the
+// node, so checkers must check its size before reading inputs that a malformed node may lack.
+typedef std::function<Status(
+    int64_t opset, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<CheckerInput> const& inputs)>
+    NodeChecker;
+
+// Returns the registry of builtin checkers. Like the importer registry, it is populated during static
+// initialization and is read-only afterwards. Ops without a checker have no static preconditions beyond having an
+// importer registered.
+const string_map<NodeChecker>& getBuiltinOpCheckerMap();
+
+} // namespace onnx2trt
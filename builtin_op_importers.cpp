@@ -39,12 +39,22 @@
 namespace onnx2trt
 {
 
-string_map<NodeImporter>& getBuiltinOpImporterMap()
+namespace
+{
+
+string_map<NodeImporter>& getMutableBuiltinOpImporterMap()
 {
     static string_map<NodeImporter> builtin_op_importers;
     return builtin_op_importers;
 }
 
+} // namespace
+
+const string_map<NodeImporter>& getBuiltinOpImporterMap()
+{
+    return getMutableBuiltinOpImporterMap();
+}
+
 namespace
 {
 
@@ -104,7 +114,7 @@ namespace
 
 bool registerBuiltinOpImporter(std::string op, NodeImporter const& importer)
 {
-    bool inserted = getBuiltinOpImporterMap().insert({op, importer}).second;
+    bool inserted = getMutableBuiltinOpImporterMap().insert({op, importer}).second;
     assert(inserted);
     return inserted;
 }
@@ -124,8 +134,51 @@ DEFINE_BUILTIN_OP_IMPORTER(Acosh)
     return unaryHelper(ctx, inputs.at(0), nvinfer1::UnaryOperation::kACOSH);
 }
 
+// Folds an Add of constant values into the bias of a fully connected layer that was created without one (see MatMul
+// and Gemm), if the values are broadcast along the last dimension only and nothing else reads the layer's output.
+// Returns the index of the input produced by the layer, or -1 if the Add cannot be folded.
+int foldAddIntoFullyConnectedBias(
+    IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs)
+{
+    if (inputs.size() != 2)
+    {
+        return -1;
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        auto fcIt = ctx->biaslessFullyConnectedLayers().find(node.input(i));
+        TensorOrWeights& other = inputs.at(1 - i);
+        if (fcIt == ctx->biaslessFullyConnectedLayers().end() || !inputs.at(i).is_tensor() || !other.is_weights()
+            || ctx->tensorConsumerCounts()[node.input(i)] != 1)
+        {
+            continue;
+        }
+        nvinfer1::IFullyConnectedLayer* fc = fcIt->second;
+        ShapedWeights bias = other.weights();
+        const int nbOutputs = fc->getNbOutputChannels();
+        const int outputRank = inputs.at(i).tensor().getDimensions().nbDims;
+        nvinfer1::DataType biasType;
+        if (bias.count() != static_cast<size_t>(nbOutputs) || bias.shape.nbDims < 1 || bias.shape.nbDims > outputRank
+            || bias.shape.d[bias.shape.nbDims - 1] != nbOutputs || !convertDtype(bias.type, &biasType)
+            || biasType != fc->getKernelWeights().type)
+        {
+            continue;
+        }
+        fc->setBiasWeights(bias);
+        ctx->biaslessFullyConnectedLayers().erase(fcIt);
+        return i;
+    }
+    return -1;
+}
+
 DEFINE_BUILTIN_OP_IMPORTER(Add)
 {
+    const int fcInput = foldAddIntoFullyConnectedBias(ctx, node, inputs);
+    if (fcInput >= 0)
+    {
+        LOG_VERBOSE("Add: folded into the bias of the preceding fully connected layer.");
+        return {{inputs.at(fcInput)}};
+    }
     return elementwiseHelper(ctx, node, inputs, nvinfer1::ElementWiseOperation::kSUM);
 }
 
@@ -489,6 +542,7 @@ DEFINE_BUILTIN_OP_IMPORTER(Conv)
     bool exclude_padding;
     getKernelParams(
         ctx, node, &kernel_size, &strides, &beg_padding, &end_padding, paddingMode, exclude_padding, &dilations);
+    addFoldedPadding(ctx, node, beg_padding, end_padding);
 
     for (int i = 1; i <= nbSpatialDims; ++i)
     {
@@ -787,6 +841,11 @@ DEFINE_BUILTIN_OP_IMPORTER(DepthToSpace)
 
 DEFINE_BUILTIN_OP_IMPORTER(DequantizeLinear)
 {
+    if (canFoldQuantization(ctx, node, inputs))
+    {
+        return foldQuantizationHelper(ctx, node, inputs);
+    }
+
     ASSERT(inputs.size() == 3, nvonnxparser::ErrorCode::kINVALID_NODE);
 
     std::string name = node.name();
@@ -951,6 +1010,72 @@ DEFINE_BUILTIN_OP_IMPORTER(Gather)
     RETURN_FIRST_OUTPUT(ctx->network()->addGather(data, indices, axis));
 }
 
+// Computes the weights of a fully connected layer equivalent to a Gemm whose B input is constant, folding in alpha,
+// beta and transB. C must be absent or constant, with one value per output column or a single value. Returns false
+// if the Gemm cannot be expressed this way.
+bool getGemmFullyConnectedWeights(IImporterContext* ctx, std::vector<TensorOrWeights>& inputs, float alpha, float beta,
+    bool transB, ShapedWeights& kernel, ShapedWeights& bias)
+{
+    if (!inputs.at(0).is_tensor() || inputs.at(0).tensor().getDimensions().nbDims != 2 || !inputs.at(1).is_weights())
+    {
+        return false;
+    }
+    const nvinfer1::DataType typeA = inputs.at(0).tensor().getType();
+    const ShapedWeights weightsB = inputs.at(1).weights();
+    // Scaling is only implemented for FLOAT weights.
+    const bool isFloat = weightsB.type == ::ONNX_NAMESPACE::TensorProto::FLOAT;
+    const bool isHalf = weightsB.type == ::ONNX_NAMESPACE::TensorProto::FLOAT16;
+    if ((typeA != nvinfer1::DataType::kFLOAT && typeA != nvinfer1::DataType::kHALF) || weightsB.shape.nbDims != 2
+        || !(isFloat || (isHalf && alpha == 1.f)))
+    {
+        return false;
+    }
+    const int nbOutputs = transB ? weightsB.shape.d[0] : weightsB.shape.d[1];
+
+    bias = ShapedWeights::empty(weightsB.type);
+    if (inputs.size() > 2 && inputs.at(2) && beta != 0.f)
+    {
+        if (!inputs.at(2).is_weights())
+        {
+            return false;
+        }
+        const ShapedWeights weightsC = inputs.at(2).weights();
+        const bool perColumn = weightsC.count() == static_cast<size_t>(nbOutputs)
+            && (weightsC.shape.nbDims == 1 || (weightsC.shape.nbDims == 2 && weightsC.shape.d[0] == 1));
+        const bool isScalar = weightsC.count() == 1;
+        if (weightsC.type != weightsB.type || !(perColumn || isScalar) || (!isFloat && (beta != 1.f || !perColumn)))
+        {
+            return false;
+        }
+        if (perColumn)
+        {
+            bias = beta == 1.f ? weightsC : scaleWeights(ctx, weightsC, beta);
+        }
+        else
+        {
+            bias = ctx->createTempWeights(weightsC.type, nvinfer1::Dims{1, {nbOutputs}});
+            const float value = static_cast<const float*>(weightsC.values)[0] * beta;
+            std::fill_n(static_cast<float*>(bias.values), nbOutputs, value);
+        }
+    }
+
+    // The fully connected layer expects the kernel as [N, K].
+    kernel = weightsB;
+    if (!transB)
+    {
+        kernel = ctx->createTempWeights(weightsB.type, weightsB.shape);
+        if (!transposeWeights(weightsB, {1, 0}, &kernel))
+        {
+            return false;
+        }
+    }
+    if (alpha != 1.f)
+    {
+        kernel = scaleWeights(ctx, kernel, alpha);
+    }
+    return true;
+}
+
 DEFINE_BUILTIN_OP_IMPORTER(Gemm)
 {
     OnnxAttrs attrs(node, ctx);
@@ -958,30 +1083,29 @@ DEFINE_BUILTIN_OP_IMPORTER(Gemm)
     float beta = attrs.get("beta", 1.f);
     bool transA = attrs.get("transA", false);
     bool transB = attrs.get("transB", false);
-    nvinfer1::ITensor& inputA = convertToTensor(inputs.at(0), ctx);
-    nvinfer1::ITensor* inputB = &convertToTensor(inputs.at(1), ctx);
-    // TRT does not support INT32 input types for this node
-    ASSERT(inputA.getType() == inputB->getType() && inputA.getType() != nvinfer1::DataType::kINT32, ErrorCode::kUNSUPPORTED_NODE);
 
-    // Use FC if it is likely to be faster - which is usually when no Shuffles are required.
-    bool canUseFC = inputs.at(0).is_tensor() && inputs.at(1).is_weights() && inputs.at(2).is_weights() && alpha == 1.f
-        && beta == 1.f && inputs.at(0).tensor().getDimensions().nbDims == 3 && inputs.at(1).weights().shape.nbDims == 2
-        && inputs.at(2).weights().shape.nbDims == 1;
-    if (canUseFC)
-    {
-        LOG_VERBOSE("GEMM: using FC layer instead of MM because all criteria were met.");
-        nvinfer1::ITensor& tensor = inputs.at(0).tensor();
-        ShapedWeights weights = inputs.at(1).weights();
-        if (!transB)
+    // With a constant B, use a single FC layer with everything but transA folded into its weights. This avoids the
+    // constant, shuffle, scaling and bias layers of the general path below.
+    ShapedWeights fcKernel;
+    ShapedWeights fcBias;
+    if (getGemmFullyConnectedWeights(ctx, inputs, alpha, beta, transB, fcKernel, fcBias))
+    {
+        LOG_VERBOSE("GEMM: using FC layer with alpha, beta and transB folded into the weights.");
+        nvinfer1::IFullyConnectedLayer* fc{nullptr};
+        nvinfer1::ITensor* output = fullyConnectedHelper(ctx, inputs.at(0).tensor(), transA, fcKernel, fcBias, &fc);
+        ASSERT(output, ErrorCode::kUNSUPPORTED_NODE);
+        if (!fcBias)
         {
-            auto transposedWeights = ctx->createTempWeights(weights.type, weights.shape);
-            ASSERT(transposeWeights(weights, {1, 0}, &transposedWeights), ErrorCode::kUNSUPPORTED_NODE);
-            weights = transposedWeights;
+            ctx->biaslessFullyConnectedLayers()[node.output(0)] = fc;
         }
-        ShapedWeights biases = inputs.at(2).weights();
-        RETURN_FIRST_OUTPUT(ctx->network()->addFullyConnected(tensor, biases.shape.d[0], weights, biases));
+        return {{output}};
     }
 
+    nvinfer1::ITensor& inputA = convertToTensor(inputs.at(0), ctx);
+    nvinfer1::ITensor* inputB = &convertToTensor(inputs.at(1), ctx);
+    // TRT does not support INT32 input types for this node
+    ASSERT(inputA.getType() == inputB->getType() && inputA.getType() != nvinfer1::DataType::kINT32, ErrorCode::kUNSUPPORTED_NODE);
+
     // If input B is a constant, we transpose at parse time if necessary,
     // because In some cases, A * Bt is much slower than A * B.
     if (inputs.at(1).is_weights())
@@ -1175,6 +1299,12 @@ nvinfer1::ITensor* concatenateRNNOutputs(IImporterContext* ctx, nvinfer1::ILoop*
 
 DEFINE_BUILTIN_OP_IMPORTER(GRU)
 {
+    if (canUseRNNv2(ctx, node, inputs))
+    {
+        LOG_VERBOSE("GRU: using fused RNNv2 layer.");
+        return rnnv2Helper(ctx, node, inputs);
+    }
+
     using nvinfer1::Dims;
     using nvinfer1::Dims3;
     using mOp = nvinfer1::MatrixOperation;
@@ -1547,13 +1677,19 @@ DEFINE_BUILTIN_OP_IMPORTER(InstanceNormalization)
     ASSERT(inputs.at(1).is_weights(), ErrorCode::kUNSUPPORTED_NODE);
     ASSERT(inputs.at(2).is_weights(), ErrorCode::kUNSUPPORTED_NODE);
     nvinfer1::ITensor* tensor_ptr = &convertToTensor(inputs.at(0), ctx);
-    ASSERT(!isDynamic(tensor_ptr->getDimensions()) && "InstanceNormalization does not support dynamic inputs!",
-        ErrorCode::kUNSUPPORTED_NODE);
     auto scale_weights = inputs.at(1).weights();
     auto bias_weights = inputs.at(2).weights();
     OnnxAttrs attrs(node, ctx);
     float epsilon = attrs.get("epsilon", 1e-5f);
-    // TensorRT only supports epsilon values >= 1e-4.
+
+    // The plugin requires static dimensions, so dynamic inputs are decomposed into reductions instead.
+    if (isDynamic(tensor_ptr->getDimensions()))
+    {
+        LOG_VERBOSE("InstanceNormalization: using reduce-based implementation for dynamic input.");
+        return instanceNormHelper(ctx, *tensor_ptr, scale_weights, bias_weights, epsilon);
+    }
+
+    // The TensorRT plugin only supports epsilon values >= 1e-4.
     epsilon = std::max(epsilon, 1e-4f);
 
     // Populate instanceNormalization plugin properties.
@@ -1592,30 +1728,65 @@ DEFINE_BUILTIN_OP_IMPORTER(Log)
 
 DEFINE_BUILTIN_OP_IMPORTER(LogSoftmax)
 {
-    // Don't use softmax converter since it adds a shuffle layer
-    // which prevents the builder to fuse softmax and log operations.
-
-    OnnxAttrs attrs(node, ctx);
-    // "input : T"
-    nvinfer1::ITensor& input = convertToTensor(inputs.at(0), ctx);
-    const ShapeTensor dims = shapeOf(ctx, input);
-    // "axis : int (default is 1)"
-    int axis = attrs.get("axis", 1);
-
-    // "Negative value means counting dimensions from the back.
-    // Accepted range is [-r, r-1] where r = rank(input)."
-    TRT_CHECK(convertAxis(axis, dims.size));
+    return softmaxHelper(ctx, node, inputs, /*isLogSoftmax=*/true);
+}
 
-    // "The input does not need to explicitly be a 2D vector; rather, it will be coerced into one."
-    auto* flattened = flattenTensor(ctx, input, axis);
-    auto* softMax = ctx->network()->addSoftMax(*flattened);
-    // ONNX softmax is always on second dimension.
-    softMax->setAxes(1 << 1);
+// Returns the name of a loop-invariant value N such that the loop body condition is false once iteration_num >= N,
+// or an empty string if there is no such value. Matches conditions of the form Less(iteration_num, N) or
+// Greater(N, iteration_num), optionally combined with others through And. The body computes the condition for the
+// next iteration, so iteration N still runs and the loop runs at most max(N, 0) + 1 times.
+std::string findLoopIterationBound(const ::ONNX_NAMESPACE::GraphProto& body)
+{
+    StringMap<const ::ONNX_NAMESPACE::NodeProto*> producers;
+    for (const auto& bodyNode : body.node())
+    {
+        for (const auto& output : bodyNode.output())
+        {
+            producers[output] = &bodyNode;
+        }
+    }
+    const std::string& iterationNum = body.input(0).name();
+    // Values from the enclosing graph, initializers and Constant nodes are the same in every iteration.
+    auto isLoopInvariant = [&](const std::string& name) {
+        if (!producers.count(name))
+        {
+            return std::none_of(body.input().begin(), body.input().end(),
+                [&name](const ::ONNX_NAMESPACE::ValueInfoProto& input) { return input.name() == name; });
+        }
+        return producers.at(name)->op_type() == "Constant";
+    };
 
-    // Reshape back to original shape
-    nvinfer1::IUnaryLayer* unaryLayer = ctx->network()->addUnary(*softMax->getOutput(0), nvinfer1::UnaryOperation::kLOG);
-    auto *reshapeLayer = addShuffle(ctx, *unaryLayer->getOutput(0), dims);
-    RETURN_FIRST_OUTPUT(reshapeLayer);
+    std::vector<std::string> conditions{body.output(0).name()};
+    while (!conditions.empty())
+    {
+        const std::string condition = conditions.back();
+        conditions.pop_back();
+        if (!producers.count(condition))
+        {
+            continue;
+        }
+        const ::ONNX_NAMESPACE::NodeProto& producer = *producers.at(condition);
+        if (producer.input_size() != 2)
+        {
+            continue;
+        }
+        if (producer.op_type() == "And")
+        {
+            conditions.push_back(producer.input(0));
+            conditions.push_back(producer.input(1));
+        }
+        else if (producer.op_type() == "Less" && producer.input(0) == iterationNum
+            && isLoopInvariant(producer.input(1)))
+        {
+            return producer.input(1);
+        }
+        else if (producer.op_type() == "Greater" && producer.input(1) == iterationNum
+            && isLoopInvariant(producer.input(0)))
+        {
+            return producer.input(0);
+        }
+    }
+    return "";
 }
 
 DEFINE_BUILTIN_OP_IMPORTER(Loop)
@@ -1623,7 +1794,8 @@ DEFINE_BUILTIN_OP_IMPORTER(Loop)
     constexpr int NB_NON_STATE_INPUTS = 2; // First 2 inputs are trip count and condition respectively.
     constexpr int NB_DISCARDED_OUTPUTS
         = 1; // First output is the updated value of the condition, and is ignored by the outer loop node.
-    constexpr int MAX_SCAN_OUTPUT_LENGTH = 1024; // Maximum length for scan outputs if trip count is not set.
+    // Default length for scan outputs if the number of iterations has no known bound.
+    constexpr int DEFAULT_MAX_SCAN_OUTPUT_LENGTH = 1024;
     ASSERT(inputs.size() >= 2, ErrorCode::kINVALID_NODE);
     OnnxAttrs attrs(node, ctx);
     const int nbInputs = node.input().size();
@@ -1641,15 +1813,21 @@ DEFINE_BUILTIN_OP_IMPORTER(Loop)
         tripLimit = convertToScalar(ctx, &convertToTensor(inputs[0], ctx));
         ASSERT(tripLimit, ErrorCode::kINVALID_NODE);
         loop->addTripLimit(*tripLimit, nvinfer1::TripLimit::kCOUNT);
-        ctx->registerTensor(tripLimit, body.input(0).name());
     }
+    // The condition is a state variable, updated by the first output of the body.
+    nvinfer1::IRecurrenceLayer* condition{nullptr};
     if (inputs[1])
     {
-        nvinfer1::ITensor* cond = convertToScalar(ctx, &convertToTensor(inputs[1], ctx));
-        ASSERT(cond, ErrorCode::kINVALID_NODE);
-        loop->addTripLimit(*cond, nvinfer1::TripLimit::kWHILE);
-        ctx->registerTensor(cond, body.input(1).name());
+        nvinfer1::ITensor* initialCondition = convertToScalar(ctx, &convertToTensor(inputs[1], ctx));
+        ASSERT(initialCondition, ErrorCode::kINVALID_NODE);
+        condition = loop->addRecurrence(*initialCondition);
+        loop->addTripLimit(*condition->getOutput(0), nvinfer1::TripLimit::kWHILE);
+        ctx->registerTensor(condition->getOutput(0), body.input(1).name());
     }
+    // The iteration number is a state variable too. Its final value is the number of iterations run.
+    nvinfer1::IRecurrenceLayer* iterationNum
+        = loop->addRecurrence(*addConstantScalar(ctx, 0, ::ONNX_NAMESPACE::TensorProto_DataType_INT32)->getOutput(0));
+    ctx->registerTensor(iterationNum->getOutput(0), body.input(0).name());
     // Add initial state inputs using recurrent layers.
     std::vector<nvinfer1::IRecurrenceLayer*> stateVars{};
     for (size_t i = 2; i < inputs.size(); ++i)
@@ -1661,6 +1839,20 @@ DEFINE_BUILTIN_OP_IMPORTER(Loop)
     // Loop body
     TRT_CHECK(onnx2trt::parseGraph(ctx, body));
 
+    iterationNum->setInput(1,
+        *ctx->network()
+             ->addElementWise(*iterationNum->getOutput(0),
+                 *addConstantScalar(ctx, 1, ::ONNX_NAMESPACE::TensorProto_DataType_INT32)->getOutput(0),
+                 nvinfer1::ElementWiseOperation::kSUM)
+             ->getOutput(0));
+    if (condition)
+    {
+        nvinfer1::ITensor* nextCondition
+            = convertToScalar(ctx, &convertToTensor(ctx->tensors().at(body.output(0).name()), ctx));
+        ASSERT(nextCondition, ErrorCode::kINVALID_NODE);
+        condition->setInput(1, *nextCondition);
+    }
+
     // Set final values of state variables.
     std::vector<TensorOrWeights> nodeOutputs{};
     for (int i = 0; i < nbStateVars; ++i)
@@ -1678,7 +1870,48 @@ DEFINE_BUILTIN_OP_IMPORTER(Loop)
             loop->addLoopOutput(*stateVars.at(i)->getOutput(0), nvinfer1::LoopOutput::kLAST_VALUE)->getOutput(0));
     }
     const int nbOutputs = body.output_size();
-    // Finally, set up scan outputs if there are any
+    if (nbOutputs == nbStateVars + NB_DISCARDED_OUTPUTS)
+    {
+        return {nodeOutputs};
+    }
+
+    // Scan outputs are concatenated into buffers whose length must be known before the loop runs. That length is
+    // the trip count, or the number of iterations max(N, 0) + 1 allowed by a condition (iteration_num < N),
+    // whichever is smaller. Failing both, it is the user-provided maximum.
+    nvinfer1::ITensor* scanLength = tripLimit;
+    const std::string boundName = condition ? findLoopIterationBound(body) : "";
+    nvinfer1::ITensor* bound = boundName.empty()
+        ? nullptr
+        : convertToScalar(ctx, &convertToTensor(ctx->tensors().at(boundName), ctx));
+    if (bound && bound->getType() == nvinfer1::DataType::kINT32)
+    {
+        LOG_VERBOSE("Loop condition bounds the number of iterations by: " << boundName << " + 1");
+        nvinfer1::ITensor* zero = addConstantScalar(ctx, 0, ::ONNX_NAMESPACE::TensorProto_DataType_INT32)->getOutput(0);
+        nvinfer1::ITensor* one = addConstantScalar(ctx, 1, ::ONNX_NAMESPACE::TensorProto_DataType_INT32)->getOutput(0);
+        bound = ctx->network()->addElementWise(*bound, *zero, nvinfer1::ElementWiseOperation::kMAX)->getOutput(0);
+        bound = ctx->network()->addElementWise(*bound, *one, nvinfer1::ElementWiseOperation::kSUM)->getOutput(0);
+        scanLength = scanLength
+            ? ctx->network()->addElementWise(*scanLength, *bound, nvinfer1::ElementWiseOperation::kMIN)->getOutput(0)
+            : bound;
+    }
+    if (!scanLength)
+    {
+        const int32_t maxLength = ctx->maxLoopScanOutputLength() > 0 ? ctx->maxLoopScanOutputLength()
+                                                                     : DEFAULT_MAX_SCAN_OUTPUT_LENGTH;
+        LOG_WARNING("Loop has no trip count, and its condition does not bound the number of iterations. Its scan "
+            "outputs are limited to "
+            << maxLength << " iterations, which can be changed with IParser::setMaxLoopScanOutputLength().");
+        scanLength = addConstantScalar(ctx, maxLength, ::ONNX_NAMESPACE::TensorProto_DataType_INT32)->getOutput(0);
+    }
+    // Unless the loop always runs for the trip count, scan outputs are trimmed to the number of iterations run.
+    nvinfer1::ITensor* nbIterations = nullptr;
+    if (condition || !tripLimit)
+    {
+        nbIterations
+            = loop->addLoopOutput(*iterationNum->getOutput(0), nvinfer1::LoopOutput::kLAST_VALUE)->getOutput(0);
+    }
+
+    // Finally, set up scan outputs
     for (int i = nbStateVars + NB_DISCARDED_OUTPUTS; i < nbOutputs; ++i)
     {
         const auto& bodyOutputName = body.output(i).name();
@@ -1686,20 +1919,23 @@ DEFINE_BUILTIN_OP_IMPORTER(Loop)
         LOG_VERBOSE("For scan output: " << bodyOutputName << ", found matching tensor: " << scanOutput.getName()
                                         << ", with shape: " << scanOutput.getDimensions());
         nvinfer1::ILoopOutputLayer* trtScanOut = loop->addLoopOutput(scanOutput, nvinfer1::LoopOutput::kCONCATENATE, 0);
-        // If trip limit is set, we can set the loop output to the tripLimit, otherwise, set to some dummy constant
-        // value.
-        // In the latter case, the scan outputs must not be used in the rest of the model.
-        if (tripLimit)
-        {
-            trtScanOut->setInput(1, *tripLimit);
-        }
-        else
+        trtScanOut->setInput(1, *scanLength);
+        nvinfer1::ITensor* output = trtScanOut->getOutput(0);
+        if (nbIterations)
         {
-            trtScanOut->setInput(
-                1, *addConstantScalar(ctx, MAX_SCAN_OUTPUT_LENGTH, ::ONNX_NAMESPACE::TensorProto_DataType_INT32)
-                        ->getOutput(0));
+            const int rank = output->getDimensions().nbDims;
+            const ShapeTensor shape = shapeOf(ctx, *output);
+            TensorOrWeights nbIterationsTensor{nbIterations};
+            ShapeTensor sizes = convertTo1D(ctx, ShapeTensor(nbIterationsTensor));
+            if (rank > 1)
+            {
+                std::vector<int64_t> innerAxes(rank - 1);
+                std::iota(innerAxes.begin(), innerAxes.end(), 1);
+                sizes = concat(ctx, sizes, gather(ctx, shape, ShapeTensor(1, std::move(innerAxes))));
+            }
+            output = addSlice(ctx, *output, similar(shape, 0), sizes, similar(shape, 1))->getOutput(0);
         }
-        nodeOutputs.emplace_back(trtScanOut->getOutput(0));
+        nodeOutputs.emplace_back(output);
     }
 
     return {nodeOutputs};
@@ -1718,6 +1954,12 @@ DEFINE_BUILTIN_OP_IMPORTER(LRN)
 
 DEFINE_BUILTIN_OP_IMPORTER(LSTM)
 {
+    if (canUseRNNv2(ctx, node, inputs))
+    {
+        LOG_VERBOSE("LSTM: using fused RNNv2 layer.");
+        return rnnv2Helper(ctx, node, inputs);
+    }
+
     using trtAct = nvinfer1::ActivationType;
     using eOp = nvinfer1::ElementWiseOperation;
 
@@ -2008,8 +2250,55 @@ DEFINE_BUILTIN_OP_IMPORTER(LSTM)
 
 DEFINE_BUILTIN_OP_IMPORTER(MatMul)
 {
-    nvinfer1::ITensor* inputA = &convertToTensor(inputs.at(0), ctx);
-    nvinfer1::ITensor* inputB = &convertToTensor(inputs.at(1), ctx);
+    // A product with constant 2D weights is imported as a FC layer, treating any leading dimensions of A as batch
+    // dimensions. A following Add of constant values is folded into its bias by the Add importer.
+    if (inputs.at(0).is_tensor() && inputs.at(1).is_weights())
+    {
+        nvinfer1::ITensor& tensorA = inputs.at(0).tensor();
+        const ShapedWeights weightsB = inputs.at(1).weights();
+        const int nbDims = tensorA.getDimensions().nbDims;
+        const nvinfer1::DataType typeA = tensorA.getType();
+        if (nbDims >= 2 && nbDims + 2 <= nvinfer1::Dims::MAX_DIMS && weightsB.shape.nbDims == 2
+            && (typeA == nvinfer1::DataType::kFLOAT || typeA == nvinfer1::DataType::kHALF)
+            && (weightsB.type == ::ONNX_NAMESPACE::TensorProto::FLOAT
+                || weightsB.type == ::ONNX_NAMESPACE::TensorProto::FLOAT16))
+        {
+            LOG_VERBOSE("MatMul: using FC layer for constant weights.");
+            ShapedWeights kernel = ctx->createTempWeights(weightsB.type, weightsB.shape);
+            ASSERT(transposeWeights(weightsB, {1, 0}, &kernel), ErrorCode::kUNSUPPORTED_NODE);
+            nvinfer1::IFullyConnectedLayer* fc{nullptr};
+            nvinfer1::ITensor* output
+                = fullyConnectedHelper(ctx, tensorA, false, kernel, ShapedWeights::empty(kernel.type), &fc);
+            ASSERT(output, ErrorCode::kUNSUPPORTED_NODE);
+            ctx->biaslessFullyConnectedLayers()[node.output(0)] = fc;
+            return {{output}};
+        }
+    }
+
+    // Constant operands are kept in their untransposed layout, which is the fast case for the matrix multiply (any
+    // Transpose feeding them has already been applied on the host). Batched constants of lower rank than the other
+    // operand get their leading unit dimensions here rather than through a broadcast shuffle.
+    const int nbDims = std::max(inputs.at(0).shape().nbDims, inputs.at(1).shape().nbDims);
+    auto expandConstantRank = [nbDims](TensorOrWeights const& input) {
+        if (!input.is_weights() || input.weights().shape.nbDims < 2 || input.weights().shape.nbDims >= nbDims)
+        {
+            return input;
+        }
+        ShapedWeights weights = input.weights();
+        const int delta = nbDims - weights.shape.nbDims;
+        for (int i = weights.shape.nbDims - 1; i >= 0; --i)
+        {
+            weights.shape.d[i + delta] = weights.shape.d[i];
+        }
+        std::fill(weights.shape.d, weights.shape.d + delta, 1);
+        weights.shape.nbDims = nbDims;
+        return TensorOrWeights{weights};
+    };
+    TensorOrWeights operandA = expandConstantRank(inputs.at(0));
+    TensorOrWeights operandB = expandConstantRank(inputs.at(1));
+
+    nvinfer1::ITensor* inputA = &convertToTensor(operandA, ctx);
+    nvinfer1::ITensor* inputB = &convertToTensor(operandB, ctx);
     // TRT does not support INT32 input types for this node
     ASSERT(inputA->getType() == inputB->getType() && inputA->getType() != nvinfer1::DataType::kINT32, ErrorCode::kUNSUPPORTED_NODE);
     broadcastTensors(ctx, inputA, inputB);
@@ -2085,10 +2374,63 @@ DEFINE_BUILTIN_OP_IMPORTER(Or)
     return elementwiseHelper(ctx, node, inputs, nvinfer1::ElementWiseOperation::kOR);
 }
 
+// Returns true if a constant Pad node can be folded into the padding of the Conv or pooling node that is its only
+// consumer, i.e. if it pads only spatial dimensions, by non-negative amounts, with a value the consumer would pad with.
+bool canFoldPad(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::string const& mode, float value,
+    std::vector<int64_t> const& onnxPadding, int nbDims)
+{
+    if (mode != "constant" || nbDims < 3 || nbDims > 5 || static_cast<int>(onnxPadding.size()) != 2 * nbDims
+        || ctx->tensorConsumerCounts()[node.output(0)] != 1)
+    {
+        return false;
+    }
+    auto consumerIt = ctx->tensorConsumers().find(node.output(0));
+    if (consumerIt == ctx->tensorConsumers().end() || consumerIt->second->input(0) != node.output(0))
+    {
+        return false;
+    }
+    for (int i = 0; i < nbDims; ++i)
+    {
+        const int64_t beg = onnxPadding[i];
+        const int64_t end = onnxPadding[nbDims + i];
+        if (beg < 0 || end < 0 || (i < 2 && (beg != 0 || end != 0)))
+        {
+            return false;
+        }
+    }
+
+    ::ONNX_NAMESPACE::NodeProto const& consumer = *consumerIt->second;
+    OnnxAttrs attrs(consumer, ctx);
+    const auto autoPad = attrs.get("auto_pad", std::string("NOTSET"));
+    if (autoPad != "NOTSET" && autoPad != "VALID")
+    {
+        return false;
+    }
+    if (consumer.op_type() == "Conv")
+    {
+        return value == 0.f;
+    }
+    if (consumer.op_type() == "AveragePool")
+    {
+        // Only symmetric padding keeps the asymmetric padding support of the pooling layer unchanged.
+        bool symmetric = true;
+        for (int i = 2; i < nbDims; ++i)
+        {
+            symmetric &= onnxPadding[i] == onnxPadding[nbDims + i];
+        }
+        return value == 0.f && attrs.get("count_include_pad", 0) == 1 && symmetric;
+    }
+    if (consumer.op_type() == "MaxPool")
+    {
+        return value <= std::numeric_limits<float>::lowest();
+    }
+    return false;
+}
+
 DEFINE_BUILTIN_OP_IMPORTER(Pad)
 {
     nvinfer1::ITensor& tensor = convertToTensor(inputs.at(0), ctx);
-    ASSERT(tensor.getDimensions().nbDims >= 4, ErrorCode::kUNSUPPORTED_NODE);
+    const int nbDims = tensor.getDimensions().nbDims;
     nvinfer1::Dims2 begPadding, endPadding;
     OnnxAttrs attrs(node, ctx);
     auto mode = attrs.get<std::string>("mode", "constant");
@@ -2115,6 +2457,25 @@ DEFINE_BUILTIN_OP_IMPORTER(Pad)
         }
     }
 
+    // Padding the input of a Conv or pooling node is common in exported models. Rather than adding a padding layer,
+    // pass the padding on to the consumer, which adds it to its own (see addFoldedPadding).
+    if (canFoldPad(ctx, node, mode, value, onnxPadding, nbDims))
+    {
+        std::vector<int>& foldedPads = ctx->foldedPads()[node.output(0)];
+        foldedPads.clear();
+        for (int i = 2; i < nbDims; ++i)
+        {
+            foldedPads.push_back(static_cast<int>(onnxPadding[i]));
+        }
+        for (int i = 2; i < nbDims; ++i)
+        {
+            foldedPads.push_back(static_cast<int>(onnxPadding[nbDims + i]));
+        }
+        LOG_VERBOSE("Folding Pad node " << node.name() << " into the padding of its consumer.");
+        RETURN_IDENTITY(inputs.at(0));
+    }
+
+    ASSERT(nbDims >= 4, ErrorCode::kUNSUPPORTED_NODE);
     ASSERT(mode == "constant" && value == 0.f && "This version of TensorRT only supports constant 0 padding!",
         ErrorCode::kUNSUPPORTED_NODE);
     ASSERT(convertOnnxPadding(onnxPadding, &begPadding, &endPadding)
@@ -2149,6 +2510,11 @@ DEFINE_BUILTIN_OP_IMPORTER(PRelu)
 
 DEFINE_BUILTIN_OP_IMPORTER(QuantizeLinear)
 {
+    if (canFoldQuantization(ctx, node, inputs))
+    {
+        return foldQuantizationHelper(ctx, node, inputs);
+    }
+
     ASSERT(inputs.size() == 3, nvonnxparser::ErrorCode::kINVALID_NODE);
     std::string name = node.name();
     // Input 0 can be a weights or a tensor
@@ -2437,60 +2803,201 @@ DEFINE_BUILTIN_OP_IMPORTER(Resize)
     nvinfer1::ITensor& input = convertToTensor(inputs.at(0), ctx);
     // TRT does not support INT32 nor BOOL input types for this node
     ASSERT(input.getType() != nvinfer1::DataType::kINT32 && input.getType() != nvinfer1::DataType::kBOOL, ErrorCode::kUNSUPPORTED_NODE);
-    int inputRank = input.getDimensions().nbDims;
+    const nvinfer1::Dims inputDims = input.getDimensions();
+    const int inputRank = inputDims.nbDims;
     ASSERT(inputRank > 0, ErrorCode::kUNSUPPORTED_NODE);
-    // Add resize layer
-    nvinfer1::IResizeLayer* layer = ctx->network()->addResize(input);
     OnnxAttrs attrs(node, ctx);
 
-    auto mode = attrs.get<std::string>("mode", "nearest");
-    auto resizeMode = mode == "nearest" ? nvinfer1::ResizeMode::kNEAREST : nvinfer1::ResizeMode::kLINEAR;
-    auto transformationMode = attrs.get<std::string>("coordinate_transformation_mode", "half_pixel");
+    // Before opset 11, Resize only had asymmetric coordinates, and nearest resizing rounded down.
+    const bool opset11 = ctx->getOpsetVersion() >= 11;
+    ResizeParams params;
+    params.mode = attrs.get<std::string>("mode", "nearest");
+    params.transformationMode
+        = opset11 ? attrs.get<std::string>("coordinate_transformation_mode", "half_pixel") : "asymmetric";
+    params.nearestMode = opset11 ? attrs.get<std::string>("nearest_mode", "round_prefer_floor") : "floor";
+    params.cubicCoeffA = attrs.get("cubic_coeff_a", -0.75f);
+    params.excludeOutside = attrs.get("exclude_outside", 0) != 0;
+    ASSERT((params.mode == "nearest" || params.mode == "linear" || params.mode == "cubic") && "Unknown resize mode!",
+        ErrorCode::kINVALID_NODE);
+    ASSERT(params.transformationMode != "tf_crop_and_resize" && "TensorRT does not support tf_crop_and_resize!",
+        ErrorCode::kUNSUPPORTED_NODE);
 
-    if (ctx->getOpsetVersion() >= 11)
+    // The output size comes from the sizes input if there is one, else from the scales.
+    // TensorRT output shapes cannot depend on floating-point tensor values, so scales must be an initializer.
+    const bool hasSizes = opset11 && inputs.size() == 4 && inputs.at(3);
+    std::vector<float> scales;
+    ShapeTensor sizes;
+    if (hasSizes)
     {
-        ASSERT(((transformationMode == "asymmetric") || (transformationMode == "align_corners")) && "This version of TensorRT only supports asymmetric and align_corners resize!",
-            ErrorCode::kUNSUPPORTED_NODE);
-        ASSERT(mode != "cubic" && "This version of TensorRT does not support cubic interpolation!",
-            ErrorCode::kUNSUPPORTED_NODE);
-        auto nearest_mode = attrs.get<std::string>("nearest_mode", "round_prefer_floor");
-        ASSERT((mode != "nearest" || nearest_mode == "floor")
-                && "This version of TensorRT only supports floor nearest_mode!",
-            ErrorCode::kUNSUPPORTED_NODE);
+        sizes = ShapeTensor(inputs.at(3));
+        ASSERT(sizes.size == inputRank, ErrorCode::kINVALID_NODE);
+    }
+    else
+    {
+        TensorOrWeights& scalesInput = inputs.at(opset11 ? 2 : 1);
+        ASSERT(scalesInput.is_weights() && "Resize scales must be an initializer!", ErrorCode::kUNSUPPORTED_NODE);
+        ShapedWeights const& scalesWeights = scalesInput.weights();
+        ASSERT(scalesWeights.shape.nbDims == 1 && scalesWeights.shape.d[0] == inputRank
+                && scalesWeights.type == ::ONNX_NAMESPACE::TensorProto::FLOAT,
+            ErrorCode::kINVALID_NODE);
+        float const* scaleValues = static_cast<float const*>(scalesWeights.values);
+        scales.assign(scaleValues, scaleValues + inputRank);
+    }
 
-        // The existence of a fourth input means a shape was passed as the resize parameter
-        if (inputs.size() == 4)
+    // Output sizes and scales of each axis, where known at parse time (-1 and 0 otherwise).
+    std::vector<int64_t> outSizes(inputRank, -1);
+    std::vector<double> axisScales(inputRank, 0.);
+    bool allStatic = true;
+    for (int axis = 0; axis < inputRank; ++axis)
+    {
+        const int64_t inSize = inputDims.d[axis];
+        if (hasSizes)
         {
-            auto* resizeShape = &convertToTensor(inputs.at(3), ctx);
-            layer->setInput(1, *resizeShape);
-            layer->setResizeMode(resizeMode);
-            if (transformationMode=="align_corners")
-                layer->setAlignCorners(true);
-            RETURN_FIRST_OUTPUT(layer);
+            outSizes[axis] = sizes.valuesKnown() ? sizes.values[axis] : -1;
+            axisScales[axis] = inSize > 0 && outSizes[axis] >= 0 ? static_cast<double>(outSizes[axis]) / inSize : 0.;
         }
+        else
+        {
+            axisScales[axis] = scales[axis];
+            outSizes[axis] = inSize >= 0 ? static_cast<int64_t>(std::floor(inSize * scales[axis])) : -1;
+        }
+        allStatic = allStatic && inSize >= 0 && outSizes[axis] >= 0 && axisScales[axis] > 0;
     }
 
-    // Resizes that use scale factors have the same import logic between opsets
-    ASSERT(transformationMode != "align_corners" && "Align_corners should use size information not scale factors!", ErrorCode::kUNSUPPORTED_NODE);
-    auto scales = ctx->getOpsetVersion() >= 11 ? inputs.at(2) : inputs.at(1);
-    ASSERT(scales.is_weights() && "Resize scales must be an initializer!", ErrorCode::kUNSUPPORTED_NODE);
-    ShapedWeights scales_weights = scales.weights();
-    ASSERT(scales_weights.shape.nbDims == 1, ErrorCode::kUNSUPPORTED_NODE);
-    int scaleSize = scales_weights.shape.d[0];
-    ASSERT(scaleSize == inputRank, ErrorCode::kINVALID_NODE);
-    float const* scaleValues = static_cast<float const*>(scales_weights.values);
-    if (resizeMode == nvinfer1::ResizeMode::kLINEAR)
+    // IResizeLayer handles nearest resizing with asymmetric coordinates rounded down, and linear resizing with
+    // asymmetric coordinates, or aligned corners given output sizes. Other nearest resizes often pick the same
+    // input values, which can be checked when all sizes are known.
+    bool useResizeLayer = false;
+    const std::string& transformationMode = params.transformationMode;
+    if (params.mode == "nearest")
     {
-        ASSERT(canUseLinearResize(scaleSize, scaleValues),
-            ErrorCode::kUNSUPPORTED_NODE);
+        useResizeLayer = transformationMode == "asymmetric" && params.nearestMode == "floor";
+        if (!useResizeLayer && allStatic)
+        {
+            ResizeParams floorParams = params;
+            floorParams.transformationMode = "asymmetric";
+            floorParams.nearestMode = "floor";
+            useResizeLayer = true;
+            for (int axis = 0; axis < inputRank && useResizeLayer; ++axis)
+            {
+                useResizeLayer
+                    = computeResizeTaps(params, inputDims.d[axis], outSizes[axis], axisScales[axis]).indices
+                    == computeResizeTaps(floorParams, inputDims.d[axis], outSizes[axis], axisScales[axis]).indices;
+            }
+        }
     }
-    layer->setResizeMode(resizeMode);
-    layer->setScales(scaleValues, inputRank);
-    RETURN_FIRST_OUTPUT(layer);
+    else if (params.mode == "linear")
+    {
+        useResizeLayer = (transformationMode == "asymmetric" && (hasSizes || canUseLinearResize(scales.size(), scales.data())))
+            || (transformationMode == "align_corners" && hasSizes);
+    }
+
+    if (useResizeLayer)
+    {
+        LOG_VERBOSE("Resize: using resize layer.");
+        nvinfer1::IResizeLayer* layer = ctx->network()->addResize(input);
+        layer->setResizeMode(params.mode == "nearest" ? nvinfer1::ResizeMode::kNEAREST : nvinfer1::ResizeMode::kLINEAR);
+        layer->setAlignCorners(transformationMode == "align_corners");
+        if (hasSizes)
+        {
+            layer->setInput(1, sizes.tensor(ctx));
+        }
+        else
+        {
+            layer->setScales(scales.data(), inputRank);
+        }
+        RETURN_FIRST_OUTPUT(layer);
+    }
+
+    // Otherwise, resize one axis at a time by gathering the input values each output value is interpolated from.
+    LOG_VERBOSE("Resize: using gather-based " << params.mode << " interpolation with " << transformationMode
+                                              << " coordinates.");
+    const nvinfer1::DataType type = input.getType();
+    const ShapeTensor inputShape = shapeOf(ctx, input);
+    nvinfer1::ITensor* output = &input;
+    for (int axis = 0; axis < inputRank; ++axis)
+    {
+        std::vector<nvinfer1::ITensor*> indices;
+        std::vector<nvinfer1::ITensor*> weights;
+        const int64_t inSize = inputDims.d[axis];
+        if (inSize >= 0 && outSizes[axis] >= 0)
+        {
+            const ResizeTaps taps = computeResizeTaps(params, inSize, outSizes[axis], axisScales[axis]);
+            if (isIdentityResize(taps, inSize))
+            {
+                continue;
+            }
+            const nvinfer1::Dims indicesDims{1, {static_cast<int>(outSizes[axis])}};
+            nvinfer1::Dims weightsDims = makeDims(inputRank, 1);
+            weightsDims.d[axis] = outSizes[axis];
+            for (size_t k = 0; k < taps.indices.size(); ++k)
+            {
+                indices.push_back(addConstant(ctx, taps.indices[k], ::ONNX_NAMESPACE::TensorProto::INT32, indicesDims)
+                                      ->getOutput(0));
+                if (!taps.weights.empty())
+                {
+                    nvinfer1::ITensor* weight
+                        = addConstant(ctx, taps.weights[k], ::ONNX_NAMESPACE::TensorProto::FLOAT, weightsDims)
+                              ->getOutput(0);
+                    if (type != nvinfer1::DataType::kFLOAT)
+                    {
+                        nvinfer1::IIdentityLayer* cast = ctx->network()->addIdentity(*weight);
+                        cast->setOutputType(0, type);
+                        weight = cast->getOutput(0);
+                    }
+                    weights.push_back(weight);
+                }
+            }
+        }
+        else
+        {
+            // Unit scales leave the axis unchanged, except for the shifted tf_half_pixel_for_nn coordinates.
+            if (axisScales[axis] == 1 && transformationMode != "tf_half_pixel_for_nn")
+            {
+                continue;
+            }
+            const ShapeTensor inLength = gather(ctx, inputShape, shapeVector(axis));
+            ShapeTensor outLength;
+            nvinfer1::ITensor* scale{nullptr};
+            if (hasSizes)
+            {
+                outLength = gather(ctx, sizes, shapeVector(axis));
+                nvinfer1::IIdentityLayer* outFloat = ctx->network()->addIdentity(outLength.tensor(ctx));
+                outFloat->setOutputType(0, nvinfer1::DataType::kFLOAT);
+                nvinfer1::IIdentityLayer* inFloat = ctx->network()->addIdentity(inLength.tensor(ctx));
+                inFloat->setOutputType(0, nvinfer1::DataType::kFLOAT);
+                scale = ctx->network()
+                            ->addElementWise(*outFloat->getOutput(0), *inFloat->getOutput(0),
+                                nvinfer1::ElementWiseOperation::kDIV)
+                            ->getOutput(0);
+            }
+            else
+            {
+                int64_t num{0};
+                int64_t den{0};
+                ASSERT(getDyadicScale(scales[axis], num, den)
+                        && "Resize scales of dynamic axes must be multiples of 1/256!",
+                    ErrorCode::kUNSUPPORTED_NODE);
+                outLength = floorDiv(ctx, mul(ctx, inLength, shapeVector(num)), shapeVector(den));
+                scale = addConstantScalar(ctx, scales[axis], ::ONNX_NAMESPACE::TensorProto::FLOAT, nvinfer1::Dims{1, {1}})
+                            ->getOutput(0);
+            }
+            TRT_CHECK(addDynamicResizeTaps(
+                ctx, params, inLength, outLength, *scale, inputRank, axis, type, indices, weights));
+        }
+        output = applyResizeTaps(ctx, *output, axis, indices, weights);
+    }
+    return {{output}};
 }
 
 DEFINE_BUILTIN_OP_IMPORTER(RNN)
 {
+    if (canUseRNNv2(ctx, node, inputs))
+    {
+        LOG_VERBOSE("RNN: using fused RNNv2 layer.");
+        return rnnv2Helper(ctx, node, inputs);
+    }
+
     OnnxAttrs attrs{node, ctx};
 
     const std::string direction = attrs.get<std::string>("direction", "forward");
@@ -2941,27 +3448,7 @@ DEFINE_BUILTIN_OP_IMPORTER(Slice)
 
 DEFINE_BUILTIN_OP_IMPORTER(Softmax)
 {
-    OnnxAttrs attrs(node, ctx);
-    // "input : T"
-    nvinfer1::ITensor& input = convertToTensor(inputs.at(0), ctx);
-    const ShapeTensor dims = shapeOf(ctx, input);
-
-    // "axis : int (default is 1)"
-    int axis = attrs.get("axis", 1);
-
-    // "Negative value means counting dimensions from the back.
-    // Accepted range is [-r, r-1] where r = rank(input)."
-    TRT_CHECK(convertAxis(axis, dims.size));
-
-    // "The input does not need to explicitly be a 2D vector; rather, it will be coerced into one."
-    auto* flattened = flattenTensor(ctx, input, axis);
-    auto* softMax = ctx->network()->addSoftMax(*flattened);
-    // ONNX softmax is always on second dimension.
-    softMax->setAxes(1 << 1);
-
-    // Reshape back to original shape
-    auto* reshapeLayer = addShuffle(ctx, *softMax->getOutput(0), dims);
-    RETURN_FIRST_OUTPUT(reshapeLayer);
+    return softmaxHelper(ctx, node, inputs, /*isLogSoftmax=*/false);
 }
 
 DEFINE_BUILTIN_OP_IMPORTER(Softplus)
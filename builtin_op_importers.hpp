@@ -28,6 +28,8 @@
 namespace onnx2trt
 {
 
-string_map<NodeImporter>& getBuiltinOpImporterMap();
+// Returns the registry of builtin importers. It is populated during static initialization and is read-only
+// afterwards, so it can safely be shared between parsers running on different threads.
+const string_map<NodeImporter>& getBuiltinOpImporterMap();
 
 } // namespace onnx2trt
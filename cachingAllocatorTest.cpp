@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <vector>
+#include "onnx_trt_backend_allocator.hpp"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+    cout << "FAILED: " << what << endl;
+    ++failures;
+  }
+}
+
+// Host allocator that fails once a given number of bytes is outstanding, to
+// exercise the release-and-retry path.
+class LimitedHostAllocator : public onnx2trt::HostRawAllocator {
+public:
+  explicit LimitedHostAllocator(size_t limit) : limit_(limit) {}
+  void* Allocate(size_t size) override {
+    if (outstanding_ + size > limit_) {
+      return nullptr;
+    }
+    outstanding_ += size;
+    sizes_.emplace_back(HostRawAllocator::Allocate(size), size);
+    return sizes_.back().first;
+  }
+  void Free(void* ptr) override {
+    for (auto it = sizes_.begin(); it != sizes_.end(); ++it) {
+      if (it->first == ptr) {
+        outstanding_ -= it->second;
+        sizes_.erase(it);
+        break;
+      }
+    }
+    HostRawAllocator::Free(ptr);
+  }
+
+private:
+  size_t limit_;
+  size_t outstanding_{0};
+  std::vector<std::pair<void*, size_t>> sizes_;
+};
+
+void testSizeClasses() {
+  using onnx2trt::CachingAllocator;
+  check(CachingAllocator::SizeClass(1) == 256, "small sizes use the smallest class");
+  check(CachingAllocator::SizeClass(256) == 256, "exact class");
+  check(CachingAllocator::SizeClass(257) == 320, "four classes per power of two");
+  check(CachingAllocator::SizeClass(1000) == 1024, "class below a power of two");
+  check(CachingAllocator::SizeClass(1025) == 1280, "class above a power of two");
+  for (size_t size = 1; size < (1 << 20); size = size * 3 / 2 + 1) {
+    const size_t sizeClass = CachingAllocator::SizeClass(size);
+    check(sizeClass >= size && (size <= 256 || sizeClass - size < size / 4 + 1), "class covers size with bounded waste");
+  }
+}
+
+void testReuse() {
+  onnx2trt::CachingAllocator allocator(std::unique_ptr<onnx2trt::RawAllocator>(new onnx2trt::HostRawAllocator));
+  void* a = allocator.Allocate(1000);
+  void* b = allocator.Allocate(5000);
+  check(a && b && a != b, "distinct buffers");
+  std::memset(a, 1, 1000);
+  std::memset(b, 2, 5000);
+  allocator.Free(a);
+  allocator.Free(b);
+  // Rebinding the same shapes, as onnxSetGraphIO does, must not allocate again
+  void* c = allocator.Allocate(1000);
+  void* d = allocator.Allocate(4900);
+  check(c == a && d == b, "buffers are reused within a size class");
+  auto stats = allocator.stats();
+  check(stats.num_allocations == 4 && stats.num_cache_hits == 2 && stats.num_raw_allocations == 2,
+      "allocation counts");
+  check(stats.allocated_bytes == 1024 + 5120 && stats.reserved_bytes == stats.allocated_bytes, "byte counts");
+  allocator.Free(c);
+  allocator.Free(d);
+  check(allocator.stats().allocated_bytes == 0 && allocator.stats().peak_allocated_bytes == 1024 + 5120,
+      "high-water mark survives frees");
+  allocator.ReleaseCached();
+  stats = allocator.stats();
+  check(stats.reserved_bytes == 0 && stats.num_raw_frees == 2, "release returns cached buffers");
+  allocator.Free(nullptr);
+}
+
+void testRetryAfterRelease() {
+  onnx2trt::CachingAllocator allocator(std::unique_ptr<onnx2trt::RawAllocator>(new LimitedHostAllocator(4096)));
+  void* a = allocator.Allocate(3000);
+  check(a != nullptr, "first allocation");
+  allocator.Free(a);
+  // The cached 3072-byte buffer must be released to make room for this one
+  void* b = allocator.Allocate(2000);
+  check(b != nullptr, "allocation succeeds after releasing the cache");
+  check(allocator.stats().num_raw_frees == 1, "cached buffer was released");
+  check(allocator.Allocate(4000) == nullptr, "allocation beyond the limit fails");
+  allocator.Free(b);
+}
+
+} // namespace
+
+int main() {
+  testSizeClasses();
+  testReuse();
+  testRetryAfterRelease();
+  if (failures) {
+    cout << failures << " check(s) failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}
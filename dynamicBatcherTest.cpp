@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "onnx_trt_backend_batcher.hpp"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+int failures = 0;
+// Guards the logs, which the batchers' threads append to
+std::mutex logMutex;
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+    cout << "FAILED: " << what << endl;
+    ++failures;
+  }
+}
+
+// Executor on the CPU for a model with one float input and two float outputs
+// per row: the sum of the row's input and twice its first element. It logs
+// its calls, so that tests can check how requests were batched.
+class FakeExecutor : public onnx2trt::BatchExecutor {
+public:
+  FakeExecutor(size_t max_batch_size, size_t row_length, std::vector<std::string>* log)
+      : max_batch_size_(max_batch_size), row_length_(row_length), input_row_sizes_{row_length * sizeof(float)},
+        output_row_sizes_{sizeof(float), sizeof(float)}, input_(max_batch_size * row_length), log_(log) {}
+
+  size_t max_batch_size() const override { return max_batch_size_; }
+  const std::vector<size_t>& input_row_sizes() const override { return input_row_sizes_; }
+  const std::vector<size_t>& output_row_sizes() const override { return output_row_sizes_; }
+
+  std::vector<void*> BeginBatch() override { return {input_.data()}; }
+
+  bool Launch(size_t batch_size) override {
+    Log("launch " + std::to_string(batch_size));
+    sums_.assign(batch_size, 0.f);
+    doubled_.assign(batch_size, 0.f);
+    for (size_t r = 0; r < batch_size; ++r) {
+      for (size_t i = 0; i < row_length_; ++i) {
+        sums_[r] += input_[r * row_length_ + i];
+      }
+      doubled_[r] = 2.f * input_[r * row_length_];
+    }
+    return true;
+  }
+
+  bool CopyOutputs(size_t row, size_t rows, const std::vector<void*>& outputs) override {
+    Log("copy " + std::to_string(row) + "+" + std::to_string(rows));
+    std::memcpy(outputs[0], sums_.data() + row, rows * sizeof(float));
+    std::memcpy(outputs[1], doubled_.data() + row, rows * sizeof(float));
+    return true;
+  }
+
+private:
+  void Log(const std::string& entry) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    log_->push_back(entry);
+  }
+
+  size_t max_batch_size_;
+  size_t row_length_;
+  std::vector<size_t> input_row_sizes_;
+  std::vector<size_t> output_row_sizes_;
+  std::vector<float> input_;
+  std::vector<float> sums_;
+  std::vector<float> doubled_;
+  std::vector<std::string>* log_;
+};
+
+// A request of rows rows of row_length floats, whose row r is all first + r
+struct Request {
+  Request(size_t rows, size_t row_length, float first, std::vector<std::string>* log, const std::string& name)
+      : input(rows * row_length), sums(rows), doubled(rows) {
+    for (size_t r = 0; r < rows; ++r) {
+      for (size_t i = 0; i < row_length; ++i) {
+        input[r * row_length + i] = first + r;
+      }
+    }
+    request.rows = rows;
+    request.inputs = {input.data()};
+    request.outputs = {sums.data(), doubled.data()};
+    request.done = [this, log, name](bool ok) {
+      {
+        std::lock_guard<std::mutex> lock(logMutex);
+        log->push_back("done " + name);
+      }
+      finished.set_value(ok);
+    };
+  }
+
+  bool correct(size_t row_length, float first) const {
+    for (size_t r = 0; r < sums.size(); ++r) {
+      if (sums[r] != row_length * (first + r) || doubled[r] != 2.f * (first + r)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  std::vector<float> input;
+  std::vector<float> sums;
+  std::vector<float> doubled;
+  onnx2trt::BatchRequest request;
+  std::promise<bool> finished;
+};
+
+void testCoalescesUntilFull() {
+  std::vector<std::string> log;
+  Request a(2, 3, 1.f, &log, "a");
+  Request b(1, 3, 10.f, &log, "b");
+  Request c(3, 3, 20.f, &log, "c");
+  {
+    // The delay is long enough that only a full batch can launch before the
+    // requests are checked
+    onnx2trt::DynamicBatcher batcher(
+        std::unique_ptr<onnx2trt::BatchExecutor>(new FakeExecutor(6, 3, &log)), std::chrono::seconds(10));
+    check(batcher.Submit(a.request) && batcher.Submit(b.request) && batcher.Submit(c.request), "requests queued");
+    check(a.finished.get_future().get() && b.finished.get_future().get() && c.finished.get_future().get(),
+        "requests succeed");
+    check(a.correct(3, 1.f) && b.correct(3, 10.f) && c.correct(3, 20.f), "outputs are scattered to their requests");
+    const auto stats = batcher.stats();
+    check(stats.num_batches == 1 && stats.num_requests == 3 && stats.num_rows == 6, "one full batch");
+  }
+  // Each request is completed before the next one's outputs are copied
+  const std::vector<std::string> expected{"launch 6", "copy 0+2", "done a", "copy 2+1", "done b", "copy 3+3", "done c"};
+  check(log == expected, "requests complete as soon as their slice is copied");
+}
+
+void testLaunchesAtDeadline() {
+  std::vector<std::string> log;
+  Request a(1, 4, 5.f, &log, "a");
+  onnx2trt::DynamicBatcher batcher(
+      std::unique_ptr<onnx2trt::BatchExecutor>(new FakeExecutor(8, 4, &log)), std::chrono::milliseconds(5));
+  const auto start = std::chrono::steady_clock::now();
+  check(batcher.Submit(a.request), "request queued");
+  check(a.finished.get_future().get(), "request succeeds");
+  check(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(5), "partial batch waits for the delay");
+  check(a.correct(4, 5.f), "output of a partial batch");
+  check(batcher.stats().num_rows == 1, "partial batch has the request's rows only");
+}
+
+void testRequestsAreNotSplit() {
+  std::vector<std::string> log;
+  Request a(3, 1, 0.f, &log, "a");
+  Request b(3, 1, 100.f, &log, "b");
+  Request tooLarge(5, 1, 0.f, &log, "tooLarge");
+  {
+    onnx2trt::DynamicBatcher batcher(
+        std::unique_ptr<onnx2trt::BatchExecutor>(new FakeExecutor(4, 1, &log)), std::chrono::milliseconds(1));
+    check(!batcher.Submit(tooLarge.request), "requests larger than the max batch size are rejected");
+    check(batcher.Submit(a.request) && batcher.Submit(b.request), "requests queued");
+    check(a.finished.get_future().get() && b.finished.get_future().get(), "requests succeed");
+    check(a.correct(1, 0.f) && b.correct(1, 100.f), "outputs of consecutive batches");
+    check(batcher.stats().num_batches == 2, "requests that do not fit together run in separate batches");
+  }
+  check(log.front() == "launch 3", "batches hold whole requests");
+}
+
+} // namespace
+
+int main() {
+  testCoalescesUntilFull();
+  testLaunchesAtDeadline();
+  testRequestsAreNotSplit();
+  if (failures) {
+    cout << failures << " check(s) failed" << endl;
+    return 1;
+  }
+  cout << "All checks passed" << endl;
+  return 0;
+}
@@ -38,6 +38,7 @@ void print_usage() {
        << "If it isn't, a list of supported subgraphs and unsupported operations will be printed." << endl;
   cout << "Usage: getSupportedAPITest -m onnx_model.pb" << endl;
   cout << "Optional argument: -e TRT_engine" << endl;
+  cout << "Optional argument: -a (only analyze the model; no TensorRT network is built)" << endl;
 }
 
 void printSubGraphs(SubGraphCollection_t& subGraphs, ::ONNX_NAMESPACE::ModelProto onnx_model)
@@ -83,7 +84,8 @@ int main(int argc, char* argv[]) {
     size_t max_batch_size = 32;
     size_t max_workspace_size = 1 << 30;
     int verbosity = (int)nvinfer1::ILogger::Severity::kWARNING;
-    while ((c = getopt (argc, argv, "m:e:")) != -1)
+    bool analyze_only = false;
+    while ((c = getopt (argc, argv, "m:e:a")) != -1)
     {
         switch(c)
         {
@@ -93,6 +95,9 @@ int main(int argc, char* argv[]) {
             case 'e':
                     engine_filename = optarg;
                     break;
+            case 'a':
+                    analyze_only = true;
+                    break;
         }
     }
 
@@ -102,15 +107,6 @@ int main(int argc, char* argv[]) {
         return -1;
     }
 
-    common::TRT_Logger trt_logger((nvinfer1::ILogger::Severity)verbosity);
-
-    auto trt_builder = common::infer_object(nvinfer1::createInferBuilder(trt_logger));
-
-    auto trt_network = common::infer_object(trt_builder->createNetworkV2(1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH)));
-    auto trt_parser  = common::infer_object(nvonnxparser::createParser(*trt_network, trt_logger));
-
-    initLibNvInferPlugins(&trt_logger, "");
-
     cout << "Parsing model: " << onnx_filename << endl;
     
     std::ifstream onnx_file(onnx_filename.c_str(),
@@ -133,6 +129,35 @@ int main(int argc, char* argv[]) {
 
     SubGraphCollection_t SubGraphCollection;
 
+    // analyzeModel() only checks the nodes statically, and reports every unsupported node. It needs neither a
+    // builder nor a GPU, so it runs before they are created.
+    if (analyze_only)
+    {
+        std::vector<nvonnxparser::UnsupportedNode> unsupported_nodes;
+        bool supported = nvonnxparser::analyzeModel(onnx_buf.data(), onnx_buf.size(), SubGraphCollection,
+                                                    &unsupported_nodes);
+        for (auto const& unsupported : unsupported_nodes)
+        {
+            cout << "Unsupported node " << unsupported.node;
+            if (unsupported.node != -1)
+            {
+                cout << " [" << onnx_model.graph().node(unsupported.node).op_type() << "]";
+            }
+            cout << ": " << unsupported.desc << endl;
+        }
+        printSubGraphs(SubGraphCollection, onnx_model);
+        return supported ? 0 : -1;
+    }
+
+    common::TRT_Logger trt_logger((nvinfer1::ILogger::Severity)verbosity);
+
+    auto trt_builder = common::infer_object(nvinfer1::createInferBuilder(trt_logger));
+
+    auto trt_network = common::infer_object(trt_builder->createNetworkV2(1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH)));
+    auto trt_parser  = common::infer_object(nvonnxparser::createParser(*trt_network, trt_logger));
+
+    initLibNvInferPlugins(&trt_logger, "");
+
     // supportsModel() parses the graph and returns a list of supported subgraphs.
     if (!trt_parser->supportsModel(onnx_buf.data(), onnx_buf.size(), SubGraphCollection))
     {
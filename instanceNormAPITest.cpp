@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "NvInferPlugin.h"
+#include "NvOnnxParser.h"
+#include "apiTestHelpers.hpp"
+#include "common.hpp"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+constexpr int kCHANNELS = 3;
+constexpr float kEPSILON = 1e-5f;
+
+// Spatial dimensions of a (1, C, ...) input.
+using Shape = std::vector<int>;
+
+// Shapes to test for one input rank. The optimization profile of the dynamic model spans minShape to maxShape, and
+// the static model is built for optShape.
+struct RankCase {
+  Shape minShape;
+  Shape optShape;
+  Shape maxShape;
+  std::vector<Shape> shapes;
+};
+
+void print_usage() {
+  cout << "This program checks the InstanceNormalization importer against a CPU reference on 3D, 4D and 5D inputs, "
+       << "both for static input shapes (InstanceNormalization_TRT plugin) and for dynamic spatial dimensions "
+       << "(reduce-based import)." << endl;
+  cout << "Usage: instanceNormAPITest [-t tolerance (default 1e-3)] [-v]" << endl;
+}
+
+nvinfer1::Dims inputDims(Shape const& shape) {
+  std::vector<int> dims{1, kCHANNELS};
+  dims.insert(dims.end(), shape.begin(), shape.end());
+  return apitest::makeDims(dims);
+}
+
+std::string toString(Shape const& shape) {
+  std::string text;
+  for (int d : shape) {
+    text += (text.empty() ? "" : "x") + std::to_string(d);
+  }
+  return text;
+}
+
+// Builds a model with a single InstanceNormalization node on a (1, C, ...) input with the given spatial dimensions.
+// If dynamic, all spatial dimensions are dynamic instead.
+::ONNX_NAMESPACE::ModelProto makeModel(std::vector<float> const& scale, std::vector<float> const& bias,
+                                       Shape const& shape, bool dynamic) {
+  ::ONNX_NAMESPACE::ModelProto model = apitest::makeModel("instance_norm");
+  ::ONNX_NAMESPACE::GraphProto* graph = model.mutable_graph();
+  std::vector<int64_t> dims{1, kCHANNELS};
+  for (int d : shape) {
+    dims.push_back(dynamic ? -1 : d);
+  }
+  apitest::addInput(graph, "x", dims);
+  apitest::addOutput(graph, "y", &dims);
+  apitest::addInitializer(graph, "scale", scale);
+  apitest::addInitializer(graph, "bias", bias);
+  ::ONNX_NAMESPACE::NodeProto* node = apitest::addNode(graph, "InstanceNormalization", {"x", "scale", "bias"}, {"y"});
+  apitest::addFloatAttribute(node, "epsilon", kEPSILON);
+  return model;
+}
+
+std::vector<float> reference(std::vector<float> const& x, std::vector<float> const& scale,
+                             std::vector<float> const& bias) {
+  const size_t planeSize = x.size() / kCHANNELS;
+  std::vector<float> y(x.size());
+  for (int c = 0; c < kCHANNELS; ++c) {
+    const float* plane = x.data() + c * planeSize;
+    double mean = 0;
+    for (size_t i = 0; i < planeSize; ++i) {
+      mean += plane[i];
+    }
+    mean /= planeSize;
+    double variance = 0;
+    for (size_t i = 0; i < planeSize; ++i) {
+      variance += (plane[i] - mean) * (plane[i] - mean);
+    }
+    variance /= planeSize;
+    const double invStdDev = 1.0 / std::sqrt(variance + kEPSILON);
+    for (size_t i = 0; i < planeSize; ++i) {
+      y[c * planeSize + i] = static_cast<float>((plane[i] - mean) * invStdDev * scale[c] + bias[c]);
+    }
+  }
+  return y;
+}
+
+// Runs the engine on each shape and returns the number of shapes whose output differs from the reference.
+int checkEngine(nvinfer1::ICudaEngine& engine, std::vector<Shape> const& shapes, std::vector<float> const& scale,
+                std::vector<float> const& bias, float tolerance, std::mt19937& rng) {
+  auto context = common::infer_object(engine.createExecutionContext());
+  int failures = 0;
+  for (Shape const& shape : shapes) {
+    const nvinfer1::Dims dims = inputDims(shape);
+    const std::vector<float> x = apitest::randomValues(apitest::volume(dims), rng);
+    std::map<std::string, apitest::HostTensor> outputs;
+    const bool ok = apitest::execute(*context, {{"x", {dims, x}}}, outputs);
+    const float maxError = ok ? apitest::maxAbsError(outputs["y"].values, reference(x, scale, bias)) : 0.f;
+    const bool passed = ok && maxError <= tolerance;
+    cout << "  " << toString(shape) << ": " << (ok ? "" : "execution failed, ") << "max abs error " << maxError
+         << (passed ? " PASSED" : " FAILED") << endl;
+    failures += passed ? 0 : 1;
+  }
+  return failures;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    apitest::Options options;
+    if (!apitest::parseOptions(argc, argv, options, print_usage))
+    {
+        return 0;
+    }
+
+    common::TRT_Logger trt_logger(options.verbose ? nvinfer1::ILogger::Severity::kVERBOSE
+                                                  : nvinfer1::ILogger::Severity::kWARNING);
+    initLibNvInferPlugins(&trt_logger, "");
+    auto trt_builder = common::infer_object(nvinfer1::createInferBuilder(trt_logger));
+    const auto explicitBatch = 1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+
+    const std::vector<float> scale{1.f, 0.5f, -2.f};
+    const std::vector<float> bias{0.f, 1.f, -0.25f};
+    std::mt19937 rng(0);
+    const std::vector<RankCase> rankCases{
+        {{2}, {128}, {256}, {{2}, {37}, {128}, {256}}},
+        {{2, 2}, {32, 32}, {64, 64}, {{2, 2}, {7, 13}, {32, 32}, {64, 17}, {64, 64}}},
+        {{2, 2, 2}, {8, 8, 8}, {16, 16, 16}, {{2, 2, 2}, {3, 5, 7}, {8, 8, 8}, {16, 4, 16}, {16, 16, 16}}},
+    };
+
+    int failures = 0;
+    for (RankCase const& rankCase : rankCases)
+    {
+        for (bool dynamic : {false, true})
+        {
+            std::vector<Shape> const& testShapes = dynamic ? rankCase.shapes : std::vector<Shape>{rankCase.optShape};
+            cout << (dynamic ? "Dynamic" : "Static") << " " << rankCase.optShape.size() + 2 << "D input shape:"
+                 << endl;
+
+            auto trt_network = common::infer_object(trt_builder->createNetworkV2(explicitBatch));
+            auto trt_parser = common::infer_object(nvonnxparser::createParser(*trt_network, trt_logger));
+            if (!apitest::parseModel(*trt_parser, makeModel(scale, bias, rankCase.optShape, dynamic)))
+            {
+                ++failures;
+                continue;
+            }
+
+            auto trt_config = common::infer_object(trt_builder->createBuilderConfig());
+            if (dynamic)
+            {
+                apitest::addProfile(*trt_builder, *trt_config, "x", inputDims(rankCase.minShape),
+                    inputDims(rankCase.optShape), inputDims(rankCase.maxShape));
+            }
+            auto trt_engine = apitest::buildEngine(*trt_builder, *trt_network, *trt_config);
+            if (!trt_engine)
+            {
+                ++failures;
+                continue;
+            }
+            failures += checkEngine(*trt_engine, testShapes, scale, bias, options.tolerance, rng);
+        }
+    }
+
+    cout << (failures ? "FAILED" : "PASSED") << endl;
+    return failures ? 1 : 0;
+}
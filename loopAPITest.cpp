@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "NvInferPlugin.h"
+#include "NvOnnxParser.h"
+#include "apiTestHelpers.hpp"
+#include "common.hpp"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+// The loop bound is N = length(data) - kOFFSET, so that short inputs give zero and negative bounds.
+constexpr int64_t kOFFSET = 3;
+constexpr int64_t kTRIP_COUNT = 4;
+const std::vector<float> kINITIAL_STATE{0.5f, -1.f};
+
+void print_usage() {
+  cout << "This program checks the scan outputs of a Loop whose condition is (iteration_num < N). The body computes "
+       << "the condition of the next iteration, so the loop runs max(N, 0) + 1 times, or the trip count if that is "
+       << "smaller." << endl;
+  cout << "Usage: loopAPITest [-t tolerance (default 1e-3)] [-v]" << endl;
+}
+
+// Builds a model with a Loop that counts up a state vector and scans its values, while iteration_num < N. N is
+// computed from the dynamic length of the input data, so it is only known at runtime.
+::ONNX_NAMESPACE::ModelProto makeModel(bool withTripCount) {
+  ::ONNX_NAMESPACE::ModelProto model = apitest::makeModel("loop");
+  ::ONNX_NAMESPACE::GraphProto* graph = model.mutable_graph();
+  apitest::addInput(graph, "data", {-1});
+  apitest::addOutput(graph, "x_final");
+  apitest::addOutput(graph, "scan");
+  apitest::addInitializer(graph, "offset", std::vector<int64_t>{kOFFSET});
+  apitest::addInitializer(graph, "x0", kINITIAL_STATE);
+  apitest::addInitializer(graph, "one", std::vector<float>{1.f});
+  apitest::addScalarInitializer(graph, "cond", ::ONNX_NAMESPACE::TensorProto::BOOL)->add_int32_data(1);
+  apitest::addScalarInitializer(graph, "trip", ::ONNX_NAMESPACE::TensorProto::INT64)->add_int64_data(kTRIP_COUNT);
+  apitest::addNode(graph, "Shape", {"data"}, {"length"});
+  apitest::addNode(graph, "Sub", {"length", "offset"}, {"n"});
+
+  ::ONNX_NAMESPACE::GraphProto body;
+  body.set_name("loop_body");
+  const std::vector<int64_t> scalar{};
+  const std::vector<int64_t> state{static_cast<int64_t>(kINITIAL_STATE.size())};
+  apitest::addInput(&body, "i", scalar, ::ONNX_NAMESPACE::TensorProto::INT64);
+  apitest::addInput(&body, "cond_in", scalar, ::ONNX_NAMESPACE::TensorProto::BOOL);
+  apitest::addInput(&body, "x_state", state);
+  apitest::addOutput(&body, "cond_out", nullptr, ::ONNX_NAMESPACE::TensorProto::BOOL);
+  apitest::addOutput(&body, "x_out", &state);
+  apitest::addOutput(&body, "scan_out", &state);
+  apitest::addNode(&body, "Less", {"i", "n"}, {"cond_out"});
+  apitest::addNode(&body, "Add", {"x_state", "one"}, {"x_out"});
+  apitest::addNode(&body, "Identity", {"x_state"}, {"scan_out"});
+
+  ::ONNX_NAMESPACE::NodeProto* loop
+      = apitest::addNode(graph, "Loop", {withTripCount ? "trip" : "", "cond", "x0"}, {"x_final", "scan"});
+  apitest::addGraphAttribute(loop, "body", body);
+  return model;
+}
+
+// Runs the engine for each input length and returns the number of lengths whose outputs differ from the reference.
+int checkEngine(nvinfer1::ICudaEngine& engine, bool withTripCount, std::vector<int> const& lengths, float tolerance,
+                std::mt19937& rng) {
+  auto context = common::infer_object(engine.createExecutionContext());
+  const int stateSize = kINITIAL_STATE.size();
+  int failures = 0;
+  for (int length : lengths) {
+    const int64_t n = length - kOFFSET;
+    int64_t iterations = std::max<int64_t>(n, 0) + 1;
+    if (withTripCount) {
+      iterations = std::min(iterations, kTRIP_COUNT);
+    }
+    std::vector<float> expectedScan;
+    for (int64_t k = 0; k < iterations; ++k) {
+      for (float value : kINITIAL_STATE) {
+        expectedScan.push_back(value + k);
+      }
+    }
+    std::vector<float> expectedFinal;
+    for (float value : kINITIAL_STATE) {
+      expectedFinal.push_back(value + iterations);
+    }
+
+    const nvinfer1::Dims dims = apitest::makeDims({length});
+    std::map<std::string, apitest::HostTensor> outputs;
+    bool ok = apitest::execute(*context, {{"data", {dims, apitest::randomValues(length, rng)}}}, outputs);
+    const nvinfer1::Dims scanDims = outputs["scan"].dims;
+    ok = ok && scanDims.nbDims == 2 && scanDims.d[0] == iterations && scanDims.d[1] == stateSize;
+    const float maxError = ok ? std::max(apitest::maxAbsError(outputs["scan"].values, expectedScan),
+                                         apitest::maxAbsError(outputs["x_final"].values, expectedFinal))
+                              : 0.f;
+    const bool passed = ok && maxError <= tolerance;
+    cout << "  N = " << n << ": " << (ok ? "" : "wrong scan output shape or execution failed, ") << scanDims.d[0]
+         << " rows, expected " << iterations << ", max abs error " << maxError << (passed ? " PASSED" : " FAILED")
+         << endl;
+    failures += passed ? 0 : 1;
+  }
+  return failures;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    apitest::Options options;
+    if (!apitest::parseOptions(argc, argv, options, print_usage))
+    {
+        return 0;
+    }
+
+    common::TRT_Logger trt_logger(options.verbose ? nvinfer1::ILogger::Severity::kVERBOSE
+                                                  : nvinfer1::ILogger::Severity::kWARNING);
+    initLibNvInferPlugins(&trt_logger, "");
+    auto trt_builder = common::infer_object(nvinfer1::createInferBuilder(trt_logger));
+    const auto explicitBatch = 1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+
+    // N from -2 to 7, which covers bounds below, at and above the trip count.
+    const std::vector<int> lengths{1, 3, 4, 5, 6, 7, 10};
+    std::mt19937 rng(0);
+
+    int failures = 0;
+    for (bool withTripCount : {false, true})
+    {
+        cout << (withTripCount ? "With" : "Without") << " trip count:" << endl;
+
+        auto trt_network = common::infer_object(trt_builder->createNetworkV2(explicitBatch));
+        auto trt_parser = common::infer_object(nvonnxparser::createParser(*trt_network, trt_logger));
+        if (!apitest::parseModel(*trt_parser, makeModel(withTripCount)))
+        {
+            ++failures;
+            continue;
+        }
+
+        auto trt_config = common::infer_object(trt_builder->createBuilderConfig());
+        apitest::addProfile(*trt_builder, *trt_config, "data", apitest::makeDims({1}), apitest::makeDims({4}),
+            apitest::makeDims({16}));
+        auto trt_engine = apitest::buildEngine(*trt_builder, *trt_network, *trt_config);
+        if (!trt_engine)
+        {
+            ++failures;
+            continue;
+        }
+        failures += checkEngine(*trt_engine, withTripCount, lengths, options.tolerance, rng);
+    }
+
+    cout << (failures ? "FAILED" : "PASSED") << endl;
+    return failures ? 1 : 0;
+}
@@ -47,6 +47,7 @@ void print_usage() {
        << "                [-b max_batch_size (default 32)]" << "\n"
        << "                [-w max_workspace_size_bytes (default 1 GiB)]" << "\n"
        << "                [-d model_data_type_bit_depth] (32 => float32, 16 => float16)" << "\n"
+       << "                [-L max_loop_scan_output_length] (for loops without a trip count, default 1024)" << "\n"
        << "                [-l] (list layers and their shapes)" << "\n"
        << "                [-g] (debug mode)" << "\n"
        << "                [-v] (increase verbosity)" << "\n"
@@ -64,12 +65,13 @@ int main(int argc, char* argv[]) {
   size_t max_batch_size = 32;
   size_t max_workspace_size = 1 << 30;
   int model_dtype_nbits = 32;
+  int max_loop_scan_output_length = 0;
   int verbosity = (int)nvinfer1::ILogger::Severity::kWARNING;
   bool print_layer_info = false;
   bool debug_builder = false;
 
   int arg = 0;
-  while( (arg = ::getopt(argc, argv, "o:b:w:t:T:d:lgvqVh")) != -1 ) {
+  while( (arg = ::getopt(argc, argv, "o:b:w:t:T:d:L:lgvqVh")) != -1 ) {
     switch (arg){
     case 'o':
       if( optarg ) { engine_filename = optarg; break; }
@@ -89,6 +91,9 @@ int main(int argc, char* argv[]) {
     case 'd':
       if( optarg ) { model_dtype_nbits = atoi(optarg); break; }
       else { cerr << "ERROR: -d flag requires argument" << endl; return -1; }
+    case 'L':
+      if( optarg ) { max_loop_scan_output_length = atoi(optarg); break; }
+      else { cerr << "ERROR: -L flag requires argument" << endl; return -1; }
     case 'l': print_layer_info = true; break;
     case 'g': debug_builder = true; break;
     case 'v': ++verbosity; break;
@@ -171,6 +176,7 @@ int main(int argc, char* argv[]) {
   auto trt_network = common::infer_object(trt_builder->createNetworkV2(explicitBatch));
   auto trt_parser  = common::infer_object(nvonnxparser::createParser(
                                       *trt_network, trt_logger));
+  trt_parser->setMaxLoopScanOutputLength(max_loop_scan_output_length);
 
   // TODO: Fix this for the new API
   //if( print_layer_info ) {
@@ -183,16 +189,9 @@ int main(int argc, char* argv[]) {
   }
 
   {
-    std::ifstream onnx_file(onnx_filename.c_str(),
-                            std::ios::binary | std::ios::ate);
-    std::streamsize file_size = onnx_file.tellg();
-    onnx_file.seekg(0, std::ios::beg);
-    std::vector<char> onnx_buf(file_size);
-    if( !onnx_file.read(onnx_buf.data(), onnx_buf.size()) ) {
-      cerr << "ERROR: Failed to read from file " << onnx_filename << endl;
-      return -4;
-    }
-    if( !trt_parser->parse(onnx_buf.data(), onnx_buf.size()) ) {
+    // onnx_model outlives the network, so it can be imported in place rather
+    // than re-reading and deserializing the file.
+    if( !nvonnxparser::parseModelProto(*trt_parser, onnx_model) ) {
       int nerror = trt_parser->getNbErrors();
       for( int i=0; i<nerror; ++i ) {
         nvonnxparser::IParserError const* error = trt_parser->getError(i);
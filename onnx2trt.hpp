@@ -31,6 +31,7 @@
 #include <functional>
 #include <onnx/onnx_pb.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace onnx2trt
@@ -59,11 +60,27 @@ public:
     virtual StringMap<float>& tensorRangeMins() = 0;
     virtual StringMap<float>& tensorRangeMaxes() = 0;
     virtual StringMap<nvinfer1::DataType>& layerPrecisions() = 0;
+    virtual std::unordered_set<std::string>& loggedWarnings() = 0;
+    // Number of times each value is read, by nodes (including those of nested subgraphs) or as a graph output.
+    virtual StringMap<size_t>& tensorConsumerCounts() = 0;
+    // The last node found reading each value. This is its only consumer if tensorConsumerCounts() is 1.
+    virtual StringMap<::ONNX_NAMESPACE::NodeProto const*>& tensorConsumers() = 0;
+    // Padding of Pad nodes that was folded into the Conv or pooling node reading their output, keyed by that output:
+    // the begin padding of each spatial dimension, followed by the end padding.
+    virtual StringMap<std::vector<int>>& foldedPads() = 0;
+    // Fully connected layers created without a bias, keyed by the value they produce. If that value has no other
+    // consumer, an Add of constant values may be folded into the bias instead of adding a layer.
+    virtual StringMap<nvinfer1::IFullyConnectedLayer*>& biaslessFullyConnectedLayers() = 0;
+    // Scale layers created for a Mul or Div by constant values, keyed by the value they produce. If that value has no
+    // other consumer, an Add or Sub of constant values may be folded into the shift instead of adding a layer.
+    virtual StringMap<nvinfer1::IScaleLayer*>& shiftlessScaleLayers() = 0;
     virtual void registerTensor(TensorOrWeights tensor, const std::string& basename) = 0;
     virtual void registerLayer(nvinfer1::ILayer* layer, const std::string& basename) = 0;
     virtual ShapedWeights createTempWeights(ShapedWeights::DataType type, nvinfer1::Dims shape) = 0;
     virtual int64_t getOpsetVersion(const char* domain = "") const = 0;
     virtual nvinfer1::ILogger& logger() = 0;
+    // Length of Loop scan outputs when the number of iterations has no known bound, or 0 for the default.
+    virtual int32_t maxLoopScanOutputLength() const = 0;
 
 protected:
     virtual ~IImporterContext()
@@ -23,6 +23,11 @@
 #include "onnx2trt_utils.hpp"
 #include "OnnxAttrs.hpp"
 #include "ShapeTensor.hpp"
+#include <NvInferPlugin.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <mutex>
 #include <set>
 
 namespace onnx2trt
@@ -59,6 +64,247 @@ nvinfer1::ITensor* addClip(IImporterContext* ctx, nvinfer1::ITensor* input, floa
     return input;
 };
 
+// Number of input values each output value is interpolated from, along one axis.
+static int resizeTapCount(ResizeParams const& params)
+{
+    return params.mode == "nearest" ? 1 : params.mode == "linear" ? 2 : 4;
+}
+
+// Offset of the first tap from floor(x), where x is the input coordinate.
+static int resizeFirstTapOffset(ResizeParams const& params)
+{
+    return params.mode == "cubic" ? -1 : 0;
+}
+
+// Maps output index i to its fractional input coordinate. outSize is the unrounded output size (inSize * scale).
+static double resizeInputCoordinate(ResizeParams const& params, int64_t i, int64_t inSize, double scale)
+{
+    const std::string& mode = params.transformationMode;
+    const double outSize = inSize * scale;
+    if (mode == "align_corners")
+    {
+        return outSize == 1 ? 0. : i * (inSize - 1) / (outSize - 1);
+    }
+    if (mode == "asymmetric")
+    {
+        return i / scale;
+    }
+    if (mode == "tf_half_pixel_for_nn")
+    {
+        return (i + 0.5) / scale;
+    }
+    if (mode == "pytorch_half_pixel" && outSize == 1)
+    {
+        return -0.5;
+    }
+    return (i + 0.5) / scale - 0.5;
+}
+
+// Rounds an input coordinate to an index as the nearest_mode attribute specifies.
+static int64_t roundResizeCoordinate(std::string const& nearestMode, double x)
+{
+    if (nearestMode == "floor")
+    {
+        return static_cast<int64_t>(std::floor(x));
+    }
+    if (nearestMode == "ceil")
+    {
+        return static_cast<int64_t>(std::ceil(x));
+    }
+    if (nearestMode == "round_prefer_ceil")
+    {
+        return static_cast<int64_t>(std::floor(x + 0.5));
+    }
+    return static_cast<int64_t>(std::ceil(x - 0.5));
+}
+
+// Coefficients of the cubic convolution kernel, highest power first, for taps within distance 1 of the coordinate
+// (near) and for those between 1 and 2 (far).
+static std::array<float, 4> cubicKernelCoefficients(float a, bool near)
+{
+    return near ? std::array<float, 4>{{a + 2, -(a + 3), 0.f, 1.f}}
+                : std::array<float, 4>{{a, -5 * a, 8 * a, -4 * a}};
+}
+
+// Weight of tap k (counted from the first tap) for an input coordinate with fractional part t.
+static double resizeTapWeight(ResizeParams const& params, int k, double t)
+{
+    if (params.mode == "linear")
+    {
+        return k == 0 ? 1 - t : t;
+    }
+    // Cubic taps are at offsets -1, 0, 1 and 2 from floor(x).
+    const double s = std::abs(t - (k - 1));
+    const std::array<float, 4> c = cubicKernelCoefficients(params.cubicCoeffA, k == 1 || k == 2);
+    return ((c[0] * s + c[1]) * s + c[2]) * s + c[3];
+}
+
+Status addDynamicResizeTaps(IImporterContext* ctx, ResizeParams const& params, ShapeTensor const& inSize,
+    ShapeTensor const& outSize, nvinfer1::ITensor& scale, int rank, int axis, nvinfer1::DataType type,
+    std::vector<nvinfer1::ITensor*>& indices, std::vector<nvinfer1::ITensor*>& weights)
+{
+    ASSERT(!params.excludeOutside && "exclude_outside is only supported for static resize shapes!",
+        ErrorCode::kUNSUPPORTED_NODE);
+    using eOp = nvinfer1::ElementWiseOperation;
+    nvinfer1::INetworkDefinition* net = ctx->network();
+    const auto constant = [ctx](float value) {
+        return addConstantScalar(ctx, value, ::ONNX_NAMESPACE::TensorProto::FLOAT, nvinfer1::Dims{1, {1}})
+            ->getOutput(0);
+    };
+    const auto binary = [net](nvinfer1::ITensor* a, nvinfer1::ITensor* b, eOp op) {
+        return net->addElementWise(*a, *b, op)->getOutput(0);
+    };
+    const auto unary = [net](nvinfer1::ITensor* a, nvinfer1::UnaryOperation op) {
+        return net->addUnary(*a, op)->getOutput(0);
+    };
+    const auto cast = [net](nvinfer1::ITensor* a, nvinfer1::DataType outputType) {
+        nvinfer1::IIdentityLayer* layer = net->addIdentity(*a);
+        layer->setOutputType(0, outputType);
+        return layer->getOutput(0);
+    };
+
+    nvinfer1::IFillLayer* iota = addFill(ctx, outSize, nvinfer1::FillOperation::kLINSPACE);
+    iota->setAlpha(0);
+    iota->setBeta(1);
+    iota->setOutputType(0, nvinfer1::DataType::kINT32);
+    nvinfer1::ITensor* i = cast(iota->getOutput(0), nvinfer1::DataType::kFLOAT);
+    nvinfer1::ITensor* inLength = cast(&inSize.tensor(ctx), nvinfer1::DataType::kFLOAT);
+    // The unrounded output length inSize * scale, as in resizeInputCoordinate.
+    nvinfer1::ITensor* outLength = binary(inLength, &scale, eOp::kPROD);
+    // 0 where align_corners and pytorch_half_pixel special-case the coordinate (an output length of 1), else 1.
+    nvinfer1::ITensor* multiple
+        = net->addSelect(*binary(outLength, constant(1), eOp::kEQUAL), *constant(0), *constant(1))->getOutput(0);
+
+    nvinfer1::ITensor* x{nullptr};
+    const std::string& mode = params.transformationMode;
+    if (mode == "align_corners")
+    {
+        // i * (inSize - 1) / (inSize * scale - 1). The denominator is only adjusted when i can only be 0.
+        x = binary(binary(i, binary(inLength, constant(1), eOp::kSUB), eOp::kPROD),
+            binary(outLength, multiple, eOp::kSUB), eOp::kDIV);
+    }
+    else if (mode == "asymmetric")
+    {
+        x = binary(i, &scale, eOp::kDIV);
+    }
+    else
+    {
+        x = binary(binary(i, constant(0.5f), eOp::kSUM), &scale, eOp::kDIV);
+        if (mode != "tf_half_pixel_for_nn")
+        {
+            x = binary(x, constant(0.5f), eOp::kSUB);
+        }
+        if (mode == "pytorch_half_pixel")
+        {
+            // x for multiple outputs, else -0.5.
+            x = binary(binary(x, multiple, eOp::kPROD),
+                binary(binary(multiple, constant(1), eOp::kSUB), constant(0.5f), eOp::kPROD), eOp::kSUM);
+        }
+    }
+
+    nvinfer1::ITensor* maxIndex = binary(inLength, constant(1), eOp::kSUB);
+    const auto toIndex = [&](nvinfer1::ITensor* position) {
+        return cast(binary(binary(position, constant(0), eOp::kMAX), maxIndex, eOp::kMIN), nvinfer1::DataType::kINT32);
+    };
+    if (params.mode == "nearest")
+    {
+        nvinfer1::ITensor* position{nullptr};
+        if (params.nearestMode == "floor")
+        {
+            position = unary(x, nvinfer1::UnaryOperation::kFLOOR);
+        }
+        else if (params.nearestMode == "ceil")
+        {
+            position = unary(x, nvinfer1::UnaryOperation::kCEIL);
+        }
+        else if (params.nearestMode == "round_prefer_ceil")
+        {
+            position = unary(binary(x, constant(0.5f), eOp::kSUM), nvinfer1::UnaryOperation::kFLOOR);
+        }
+        else
+        {
+            position = unary(binary(x, constant(0.5f), eOp::kSUB), nvinfer1::UnaryOperation::kCEIL);
+        }
+        indices.push_back(toIndex(position));
+        return Status::success();
+    }
+
+    std::vector<int> otherAxes;
+    for (int a = 0; a < rank; ++a)
+    {
+        if (a != axis)
+        {
+            otherAxes.push_back(a);
+        }
+    }
+    nvinfer1::ITensor* x0 = unary(x, nvinfer1::UnaryOperation::kFLOOR);
+    nvinfer1::ITensor* t = binary(x, x0, eOp::kSUB);
+    const int firstOffset = resizeFirstTapOffset(params);
+    for (int k = 0; k < resizeTapCount(params); ++k)
+    {
+        indices.push_back(toIndex(binary(x0, constant(static_cast<float>(firstOffset + k)), eOp::kSUM)));
+        nvinfer1::ITensor* weight{nullptr};
+        if (params.mode == "linear")
+        {
+            weight = k == 0 ? binary(constant(1), t, eOp::kSUB) : t;
+        }
+        else
+        {
+            // Distance of the tap from the coordinate, and the cubic kernel evaluated there by Horner's rule.
+            const int offset = firstOffset + k;
+            nvinfer1::ITensor* s = offset <= 0 ? binary(t, constant(static_cast<float>(-offset)), eOp::kSUM)
+                                               : binary(constant(static_cast<float>(offset)), t, eOp::kSUB);
+            const std::array<float, 4> c = cubicKernelCoefficients(params.cubicCoeffA, k == 1 || k == 2);
+            weight = constant(c[0]);
+            for (int j = 1; j < 4; ++j)
+            {
+                weight = binary(binary(weight, s, eOp::kPROD), constant(c[j]), eOp::kSUM);
+            }
+        }
+        weight = unsqueezeTensor(ctx, *weight, otherAxes);
+        ASSERT(weight, ErrorCode::kUNSUPPORTED_NODE);
+        weights.push_back(type == nvinfer1::DataType::kFLOAT ? weight : cast(weight, type));
+    }
+    return Status::success();
+}
+
+void addFoldedPadding(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, nvinfer1::Dims& begPadding,
+    nvinfer1::Dims& endPadding)
+{
+    auto padIt = ctx->foldedPads().find(node.input(0));
+    if (padIt == ctx->foldedPads().end())
+    {
+        return;
+    }
+    // 1D inputs are expanded to 2D, so the padding may have fewer dimensions than the node.
+    std::vector<int> const& pads = padIt->second;
+    const int nbSpatialDims = pads.size() / 2;
+    assert(nbSpatialDims <= begPadding.nbDims);
+    for (int i = 0; i < nbSpatialDims; ++i)
+    {
+        begPadding.d[i] += pads[i];
+        endPadding.d[i] += pads[nbSpatialDims + i];
+    }
+    LOG_VERBOSE(node.op_type() << " node " << node.name() << ": padding includes that of the preceding Pad node.");
+}
+
+nvinfer1::ITensor* applyResizeTaps(IImporterContext* ctx, nvinfer1::ITensor& input, int axis,
+    std::vector<nvinfer1::ITensor*> const& indices, std::vector<nvinfer1::ITensor*> const& weights)
+{
+    nvinfer1::INetworkDefinition* net = ctx->network();
+    nvinfer1::ITensor* output{nullptr};
+    for (size_t k = 0; k < indices.size(); ++k)
+    {
+        nvinfer1::ITensor* tap = net->addGather(input, *indices[k], axis)->getOutput(0);
+        if (!weights.empty())
+        {
+            tap = net->addElementWise(*tap, *weights[k], nvinfer1::ElementWiseOperation::kPROD)->getOutput(0);
+        }
+        output = output ? net->addElementWise(*output, *tap, nvinfer1::ElementWiseOperation::kSUM)->getOutput(0) : tap;
+    }
+    return output;
+}
+
 NodeImportResult argMinMaxHelper(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node,
     std::vector<TensorOrWeights>& inputs, nvinfer1::TopKOperation op)
 {
@@ -153,6 +399,112 @@ Status broadcastTensors(IImporterContext* ctx, nvinfer1::ITensor*& t1, nvinfer1:
     return Status::success();
 }
 
+// Returns the axis of per-channel quantization, or -1 for per-tensor quantization.
+static int getQuantizationAxis(
+    IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, ShapedWeights const& scale, int nbDims)
+{
+    if (scale.count() == 1)
+    {
+        return -1;
+    }
+    // Per-channel quantization was added in opset 13, with a default axis of 1. Models that use it with earlier
+    // opsets quantize convolution weights, on the first axis.
+    OnnxAttrs attrs(node, ctx);
+    int axis = attrs.get("axis", ctx->getOpsetVersion() >= 13 ? 1 : 0);
+    return convertAxis(axis, nbDims).is_success() ? axis : nbDims;
+}
+
+// Returns element i of INT8, UINT8 or INT32 weights.
+static int32_t getQuantizedValue(ShapedWeights const& weights, size_t i)
+{
+    switch (weights.type)
+    {
+    case ::ONNX_NAMESPACE::TensorProto::INT8: return static_cast<int8_t const*>(weights.values)[i];
+    case ::ONNX_NAMESPACE::TensorProto::UINT8: return static_cast<uint8_t const*>(weights.values)[i];
+    default: return static_cast<int32_t const*>(weights.values)[i];
+    }
+}
+
+bool canFoldQuantization(
+    IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs)
+{
+    const std::string& opType = node.op_type();
+    auto fallback = [&ctx, &node, &opType](const char* reason) {
+        LOG_WARNING("Q/DQ fallback: " << opType << " node " << node.name() << " cannot be folded, since " << reason
+                                      << ". It is imported as a scale layer.");
+        return false;
+    };
+    if (ctx->network()->hasExplicitPrecision())
+    {
+        LOG_VERBOSE(opType << " node " << node.name() << ": the network has explicit precision, so it is imported as "
+                           << "a scale layer.");
+        return false;
+    }
+
+    const bool isDequantize = opType == "DequantizeLinear";
+    const bool hasZeroPoint = inputs.size() > 2 && inputs.at(2);
+    if (inputs.size() < 2 || !inputs.at(0) || !inputs.at(1).is_weights()
+        || (hasZeroPoint && !inputs.at(2).is_weights()))
+    {
+        return fallback("its scale or zero point is not an initializer");
+    }
+    ShapedWeights const& scale = inputs.at(1).weights();
+    if (scale.type != ::ONNX_NAMESPACE::TensorProto::FLOAT || scale.shape.nbDims > 1)
+    {
+        return fallback("its scale is not a FLOAT scalar or vector");
+    }
+    float const* scales = static_cast<float const*>(scale.values);
+    if (std::any_of(scales, scales + scale.count(), [](float s) { return !(s > 0.f); }))
+    {
+        return fallback("its scale is not positive");
+    }
+    // As in ONNX, the quantized type is the zero point type. Without a zero point, it is UINT8 for QuantizeLinear,
+    // and the input type for DequantizeLinear.
+    int32_t quantizedType = isDequantize && inputs.at(0).is_weights() ? inputs.at(0).weights().type
+                                                                      : ::ONNX_NAMESPACE::TensorProto::UINT8;
+    if (hasZeroPoint)
+    {
+        ShapedWeights const& zeroPoint = inputs.at(2).weights();
+        quantizedType = zeroPoint.type;
+        if (zeroPoint.count() != scale.count())
+        {
+            return fallback("its scale and zero point differ in size");
+        }
+    }
+    if (quantizedType != ::ONNX_NAMESPACE::TensorProto::INT8 && quantizedType != ::ONNX_NAMESPACE::TensorProto::UINT8
+        && !(isDequantize && quantizedType == ::ONNX_NAMESPACE::TensorProto::INT32))
+    {
+        return fallback("its quantized type is not supported");
+    }
+
+    const nvinfer1::Dims dims = inputs.at(0).shape();
+    const int axis = getQuantizationAxis(ctx, node, scale, dims.nbDims);
+    if (inputs.at(0).is_weights())
+    {
+        ShapedWeights const& input = inputs.at(0).weights();
+        if (input.type != (isDequantize ? quantizedType : ::ONNX_NAMESPACE::TensorProto::FLOAT))
+        {
+            return fallback("its input weights have the wrong type");
+        }
+        if (axis >= 0 && (axis >= dims.nbDims || dims.d[axis] != static_cast<int>(scale.count())))
+        {
+            return fallback("its per-channel scale does not match the quantization axis");
+        }
+        return true;
+    }
+
+    // TensorRT INT8 is signed and symmetric, so activations must be per-tensor INT8 with a zero point of 0.
+    if (axis >= 0)
+    {
+        return fallback("per-channel quantization of an activation cannot be expressed as a dynamic range");
+    }
+    if (quantizedType != ::ONNX_NAMESPACE::TensorProto::INT8 || getQuantizedValue(inputs.at(2).weights(), 0) != 0)
+    {
+        return fallback("activations can only be quantized to INT8 with a zero point of 0");
+    }
+    return true;
+}
+
 bool canUseLinearResize(const size_t scaleSize, const float* scaleFactors)
 {
     // Linear resize supports up to 3D resize on the outermost dimensions.
@@ -169,6 +521,180 @@ bool canUseLinearResize(const size_t scaleSize, const float* scaleFactors)
     return true;
 }
 
+bool canUseRNNv2(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs)
+{
+    const std::string& opType = node.op_type();
+    auto fallback = [&ctx, &node, &opType](const char* reason) {
+        LOG_VERBOSE(opType << " node " << node.name() << ": using loop-based import, since " << reason << ".");
+        return false;
+    };
+    const auto hasInput = [&inputs](size_t index) { return inputs.size() > index && inputs.at(index); };
+
+    OnnxAttrs attrs(node, ctx);
+    const std::string direction = attrs.get<std::string>("direction", "forward");
+    if (direction != "forward" && direction != "bidirectional")
+    {
+        return fallback("RNNv2 does not support reverse-only recurrence");
+    }
+    const int numDirections = (direction == "bidirectional") ? 2 : 1;
+    if (attrs.count("clip"))
+    {
+        return fallback("RNNv2 does not support clipping");
+    }
+    if (attrs.count("activation_alpha") || attrs.count("activation_beta"))
+    {
+        return fallback("RNNv2 does not support activation parameters");
+    }
+
+    // RNNv2 only supports the default activations of each op (and ReLU for RNN), repeated for each direction.
+    std::vector<std::string> defaultActivations;
+    int numGates = 1;
+    if (opType == "LSTM")
+    {
+        defaultActivations = {"Sigmoid", "Tanh", "Tanh"};
+        numGates = 4;
+        if (attrs.get<int>("input_forget", 0) != 0)
+        {
+            return fallback("RNNv2 does not support coupled input/forget gates");
+        }
+        if (hasInput(7))
+        {
+            return fallback("RNNv2 does not support peephole connections");
+        }
+    }
+    else if (opType == "GRU")
+    {
+        defaultActivations = {"Sigmoid", "Tanh"};
+        numGates = 3;
+        // The cuDNN GRU applies the reset gate after the recurrent matrix multiply.
+        if (attrs.get<int>("linear_before_reset", 0) != 1)
+        {
+            return fallback("RNNv2 requires linear_before_reset=1 for GRUs");
+        }
+    }
+    else if (opType == "RNN")
+    {
+        defaultActivations = {"Tanh"};
+    }
+    else
+    {
+        return fallback("it is not a recurrent op");
+    }
+    std::vector<std::string> activations = attrs.get<std::vector<std::string>>("activations", defaultActivations);
+    if (opType == "RNN" && activations.size() == static_cast<size_t>(numDirections) && activations.front() == "Relu")
+    {
+        defaultActivations = {"Relu"};
+    }
+    if (numDirections == 2)
+    {
+        defaultActivations.insert(defaultActivations.end(), defaultActivations.begin(), defaultActivations.end());
+    }
+    if (activations != defaultActivations)
+    {
+        return fallback("RNNv2 does not support non-default activations");
+    }
+
+    if (!inputs.at(0).is_tensor())
+    {
+        return fallback("X is not a tensor");
+    }
+    const nvinfer1::ITensor& input = inputs.at(0).tensor();
+    const nvinfer1::Dims inputDims = input.getDimensions();
+    const nvinfer1::DataType type = input.getType();
+    if (inputDims.nbDims != 3 || inputDims.d[0] <= 0 || inputDims.d[2] <= 0)
+    {
+        return fallback("the sequence length or input size is not static");
+    }
+    if (type != nvinfer1::DataType::kFLOAT && type != nvinfer1::DataType::kHALF)
+    {
+        return fallback("RNNv2 only supports FP32 and FP16 inputs");
+    }
+
+    // W, R and B are sliced per gate on the host, so must be constants of the input type.
+    const int hiddenSize = attrs.get<int>("hidden_size");
+    const std::vector<nvinfer1::Dims> expectedShapes{
+        nvinfer1::Dims3{numDirections, numGates * hiddenSize, inputDims.d[2]},
+        nvinfer1::Dims3{numDirections, numGates * hiddenSize, hiddenSize},
+        nvinfer1::Dims2{numDirections, 2 * numGates * hiddenSize}};
+    for (size_t i = 1; i <= expectedShapes.size(); ++i)
+    {
+        // B is optional.
+        if (i == 3 && !hasInput(i))
+        {
+            continue;
+        }
+        nvinfer1::DataType weightsType;
+        if (!inputs.at(i).is_weights() || !convertDtype(inputs.at(i).weights().type, &weightsType)
+            || weightsType != type || inputs.at(i).weights().shape != expectedShapes.at(i - 1))
+        {
+            return fallback("W, R and B must be constants of the input type");
+        }
+    }
+    if (hasInput(4) && !inputs.at(4).isInt32())
+    {
+        return fallback("RNNv2 requires INT32 sequence lengths");
+    }
+    for (size_t i = 5; i <= 6; ++i)
+    {
+        nvinfer1::DataType stateType = type;
+        if (hasInput(i))
+        {
+            if (inputs.at(i).is_tensor())
+            {
+                stateType = inputs.at(i).tensor().getType();
+            }
+            else if (!convertDtype(inputs.at(i).weights().type, &stateType))
+            {
+                return fallback("the initial states have an unsupported type");
+            }
+        }
+        if (stateType != type)
+        {
+            return fallback("the initial states do not match the input type");
+        }
+    }
+    return true;
+}
+
+ResizeTaps computeResizeTaps(ResizeParams const& params, int64_t inSize, int64_t outSize, double scale)
+{
+    const int nbTaps = resizeTapCount(params);
+    const int firstOffset = resizeFirstTapOffset(params);
+    ResizeTaps taps;
+    taps.indices.assign(nbTaps, std::vector<int32_t>(outSize));
+    if (nbTaps > 1)
+    {
+        taps.weights.assign(nbTaps, std::vector<float>(outSize));
+    }
+    const auto clampIndex
+        = [inSize](int64_t index) { return static_cast<int32_t>(std::min(std::max<int64_t>(index, 0), inSize - 1)); };
+    for (int64_t i = 0; i < outSize; ++i)
+    {
+        const double x = resizeInputCoordinate(params, i, inSize, scale);
+        if (nbTaps == 1)
+        {
+            taps.indices[0][i] = clampIndex(roundResizeCoordinate(params.nearestMode, x));
+            continue;
+        }
+        const double x0 = std::floor(x);
+        double sum = 0;
+        std::vector<double> weights(nbTaps);
+        for (int k = 0; k < nbTaps; ++k)
+        {
+            const int64_t index = static_cast<int64_t>(x0) + firstOffset + k;
+            const bool outside = index < 0 || index >= inSize;
+            weights[k] = params.excludeOutside && outside ? 0. : resizeTapWeight(params, k, x - x0);
+            sum += weights[k];
+            taps.indices[k][i] = clampIndex(index);
+        }
+        for (int k = 0; k < nbTaps; ++k)
+        {
+            taps.weights[k][i] = static_cast<float>(params.excludeOutside && sum != 0 ? weights[k] / sum : weights[k]);
+        }
+    }
+    return taps;
+}
+
 nvinfer1::ITensor* constantOfShape(IImporterContext* ctx, nvinfer1::ITensor* constant, nvinfer1::ITensor* shape)
 {
     int rank = shape->getDimensions().d[0];
@@ -227,13 +753,12 @@ bool convertDtype(int32_t onnx_dtype, nvinfer1::DataType* trt_dtype)
 
 int32_t* convertINT64(const int64_t* weightValues, nvinfer1::Dims shape, IImporterContext* ctx)
 {
-    static bool logged = false;
-    if (!logged)
+    // Note: This is tracked in the context rather than a static so that concurrent imports don't race on it.
+    if (ctx->loggedWarnings().insert("INT64").second)
     {
-        LOG_WARNING( 
+        LOG_WARNING(
             "Your ONNX model has been generated with INT64 weights, while TensorRT does not natively support INT64. "
             "Attempting to cast down to INT32.");
-        logged = true;
     }
 
     const size_t nbWeights = volume(shape);
@@ -345,7 +870,8 @@ bool convertOnnxWeights(
     // Check for supported types that can be found in the int32_data field in the TensorProto
     // https://github.com/onnx/onnx/blob/master/onnx/onnx.proto#L382-L387
     else if (onnxDtype == ::ONNX_NAMESPACE::TensorProto::INT32 || onnxDtype == ::ONNX_NAMESPACE::TensorProto::FLOAT16
-        || onnxDtype == ::ONNX_NAMESPACE::TensorProto::INT8 || onnxDtype == ::ONNX_NAMESPACE::TensorProto::BOOL)
+        || onnxDtype == ::ONNX_NAMESPACE::TensorProto::INT8 || onnxDtype == ::ONNX_NAMESPACE::TensorProto::UINT8
+        || onnxDtype == ::ONNX_NAMESPACE::TensorProto::BOOL)
     {
         if (onnxTensor.raw_data().size() > 0)
         {
@@ -366,6 +892,9 @@ bool convertOnnxWeights(
                 case ::ONNX_NAMESPACE::TensorProto::INT8:
                     dataPtr = convertINT32Data<int8_t>(onnxTensor.int32_data().data(), shape, onnxDtype, ctx);
                     break;
+                case ::ONNX_NAMESPACE::TensorProto::UINT8:
+                    dataPtr = convertINT32Data<uint8_t>(onnxTensor.int32_data().data(), shape, onnxDtype, ctx);
+                    break;
                 case ::ONNX_NAMESPACE::TensorProto::BOOL:
                     dataPtr = convertINT32Data<uint8_t>(onnxTensor.int32_data().data(), shape, onnxDtype, ctx);
                     break;
@@ -560,11 +1089,227 @@ bool elementwiseCheck(const std::vector<TensorOrWeights>& inputs, const nvinfer1
     return true;
 }
 
+// Cheaper equivalents of an elementwise operation with a constant operand.
+enum class ElementwiseRewrite
+{
+    kIDENTITY,
+    kNEGATE,
+    kRECIPROCAL,
+    kSQUARE,
+    kSQRT
+};
+
+struct ElementwiseRule
+{
+    nvinfer1::ElementWiseOperation op;
+    float value;       // Value of every element of the constant operand
+    int constantIndex; // Index of the constant operand, or -1 if the rule applies to either
+    ElementwiseRewrite rewrite;
+};
+
+static const ElementwiseRule kElementwiseRules[] = {
+    {nvinfer1::ElementWiseOperation::kSUM, 0.f, -1, ElementwiseRewrite::kIDENTITY},
+    {nvinfer1::ElementWiseOperation::kSUB, 0.f, 1, ElementwiseRewrite::kIDENTITY},
+    {nvinfer1::ElementWiseOperation::kSUB, 0.f, 0, ElementwiseRewrite::kNEGATE},
+    {nvinfer1::ElementWiseOperation::kPROD, 1.f, -1, ElementwiseRewrite::kIDENTITY},
+    {nvinfer1::ElementWiseOperation::kPROD, -1.f, -1, ElementwiseRewrite::kNEGATE},
+    {nvinfer1::ElementWiseOperation::kDIV, 1.f, 1, ElementwiseRewrite::kIDENTITY},
+    {nvinfer1::ElementWiseOperation::kDIV, -1.f, 1, ElementwiseRewrite::kNEGATE},
+    {nvinfer1::ElementWiseOperation::kDIV, 1.f, 0, ElementwiseRewrite::kRECIPROCAL},
+    {nvinfer1::ElementWiseOperation::kPOW, 1.f, 1, ElementwiseRewrite::kIDENTITY},
+    {nvinfer1::ElementWiseOperation::kPOW, -1.f, 1, ElementwiseRewrite::kRECIPROCAL},
+    {nvinfer1::ElementWiseOperation::kPOW, 2.f, 1, ElementwiseRewrite::kSQUARE},
+    {nvinfer1::ElementWiseOperation::kPOW, 0.5f, 1, ElementwiseRewrite::kSQRT},
+};
+
+// Gets the values of FLOAT weights that broadcast against a tensor of the given dimensions without changing its shape:
+// a single value if all elements are equal, or one value per channel (dimension 1) if the weights vary along it only.
+static bool getBroadcastConstant(ShapedWeights const& weights, nvinfer1::Dims const& dims, std::vector<float>& values)
+{
+    if (weights.type != ::ONNX_NAMESPACE::TensorProto::FLOAT || weights.count() == 0
+        || weights.shape.nbDims > dims.nbDims)
+    {
+        return false;
+    }
+    const int offset = dims.nbDims - weights.shape.nbDims;
+    for (int i = 0; i < weights.shape.nbDims; ++i)
+    {
+        if (weights.shape.d[i] != 1 && weights.shape.d[i] != dims.d[offset + i])
+        {
+            return false;
+        }
+    }
+    float const* data = static_cast<float const*>(weights.values);
+    if (std::all_of(data, data + weights.count(), [data](float v) { return v == data[0]; }))
+    {
+        values.assign(1, data[0]);
+        return true;
+    }
+    for (int i = 0; i < weights.shape.nbDims; ++i)
+    {
+        if (offset + i != 1 && weights.shape.d[i] != 1)
+        {
+            return false;
+        }
+    }
+    values.assign(data, data + weights.count());
+    return true;
+}
+
+// Scale layers need 4D or 5D inputs, and scaleHelper reshapes others to 4D, which needs at most one unknown dimension.
+static bool canUseScaleLayer(nvinfer1::ITensor& tensor, bool perChannel)
+{
+    const nvinfer1::Dims dims = tensor.getDimensions();
+    if (tensor.getType() != nvinfer1::DataType::kFLOAT && tensor.getType() != nvinfer1::DataType::kHALF)
+    {
+        return false;
+    }
+    if (dims.nbDims == 4 || dims.nbDims == 5)
+    {
+        return true;
+    }
+    return dims.nbDims >= (perChannel ? 2 : 1) && dims.nbDims <= 3 && std::count(dims.d, dims.d + dims.nbDims, -1) <= 1;
+}
+
+// Simplifies a binary elementwise operation between a FLOAT or HALF tensor and uniform or per-channel constant values:
+// - an Add or Sub of constants following a Mul or Div by constants is folded into the shift of its scale layer,
+// - operations with a neutral or otherwise special uniform constant use kElementwiseRules,
+// - other Add, Sub, Mul and Div operations use a single scale layer.
+// Returns no outputs if no simplification applies.
+static NodeImportResult simplifyElementwise(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node,
+    std::vector<TensorOrWeights>& inputs, nvinfer1::ElementWiseOperation op)
+{
+    using nvinfer1::ElementWiseOperation;
+    const std::vector<TensorOrWeights> noOutputs;
+    if (inputs.size() != 2 || inputs.at(0).is_weights() == inputs.at(1).is_weights())
+    {
+        return noOutputs;
+    }
+    const int tensorIndex = inputs.at(0).is_tensor() ? 0 : 1;
+    const int constantIndex = 1 - tensorIndex;
+    nvinfer1::ITensor& tensor = inputs.at(tensorIndex).tensor();
+    std::vector<float> values;
+    if ((tensor.getType() != nvinfer1::DataType::kFLOAT && tensor.getType() != nvinfer1::DataType::kHALF)
+        || !getBroadcastConstant(inputs.at(constantIndex).weights(), tensor.getDimensions(), values))
+    {
+        return noOutputs;
+    }
+    const bool perChannel = values.size() > 1;
+    const nvinfer1::ScaleMode mode = perChannel ? nvinfer1::ScaleMode::kCHANNEL : nvinfer1::ScaleMode::kUNIFORM;
+    auto makeWeights = [ctx](std::vector<float> const& v) {
+        ShapedWeights weights
+            = ctx->createTempWeights(::ONNX_NAMESPACE::TensorProto::FLOAT, makeDims(1, static_cast<int>(v.size())));
+        std::copy(v.begin(), v.end(), static_cast<float*>(weights.values));
+        return weights;
+    };
+    auto negated = [](std::vector<float> v) {
+        std::transform(v.begin(), v.end(), v.begin(), [](float x) { return -x; });
+        return v;
+    };
+
+    const bool isShift = op == ElementWiseOperation::kSUM || (op == ElementWiseOperation::kSUB && tensorIndex == 0);
+    auto scaleIt = ctx->shiftlessScaleLayers().find(node.input(tensorIndex));
+    if (isShift && scaleIt != ctx->shiftlessScaleLayers().end()
+        && ctx->tensorConsumerCounts()[node.input(tensorIndex)] == 1)
+    {
+        nvinfer1::IScaleLayer* layer = scaleIt->second;
+        std::vector<float> shift = op == ElementWiseOperation::kSUB ? negated(values) : values;
+        nvinfer1::Weights scale = layer->getScale();
+        if (layer->getMode() == nvinfer1::ScaleMode::kUNIFORM && perChannel)
+        {
+            const float uniformScale = static_cast<float const*>(scale.values)[0];
+            layer->setScale(makeWeights(std::vector<float>(shift.size(), uniformScale)));
+            layer->setMode(nvinfer1::ScaleMode::kCHANNEL);
+        }
+        else if (layer->getMode() == nvinfer1::ScaleMode::kCHANNEL && !perChannel)
+        {
+            shift.assign(scale.count, shift[0]);
+        }
+        layer->setShift(makeWeights(shift));
+        ctx->shiftlessScaleLayers().erase(scaleIt);
+        LOG_VERBOSE(node.op_type() << " node " << node.name() << ": folded into the preceding scale layer's shift.");
+        return {{inputs.at(tensorIndex)}};
+    }
+
+    if (!perChannel)
+    {
+        for (ElementwiseRule const& rule : kElementwiseRules)
+        {
+            if (rule.op != op || rule.value != values[0]
+                || (rule.constantIndex != -1 && rule.constantIndex != constantIndex))
+            {
+                continue;
+            }
+            LOG_VERBOSE(node.op_type() << " node " << node.name() << ": simplified for the constant " << values[0]);
+            switch (rule.rewrite)
+            {
+            case ElementwiseRewrite::kIDENTITY: return {{identity(ctx, &tensor)}};
+            case ElementwiseRewrite::kNEGATE:
+                return unaryHelper(ctx, inputs.at(tensorIndex), nvinfer1::UnaryOperation::kNEG);
+            case ElementwiseRewrite::kRECIPROCAL:
+                return unaryHelper(ctx, inputs.at(tensorIndex), nvinfer1::UnaryOperation::kRECIP);
+            case ElementwiseRewrite::kSQRT:
+                return unaryHelper(ctx, inputs.at(tensorIndex), nvinfer1::UnaryOperation::kSQRT);
+            case ElementwiseRewrite::kSQUARE:
+            {
+                auto* layer = ctx->network()->addElementWise(tensor, tensor, ElementWiseOperation::kPROD);
+                ASSERT(layer, ErrorCode::kUNSUPPORTED_NODE);
+                return {{layer->getOutput(0)}};
+            }
+            }
+        }
+    }
+
+    if (!canUseScaleLayer(tensor, perChannel))
+    {
+        return noOutputs;
+    }
+    const nvinfer1::Weights empty{nvinfer1::DataType::kFLOAT, nullptr, 0};
+    nvinfer1::Weights shift = empty;
+    nvinfer1::Weights scale = empty;
+    switch (op)
+    {
+    case ElementWiseOperation::kSUM: shift = makeWeights(values); break;
+    case ElementWiseOperation::kSUB:
+        // c - x is a scale by -1 followed by a shift by c.
+        shift = makeWeights(tensorIndex == 0 ? negated(values) : values);
+        if (tensorIndex == 1)
+        {
+            scale = makeWeights(std::vector<float>(values.size(), -1.f));
+        }
+        break;
+    case ElementWiseOperation::kPROD: scale = makeWeights(values); break;
+    case ElementWiseOperation::kDIV:
+        if (tensorIndex == 1 || std::count(values.begin(), values.end(), 0.f))
+        {
+            return noOutputs;
+        }
+        std::transform(values.begin(), values.end(), values.begin(), [](float x) { return 1.f / x; });
+        scale = makeWeights(values);
+        break;
+    default: return noOutputs;
+    }
+
+    nvinfer1::IScaleLayer* layer{nullptr};
+    auto result = scaleHelper(ctx, tensor, mode, shift, scale, empty, &layer);
+    if (!result.is_error() && !shift.count && layer->getOutput(0) == &result.value().at(0).tensor())
+    {
+        ctx->shiftlessScaleLayers()[node.output(0)] = layer;
+    }
+    LOG_VERBOSE(node.op_type() << " node " << node.name() << ": imported as a scale layer.");
+    return result;
+}
+
 NodeImportResult elementwiseHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node,
     std::vector<TensorOrWeights>& inputs, nvinfer1::ElementWiseOperation binary_op)
 {
     ASSERT(!inputs.empty(), ErrorCode::kINVALID_NODE);
     ASSERT(elementwiseCheck(inputs, binary_op), ErrorCode::kUNSUPPORTED_NODE);
+    NodeImportResult simplified = simplifyElementwise(ctx, node, inputs, binary_op);
+    if (simplified.is_error() || !simplified.value().empty())
+    {
+        return simplified;
+    }
     std::vector<nvinfer1::ITensor*> inputTensors;
     int maxNbDims = -1;
     for (auto input : inputs)
@@ -611,6 +1356,117 @@ nvinfer1::ITensor* flattenTensor(IImporterContext* ctx, nvinfer1::ITensor& tenso
     return flattenLayer->getOutput(0);
 }
 
+NodeImportResult foldQuantizationHelper(
+    IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs)
+{
+    ShapedWeights const& scale = inputs.at(1).weights();
+    float const* scales = static_cast<float const*>(scale.values);
+    const bool hasZeroPoint = inputs.size() > 2 && inputs.at(2);
+
+    if (inputs.at(0).is_tensor())
+    {
+        // Quantized values span [-127, 127] * scale, which is the dynamic range used by TRT's INT8 mode. The identity
+        // is removed by the builder, and keeps the tensor names of the graph input and output distinct.
+        const float range = 127.f * scales[0];
+        nvinfer1::ITensor& input = inputs.at(0).tensor();
+        input.setDynamicRange(-range, range);
+        nvinfer1::IIdentityLayer* layer = ctx->network()->addIdentity(input);
+        ASSERT(layer, ErrorCode::kUNSUPPORTED_NODE);
+        layer->getOutput(0)->setDynamicRange(-range, range);
+        LOG_VERBOSE(node.op_type() << " node " << node.name() << ": folded into a dynamic range of " << range);
+        return {{layer->getOutput(0)}};
+    }
+
+    // Element i of the weights uses scale (i / innerVolume) % nbChannels, which is 0 for per-tensor quantization.
+    ShapedWeights const& input = inputs.at(0).weights();
+    const int axis = getQuantizationAxis(ctx, node, scale, input.shape.nbDims);
+    const size_t nbChannels = scale.count();
+    size_t innerVolume = 1;
+    for (int i = axis + 1; axis >= 0 && i < input.shape.nbDims; ++i)
+    {
+        innerVolume *= input.shape.d[i];
+    }
+    auto channel = [&](size_t i) { return (i / innerVolume) % nbChannels; };
+    auto zeroPoint = [&](size_t c) { return hasZeroPoint ? getQuantizedValue(inputs.at(2).weights(), c) : 0; };
+
+    if (node.op_type() == "DequantizeLinear")
+    {
+        ShapedWeights output = ctx->createTempWeights(::ONNX_NAMESPACE::TensorProto::FLOAT, input.shape);
+        float* values = static_cast<float*>(output.values);
+        for (size_t i = 0; i < input.count(); ++i)
+        {
+            const size_t c = channel(i);
+            values[i] = (getQuantizedValue(input, i) - zeroPoint(c)) * scales[c];
+        }
+        LOG_VERBOSE(node.op_type() << " node " << node.name() << ": dequantized constant weights on the host.");
+        return {{output}};
+    }
+
+    // "y = saturate ((x / y_scale) + y_zero_point)", rounding half to even.
+    const auto type = hasZeroPoint ? inputs.at(2).weights().type : ::ONNX_NAMESPACE::TensorProto::UINT8;
+    const bool isSigned = type == ::ONNX_NAMESPACE::TensorProto::INT8;
+    const float minValue = isSigned ? -128.f : 0.f;
+    const float maxValue = isSigned ? 127.f : 255.f;
+    ShapedWeights output = ctx->createTempWeights(type, input.shape);
+    float const* inputValues = static_cast<float const*>(input.values);
+    for (size_t i = 0; i < input.count(); ++i)
+    {
+        const size_t c = channel(i);
+        const float value
+            = std::min(std::max(std::nearbyint(inputValues[i] / scales[c]) + zeroPoint(c), minValue), maxValue);
+        if (isSigned)
+        {
+            static_cast<int8_t*>(output.values)[i] = static_cast<int8_t>(value);
+        }
+        else
+        {
+            static_cast<uint8_t*>(output.values)[i] = static_cast<uint8_t>(value);
+        }
+    }
+    LOG_VERBOSE(node.op_type() << " node " << node.name() << ": quantized constant weights on the host.");
+    return {{output}};
+}
+
+nvinfer1::ITensor* fullyConnectedHelper(IImporterContext* ctx, nvinfer1::ITensor& input, bool transposeInput,
+    ShapedWeights const& kernel, ShapedWeights const& bias, nvinfer1::IFullyConnectedLayer** fcLayer)
+{
+    // The fully connected layer reduces over the last three dimensions and treats the others as batch dimensions,
+    // so append two unit dimensions before the layer and remove them afterwards. A reshape dimension of 0 copies the
+    // corresponding input dimension, which keeps this valid for dynamic shapes.
+    const int nbDims = input.getDimensions().nbDims;
+    nvinfer1::IShuffleLayer* expand = ctx->network()->addShuffle(input);
+    if (!expand)
+    {
+        return nullptr;
+    }
+    if (transposeInput)
+    {
+        expand->setFirstTranspose(nvinfer1::Permutation{{1, 0}});
+    }
+    nvinfer1::Dims expandedDims = makeDims(nbDims + 2, 1);
+    std::fill(expandedDims.d, expandedDims.d + nbDims, 0);
+    expand->setReshapeDimensions(expandedDims);
+
+    nvinfer1::IFullyConnectedLayer* fc
+        = ctx->network()->addFullyConnected(*expand->getOutput(0), kernel.shape.d[0], kernel, bias);
+    if (!fc)
+    {
+        return nullptr;
+    }
+    if (fcLayer)
+    {
+        *fcLayer = fc;
+    }
+
+    nvinfer1::IShuffleLayer* squeeze = ctx->network()->addShuffle(*fc->getOutput(0));
+    if (!squeeze)
+    {
+        return nullptr;
+    }
+    squeeze->setReshapeDimensions(makeDims(nbDims, 0));
+    return squeeze->getOutput(0);
+}
+
 nvinfer1::ITensor* gatherDimension(IImporterContext* ctx, nvinfer1::ITensor* shapeTensor, int dim, nvinfer1::Dims shape)
 {
     auto& axisValue = *addConstantScalar(ctx, dim, ::ONNX_NAMESPACE::TensorProto_DataType_INT32, shape)->getOutput(0);
@@ -762,6 +1618,20 @@ int getDtypeSize(int32_t onnxDtype)
     }
 }
 
+bool getDyadicScale(float scale, int64_t& num, int64_t& den)
+{
+    for (den = 1; den <= 256; den *= 2)
+    {
+        const double scaled = static_cast<double>(scale) * den;
+        if (scaled == std::floor(scaled) && scaled > 0 && scaled < (1 << 16))
+        {
+            num = static_cast<int64_t>(scaled);
+            return true;
+        }
+    }
+    return false;
+}
+
 void getKernelParams(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& onnx_node, nvinfer1::Dims* kernel_size,
     nvinfer1::Dims* strides, nvinfer1::Dims* beg_padding, nvinfer1::Dims* end_padding,
     nvinfer1::PaddingMode& paddingMode, bool& count_exclude_padding, nvinfer1::Dims* dilations,
@@ -863,13 +1733,44 @@ nvinfer1::ITensor* globalPoolingHelper(IImporterContext* ctx, nvinfer1::ITensor&
     return ctx->network()->addReduce(tensor, op, reduceAxes, /*keepDimensions=*/true)->getOutput(0);
 }
 
+namespace
+{
+
+const char* const kPluginNamespace = "ONNXTRT_NAMESPACE";
+
+// Logger of the plugin library. The library keeps the logger it is initialized with for the rest of the process,
+// so it cannot be the logger of a parser, which may be destroyed while other parsers and engines still use plugins.
+class PluginLibraryLogger : public nvinfer1::ILogger
+{
+public:
+    void log(Severity severity, const char* msg) override
+    {
+        if (severity <= Severity::kWARNING)
+        {
+            std::cerr << "[TensorRT plugins] " << msg << std::endl;
+        }
+    }
+};
+
+} // namespace
+
+void initPluginLibrary()
+{
+    static std::once_flag pluginsInitialized;
+    std::call_once(pluginsInitialized, []() {
+        // Never destroyed, as plugins may log until the process exits
+        static auto* logger = new PluginLibraryLogger;
+        initLibNvInferPlugins(static_cast<void*>(logger), kPluginNamespace);
+    });
+}
+
 nvinfer1::IPluginV2* importPluginFromRegistry(IImporterContext* ctx, const std::string& pluginName,
     const std::string& pluginVersion, const std::string& nodeName,
     const std::vector<nvinfer1::PluginField>& pluginFields)
 {
     const auto mPluginRegistry = getPluginRegistry();
     const auto pluginCreator
-        = mPluginRegistry->getPluginCreator(pluginName.c_str(), pluginVersion.c_str(), "ONNXTRT_NAMESPACE");
+        = mPluginRegistry->getPluginCreator(pluginName.c_str(), pluginVersion.c_str(), kPluginNamespace);
 
     if (!pluginCreator)
     {
@@ -883,11 +1784,94 @@ nvinfer1::IPluginV2* importPluginFromRegistry(IImporterContext* ctx, const std::
     return pluginCreator->createPlugin(nodeName.c_str(), &fc);
 }
 
+NodeImportResult instanceNormHelper(IImporterContext* ctx, nvinfer1::ITensor& input, ShapedWeights const& scale,
+    ShapedWeights const& bias, float epsilon)
+{
+    const int nbDims = input.getDimensions().nbDims;
+    ASSERT(nbDims >= 3 && nbDims <= 5, ErrorCode::kUNSUPPORTED_NODE);
+    ASSERT(scale.type == ::ONNX_NAMESPACE::TensorProto::FLOAT && bias.type == ::ONNX_NAMESPACE::TensorProto::FLOAT,
+        ErrorCode::kUNSUPPORTED_NODE);
+    nvinfer1::INetworkDefinition* net = ctx->network();
+
+    // Scale layers require 4D or 5D inputs, so 1D instances get a trailing unit dimension.
+    nvinfer1::ITensor* tensor = &input;
+    if (nbDims == 3)
+    {
+        tensor = unsqueezeTensor(ctx, input, {3});
+        ASSERT(tensor, ErrorCode::kUNSUPPORTED_NODE);
+    }
+    uint32_t spatialAxes = 0;
+    for (int axis = 2; axis < tensor->getDimensions().nbDims; ++axis)
+    {
+        spatialAxes |= 1U << axis;
+    }
+
+    // y = (x - mean) / sqrt(variance + epsilon) * scale + bias, with statistics over the spatial axes of each
+    // instance and channel. Reduce layers accept dynamic spatial dimensions.
+    nvinfer1::ITensor* mean
+        = net->addReduce(*tensor, nvinfer1::ReduceOperation::kAVG, spatialAxes, true)->getOutput(0);
+    nvinfer1::ITensor* centered
+        = net->addElementWise(*tensor, *mean, nvinfer1::ElementWiseOperation::kSUB)->getOutput(0);
+    nvinfer1::ITensor* squared
+        = net->addElementWise(*centered, *centered, nvinfer1::ElementWiseOperation::kPROD)->getOutput(0);
+    nvinfer1::ITensor* variance
+        = net->addReduce(*squared, nvinfer1::ReduceOperation::kAVG, spatialAxes, true)->getOutput(0);
+
+    // A uniform scale layer computes (variance * 1 + epsilon) ^ -0.5 in one step.
+    ShapedWeights shift = ctx->createTempWeights(::ONNX_NAMESPACE::TensorProto::FLOAT, nvinfer1::Dims{1, {1}});
+    static_cast<float*>(shift.values)[0] = epsilon;
+    ShapedWeights power = ctx->createTempWeights(::ONNX_NAMESPACE::TensorProto::FLOAT, nvinfer1::Dims{1, {1}});
+    static_cast<float*>(power.values)[0] = -0.5f;
+    NodeImportResult invStdDev = scaleHelper(
+        ctx, *variance, nvinfer1::ScaleMode::kUNIFORM, shift, ShapedWeights::empty(shift.type), power);
+    if (invStdDev.is_error())
+    {
+        return invStdDev;
+    }
+    nvinfer1::ITensor* normalized = net->addElementWise(*centered, invStdDev.value().at(0).tensor(),
+                                           nvinfer1::ElementWiseOperation::kPROD)
+                                        ->getOutput(0);
+
+    // The per-channel affine transform folds scale and bias into a single channel scale layer.
+    NodeImportResult result = scaleHelper(
+        ctx, *normalized, nvinfer1::ScaleMode::kCHANNEL, bias, scale, ShapedWeights::empty(scale.type));
+    if (result.is_error() || nbDims != 3)
+    {
+        return result;
+    }
+    nvinfer1::ITensor* output = squeezeTensor(ctx, result.value().at(0).tensor(), {3});
+    ASSERT(output, ErrorCode::kUNSUPPORTED_NODE);
+    return {{output}};
+}
+
 bool isDynamic(const nvinfer1::Dims& shape)
 {
     return std::any_of(shape.d, shape.d + shape.nbDims, [](int dim) { return dim < 0; });
 }
 
+bool isIdentityResize(ResizeTaps const& taps, int64_t inSize)
+{
+    if (taps.indices.front().size() != static_cast<size_t>(inSize))
+    {
+        return false;
+    }
+    for (int64_t i = 0; i < inSize; ++i)
+    {
+        double self = 0;
+        double other = 0;
+        for (size_t k = 0; k < taps.indices.size(); ++k)
+        {
+            const double weight = taps.weights.empty() ? 1. : taps.weights[k][i];
+            (taps.indices[k][i] == i ? self : other) += std::abs(weight);
+        }
+        if (self != 1 || other != 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool isOnnxTensorEmpty(const ::ONNX_NAMESPACE::TensorProto& onnxTensor)
 {
     return onnxTensor.raw_data().empty() && onnxTensor.double_data().empty()
@@ -921,276 +1905,6 @@ bool isTransposeRequired(nvinfer1::Dims const& shape, nvinfer1::Permutation cons
     return false;
 }
 
-NodeImportResult lstmLegacyImporter(
-    IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs)
-{
-    // Input
-    nvinfer1::ITensor& raw_input = convertToTensor(inputs.at(0), ctx);
-    ASSERT(3 == raw_input.getDimensions().nbDims && "Input tensor must be 3 dimensional", ErrorCode::kINVALID_NODE);
-    ASSERT((raw_input.getType() == nvinfer1::DataType::kFLOAT || raw_input.getType() == nvinfer1::DataType::kHALF)
-            && "Only fp16 and fp32 inputs are supported",
-        ErrorCode::kUNSUPPORTED_NODE);
-    const nvinfer1::DataType input_type = raw_input.getType();
-    const int32_t max_seq_len = raw_input.getDimensions().d[0];
-    const int32_t batch_size = raw_input.getDimensions().d[1];
-
-    // Attributes
-    OnnxAttrs attrs(node, ctx);
-    const std::string direction_str = attrs.get<std::string>("direction", "forward");
-    ASSERT((direction_str == "forward" || direction_str == "bidirectional") && "Reverse LSTM unsupported",
-        ErrorCode::kUNSUPPORTED_NODE);
-    const nvinfer1::RNNDirection direction
-        = (direction_str == "forward") ? nvinfer1::RNNDirection::kUNIDIRECTION : nvinfer1::RNNDirection::kBIDIRECTION;
-    const int num_directions = (direction_str == "forward") ? 1 : 2;
-    // There are three distinct uses of an activation function within the LSTM equations
-    // One for the input/forget/output gates, one for the cell state, and one for the output
-    // RNNv2 only supports the default choice for each, listed here (duplicated for bidirectional)
-    std::vector<std::string> default_activations = {"Sigmoid", "Tanh", "Tanh"};
-    if (num_directions == 2)
-    {
-        default_activations.insert(default_activations.end(), {"Sigmoid", "Tanh", "Tanh"});
-    }
-    const std::vector<std::string> activations
-        = attrs.get<std::vector<std::string>>("activations", default_activations);
-    ASSERT(activations == default_activations && "Nonstandard activations within LSTM unsupported",
-        ErrorCode::kUNSUPPORTED_NODE);
-    const float clip = attrs.get<float>("clip", 0.0f);
-    ASSERT(clip == 0.0f && "Clipping unsupported", ErrorCode::kUNSUPPORTED_NODE);
-    const int32_t hidden_size = attrs.get<int>("hidden_size");
-    ASSERT(hidden_size > 0, ErrorCode::kINVALID_NODE);
-    const int32_t input_forget = attrs.get<int>("input_forget", 0);
-    ASSERT(0 == input_forget && "Coupled input/forget unsupported", ErrorCode::kUNSUPPORTED_NODE);
-
-    // Optional Inputs
-    bool has_bias = false;
-    nvinfer1::ITensor* sequence_lens = nullptr;
-    nvinfer1::ITensor* initial_h = nullptr;
-    nvinfer1::ITensor* initial_c = nullptr;
-    for (int i = 3; i < node.input_size(); i++)
-    {
-        const std::string& input_name = node.input(i);
-        if (input_name == "B")
-        {
-            has_bias = true;
-        }
-        else if (input_name == "sequence_lens")
-        {
-            sequence_lens = &(convertToTensor(inputs.at(i), ctx));
-            ASSERT(sequence_lens && sequence_lens->getType() == nvinfer1::DataType::kINT32
-                    && "Failed to process sequence_lens (sequence_lens must be int32)",
-                ErrorCode::kINVALID_NODE);
-        }
-        else if (input_name == "initial_h" || input_name == "initial_c")
-        {
-            nvinfer1::ITensor* output = nullptr;
-            if (inputs.at(i).is_weights())
-            {
-                /* constant->shuffle bug (NVBug 2650549), so we do the transpose manually */
-                ShapedWeights weights = inputs.at(i).weights();
-                const int dtype_size = getDtypeSize(weights.type);
-                const size_t len = num_directions * batch_size * hidden_size * dtype_size;
-                auto* source = reinterpret_cast<unsigned char*>(weights.values);
-                std::vector<unsigned char> buffer;
-                buffer.resize(len);
-                for (int i = 0; i < num_directions; i++)
-                {
-                    for (int j = 0; j < batch_size; j++)
-                    {
-                        for (int k = 0; k < hidden_size; k++)
-                        {
-                            for (int b = 0; b < dtype_size; b++)
-                            {
-                                int src_idx = i * batch_size * hidden_size * dtype_size + j * hidden_size * dtype_size
-                                    + k * dtype_size + b;
-                                int buf_idx = j * num_directions * hidden_size * dtype_size
-                                    + i * hidden_size * dtype_size + k * dtype_size + b;
-                                buffer.at(buf_idx) = source[src_idx];
-                            }
-                        }
-                    }
-                }
-                std::memcpy(weights.values, static_cast<void*>(buffer.data()), len);
-                const nvinfer1::Dims new_dims = {3, {batch_size, num_directions, hidden_size}};
-                output = ctx->network()->addConstant(new_dims, weights)->getOutput(0);
-                ASSERT(output && "Failed to convert initial_h or initial_c weights to constant layer",
-                    ErrorCode::kINTERNAL_ERROR);
-            }
-            else
-            {
-                /* TODO: Once NVBug 2650549 is fixed, we can use just this path instead */
-                /* nvinfer1::ITensor& source = convertToTensor(inputs.at(i), ctx); */
-                nvinfer1::ITensor& source = inputs.at(i).tensor();
-                auto* shuffle_layer = ctx->network()->addShuffle(source);
-                ASSERT(shuffle_layer && "Failed to create initial_h shuffle layer", ErrorCode::kINTERNAL_ERROR);
-                shuffle_layer->setFirstTranspose(nvinfer1::Permutation{1, 0, 2});
-                output = shuffle_layer->getOutput(0);
-            }
-            ASSERT(output->getType() == input_type && "initial_h and initial_c datatype must match input",
-                ErrorCode::kINVALID_NODE);
-            if (input_name == "initial_h")
-            {
-                initial_h = output;
-            }
-            else
-            {
-                initial_c = output;
-            }
-        }
-        else if (input_name == "P")
-        {
-            ASSERT(false && "Peephole connections not supported", ErrorCode::kUNSUPPORTED_NODE);
-        }
-    }
-
-    // Input Shuffle Layer
-    auto* input_shuffle_layer = ctx->network()->addShuffle(raw_input);
-    ASSERT(input_shuffle_layer && "Failed to create input shuffle layer", ErrorCode::kINTERNAL_ERROR);
-    input_shuffle_layer->setFirstTranspose(nvinfer1::Permutation{1, 0, 2});
-
-    // RNNv2 Layer
-    nvinfer1::ITensor& input_seqs = *(input_shuffle_layer->getOutput(0));
-    const nvinfer1::RNNOperation op = nvinfer1::RNNOperation::kLSTM;
-    const int32_t layer_count = 1;
-    auto* layer = ctx->network()->addRNNv2(input_seqs, layer_count, hidden_size, max_seq_len, op);
-    ASSERT(layer && "Failed to create RNNv2 layer", ErrorCode::kINTERNAL_ERROR);
-    layer->setInputMode(nvinfer1::RNNInputMode::kLINEAR);
-    layer->setDirection(direction);
-    if (sequence_lens)
-    {
-        layer->setSequenceLengths(*sequence_lens);
-    }
-    if (initial_h)
-    {
-        layer->setHiddenState(*initial_h);
-    }
-    if (initial_c)
-    {
-        layer->setCellState(*initial_c);
-    }
-
-    // Weights
-    ASSERT(inputs.at(1).is_weights() && "W must be constant", ErrorCode::kUNSUPPORTED_NODE);
-    ASSERT(inputs.at(2).is_weights() && "R must be constant", ErrorCode::kUNSUPPORTED_NODE);
-    ShapedWeights gate_weights = inputs.at(1).weights();
-    ShapedWeights rcur_weights = inputs.at(2).weights();
-
-    nvinfer1::DataType gate_weights_type, rcur_weights_type;
-    ASSERT(convertDtype(gate_weights.type, &gate_weights_type) && "Bad datatype in W", ErrorCode::kINTERNAL_ERROR);
-    ASSERT(convertDtype(rcur_weights.type, &rcur_weights_type) && "Bad datatype in R", ErrorCode::kINTERNAL_ERROR);
-    ASSERT(input_type == gate_weights_type && "W datatype must match X", ErrorCode::kINVALID_NODE);
-    ASSERT(input_type == rcur_weights_type && "R datatype must match X", ErrorCode::kINVALID_NODE);
-
-    ShapedWeights bias_weights;
-    if (has_bias)
-    {
-        ASSERT(inputs.at(3).is_weights() && "B must be constant", ErrorCode::kUNSUPPORTED_NODE);
-        bias_weights = inputs.at(3).weights();
-        nvinfer1::DataType bias_weights_type;
-        ASSERT(convertDtype(bias_weights.type, &bias_weights_type) && "Bad datatype in B", ErrorCode::kINTERNAL_ERROR);
-        ASSERT(input_type == bias_weights_type && "B datatype must match X", ErrorCode::kINVALID_NODE);
-    }
-
-    const int data_size = (input_type == nvinfer1::DataType::kFLOAT) ? 4 : 2;
-    const int input_size = gate_weights.shape.d[2];
-
-    auto weightBuilder
-        = [input_type, data_size, hidden_size, ctx](int layer_index, ShapedWeights& src, int stride, int idx) {
-              nvinfer1::Weights w;
-              int direction_offset = data_size * layer_index * 4 * hidden_size * stride;
-              int gate_offset = data_size * hidden_size * stride * idx;
-              w.type = input_type;
-              w.values = reinterpret_cast<void*>(
-                  reinterpret_cast<unsigned char*>(src.values) + direction_offset + gate_offset);
-              w.count = hidden_size * stride;
-              return w;
-          };
-
-    // RNNv2 requires that a bias be set, even if none is provided
-    auto zeroes = ctx->createTempWeights(gate_weights.type, nvinfer1::Dims{1, {hidden_size}});
-    std::memset(zeroes.values, 0, data_size * hidden_size);
-
-    auto biasBuilder
-        = [input_type, data_size, hidden_size, has_bias, zeroes](int layer_index, ShapedWeights& src, int idx) {
-              nvinfer1::Weights b;
-              int direction_offset = data_size * layer_index * 8 * hidden_size;
-              int gate_offset = data_size * hidden_size * idx;
-              b.type = input_type;
-              if (has_bias)
-              {
-                  b.values = reinterpret_cast<void*>(
-                      reinterpret_cast<unsigned char*>(src.values) + direction_offset + gate_offset);
-              }
-              else
-              {
-                  b.values = zeroes.values;
-              }
-              b.count = hidden_size;
-              return b;
-          };
-
-    for (int layer_index = 0; layer_index < num_directions; layer_index++)
-    {
-        nvinfer1::Weights W_i = weightBuilder(layer_index, gate_weights, input_size, 0);
-        nvinfer1::Weights W_o = weightBuilder(layer_index, gate_weights, input_size, 1);
-        nvinfer1::Weights W_f = weightBuilder(layer_index, gate_weights, input_size, 2);
-        nvinfer1::Weights W_c = weightBuilder(layer_index, gate_weights, input_size, 3);
-        nvinfer1::Weights R_i = weightBuilder(layer_index, rcur_weights, hidden_size, 0);
-        nvinfer1::Weights R_o = weightBuilder(layer_index, rcur_weights, hidden_size, 1);
-        nvinfer1::Weights R_f = weightBuilder(layer_index, rcur_weights, hidden_size, 2);
-        nvinfer1::Weights R_c = weightBuilder(layer_index, rcur_weights, hidden_size, 3);
-
-        bool isW = true;
-        layer->setWeightsForGate(layer_index, nvinfer1::RNNGateType::kINPUT, isW, W_i);
-        layer->setWeightsForGate(layer_index, nvinfer1::RNNGateType::kOUTPUT, isW, W_o);
-        layer->setWeightsForGate(layer_index, nvinfer1::RNNGateType::kFORGET, isW, W_f);
-        layer->setWeightsForGate(layer_index, nvinfer1::RNNGateType::kCELL, isW, W_c);
-        isW = false;
-        layer->setWeightsForGate(layer_index, nvinfer1::RNNGateType::kINPUT, isW, R_i);
-        layer->setWeightsForGate(layer_index, nvinfer1::RNNGateType::kOUTPUT, isW, R_o);
-        layer->setWeightsForGate(layer_index, nvinfer1::RNNGateType::kFORGET, isW, R_f);
-        layer->setWeightsForGate(layer_index, nvinfer1::RNNGateType::kCELL, isW, R_c);
-
-        nvinfer1::Weights B_wi = biasBuilder(layer_index, bias_weights, 0);
-        nvinfer1::Weights B_wo = biasBuilder(layer_index, bias_weights, 1);
-        nvinfer1::Weights B_wf = biasBuilder(layer_index, bias_weights, 2);
-        nvinfer1::Weights B_wc = biasBuilder(layer_index, bias_weights, 3);
-        nvinfer1::Weights B_ri = biasBuilder(layer_index, bias_weights, 4);
-        nvinfer1::Weights B_ro = biasBuilder(layer_index, bias_weights, 5);
-        nvinfer1::Weights B_rf = biasBuilder(layer_index, bias_weights, 6);
-        nvinfer1::Weights B_rc = biasBuilder(layer_index, bias_weights, 7);
-
-        isW = true;
-        layer->setBiasForGate(layer_index, nvinfer1::RNNGateType::kINPUT, isW, B_wi);
-        layer->setBiasForGate(layer_index, nvinfer1::RNNGateType::kOUTPUT, isW, B_wo);
-        layer->setBiasForGate(layer_index, nvinfer1::RNNGateType::kFORGET, isW, B_wf);
-        layer->setBiasForGate(layer_index, nvinfer1::RNNGateType::kCELL, isW, B_wc);
-        isW = false;
-        layer->setBiasForGate(layer_index, nvinfer1::RNNGateType::kINPUT, isW, B_ri);
-        layer->setBiasForGate(layer_index, nvinfer1::RNNGateType::kOUTPUT, isW, B_ro);
-        layer->setBiasForGate(layer_index, nvinfer1::RNNGateType::kFORGET, isW, B_rf);
-        layer->setBiasForGate(layer_index, nvinfer1::RNNGateType::kCELL, isW, B_rc);
-    }
-
-    // Outputs
-    ASSERT(layer->getNbOutputs() == 3, ErrorCode::kINTERNAL_ERROR);
-    ASSERT(node.output_size() <= 3, ErrorCode::kINVALID_NODE);
-    std::vector<TensorOrWeights> outputs;
-    for (int i = 0; i < node.output_size(); i++)
-    {
-        auto* shuffle_layer = ctx->network()->addShuffle(*(layer->getOutput(i)));
-        ASSERT(shuffle_layer && "Failed to create output shuffle layer", ErrorCode::kINTERNAL_ERROR);
-        shuffle_layer->setFirstTranspose(nvinfer1::Permutation{1, 0, 2});
-        if (i == 0)
-        {
-            nvinfer1::Dims Y_dims{4, {max_seq_len, batch_size, num_directions, hidden_size}};
-            shuffle_layer->setReshapeDimensions(Y_dims);
-            shuffle_layer->setSecondTranspose(nvinfer1::Permutation{0, 2, 1, 3});
-        }
-        outputs.emplace_back(shuffle_layer->getOutput(0));
-    }
-    return {outputs};
-}
-
 nvinfer1::Dims makeDims(int nbDims, int val)
 {
     nvinfer1::Dims dims;
@@ -1251,6 +1965,7 @@ NodeImportResult poolingHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProt
 
     getKernelParams(ctx, node, &kernel_size, &strides, &beg_padding, &end_padding, paddingMode, exclude_padding,
         nullptr, nullptr, ceilMode);
+    addFoldedPadding(ctx, node, beg_padding, end_padding);
     if (needToExpandDims)
     {
         kernel_size = insertDimension(kernel_size, nbSpatialDims, 1);
@@ -1348,8 +2063,142 @@ nvinfer1::ITensor* reshapeTensor(IImporterContext* ctx, nvinfer1::ITensor& tenso
     return layer->getOutput(0);
 }
 
+NodeImportResult rnnv2Helper(
+    IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs)
+{
+    OnnxAttrs attrs(node, ctx);
+    const std::string& opType = node.op_type();
+    const bool bidirectional = attrs.get<std::string>("direction", "forward") == "bidirectional";
+    const int numDirections = bidirectional ? 2 : 1;
+    const int hiddenSize = attrs.get<int>("hidden_size");
+
+    // Gates are listed in ONNX order, so gate i of W, R and B is at offset i * hiddenSize within each direction.
+    nvinfer1::RNNOperation op;
+    std::vector<nvinfer1::RNNGateType> gates;
+    if (opType == "LSTM")
+    {
+        op = nvinfer1::RNNOperation::kLSTM;
+        gates = {nvinfer1::RNNGateType::kINPUT, nvinfer1::RNNGateType::kOUTPUT, nvinfer1::RNNGateType::kFORGET,
+            nvinfer1::RNNGateType::kCELL};
+    }
+    else if (opType == "GRU")
+    {
+        op = nvinfer1::RNNOperation::kGRU;
+        gates = {nvinfer1::RNNGateType::kUPDATE, nvinfer1::RNNGateType::kRESET, nvinfer1::RNNGateType::kHIDDEN};
+    }
+    else
+    {
+        const auto activations = attrs.get<std::vector<std::string>>("activations", {"Tanh"});
+        op = activations.front() == "Relu" ? nvinfer1::RNNOperation::kRELU : nvinfer1::RNNOperation::kTANH;
+        gates = {nvinfer1::RNNGateType::kINPUT};
+    }
+    const int numGates = gates.size();
+
+    // RNNv2 takes batch-major sequences (B, S, E) and states (B, numDirections, H), while ONNX is sequence-major.
+    nvinfer1::ITensor& input = inputs.at(0).tensor();
+    const int maxSeqLen = input.getDimensions().d[0];
+    const nvinfer1::Permutation swapLeadingDims{1, 0, 2};
+    nvinfer1::ITensor* batchMajorInput = transposeTensor(ctx, input, swapLeadingDims, false);
+    ASSERT(batchMajorInput && "Failed to transpose RNN input", ErrorCode::kINTERNAL_ERROR);
+
+    nvinfer1::IRNNv2Layer* layer = ctx->network()->addRNNv2(*batchMajorInput, 1, hiddenSize, maxSeqLen, op);
+    ASSERT(layer && "Failed to create RNNv2 layer", ErrorCode::kINTERNAL_ERROR);
+    layer->setInputMode(nvinfer1::RNNInputMode::kLINEAR);
+    layer->setDirection(bidirectional ? nvinfer1::RNNDirection::kBIDIRECTION : nvinfer1::RNNDirection::kUNIDIRECTION);
+
+    const auto hasInput = [&inputs](size_t index) { return inputs.size() > index && inputs.at(index); };
+    const auto batchMajorState = [&ctx, &inputs, &swapLeadingDims](size_t index) -> nvinfer1::ITensor* {
+        if (inputs.at(index).is_tensor())
+        {
+            return transposeTensor(ctx, inputs.at(index).tensor(), swapLeadingDims, false);
+        }
+        // constant->shuffle bug (NVBug 2650549), so constant states are transposed on the host.
+        ShapedWeights const& state = inputs.at(index).weights();
+        ShapedWeights transposed = ctx->createTempWeights(state.type, state.shape);
+        if (!transposeWeights(state, swapLeadingDims, &transposed))
+        {
+            return nullptr;
+        }
+        return ctx->network()->addConstant(transposed.shape, transposed)->getOutput(0);
+    };
+    if (hasInput(4))
+    {
+        layer->setSequenceLengths(convertToTensor(inputs.at(4), ctx));
+    }
+    if (hasInput(5))
+    {
+        nvinfer1::ITensor* initialHidden = batchMajorState(5);
+        ASSERT(initialHidden && "Failed to transpose initial_h", ErrorCode::kINTERNAL_ERROR);
+        layer->setHiddenState(*initialHidden);
+    }
+    if (op == nvinfer1::RNNOperation::kLSTM && hasInput(6))
+    {
+        nvinfer1::ITensor* initialCell = batchMajorState(6);
+        ASSERT(initialCell && "Failed to transpose initial_c", ErrorCode::kINTERNAL_ERROR);
+        layer->setCellState(*initialCell);
+    }
+
+    // W is (numDirections, numGates * H, E), R is (numDirections, numGates * H, H) and B is
+    // (numDirections, 2 * numGates * H), holding the input biases of all gates followed by the recurrent ones.
+    // Each gate is a contiguous slice, so it is passed to RNNv2 in place.
+    ShapedWeights const& gateWeights = inputs.at(1).weights();
+    ShapedWeights const& recurrentWeights = inputs.at(2).weights();
+    const int64_t inputSize = gateWeights.shape.d[2];
+    nvinfer1::DataType type;
+    ASSERT(convertDtype(gateWeights.type, &type), ErrorCode::kUNSUPPORTED_NODE);
+    const auto slice = [type](ShapedWeights const& weights, int64_t offset, int64_t count) {
+        auto* values = static_cast<unsigned char*>(weights.values) + offset * getDtypeSize(weights.type);
+        return nvinfer1::Weights{type, values, count};
+    };
+
+    // RNNv2 requires that a bias be set, even if none is provided.
+    ShapedWeights bias;
+    if (hasInput(3))
+    {
+        bias = inputs.at(3).weights();
+    }
+    else
+    {
+        bias = ctx->createTempWeights(gateWeights.type, nvinfer1::Dims2{numDirections, 2 * numGates * hiddenSize});
+        std::memset(bias.values, 0, bias.size_bytes());
+    }
+
+    for (int direction = 0; direction < numDirections; ++direction)
+    {
+        for (int gate = 0; gate < numGates; ++gate)
+        {
+            const int64_t row = static_cast<int64_t>(direction * numGates + gate) * hiddenSize;
+            const int64_t biasOffset = static_cast<int64_t>(direction) * 2 * numGates * hiddenSize + gate * hiddenSize;
+            layer->setWeightsForGate(
+                direction, gates[gate], true, slice(gateWeights, row * inputSize, hiddenSize * inputSize));
+            layer->setWeightsForGate(
+                direction, gates[gate], false, slice(recurrentWeights, row * hiddenSize, hiddenSize * hiddenSize));
+            layer->setBiasForGate(direction, gates[gate], true, slice(bias, biasOffset, hiddenSize));
+            layer->setBiasForGate(
+                direction, gates[gate], false, slice(bias, biasOffset + numGates * hiddenSize, hiddenSize));
+        }
+    }
+
+    // Y is (S, numDirections, B, H), Y_h and Y_c are (numDirections, B, H).
+    ASSERT(node.output_size() <= layer->getNbOutputs(), ErrorCode::kINVALID_NODE);
+    std::vector<TensorOrWeights> outputs;
+    for (int i = 0; i < node.output_size(); i++)
+    {
+        nvinfer1::IShuffleLayer* shuffle = ctx->network()->addShuffle(*layer->getOutput(i));
+        ASSERT(shuffle && "Failed to create output shuffle layer", ErrorCode::kINTERNAL_ERROR);
+        shuffle->setFirstTranspose(swapLeadingDims);
+        if (i == 0)
+        {
+            shuffle->setReshapeDimensions(nvinfer1::Dims4{maxSeqLen, -1, numDirections, hiddenSize});
+            shuffle->setSecondTranspose(nvinfer1::Permutation{0, 2, 1, 3});
+        }
+        outputs.emplace_back(shuffle->getOutput(0));
+    }
+    return {outputs};
+}
+
 NodeImportResult scaleHelper(IImporterContext* ctx, nvinfer1::ITensor& tensor_, nvinfer1::ScaleMode mode,
-    nvinfer1::Weights shift, nvinfer1::Weights scale, nvinfer1::Weights power)
+    nvinfer1::Weights shift, nvinfer1::Weights scale, nvinfer1::Weights power, nvinfer1::IScaleLayer** scaleLayer)
 {
     nvinfer1::ITensor* tensor_ptr = &tensor_;
     nvinfer1::Dims dims = tensor_ptr->getDimensions();
@@ -1400,6 +2249,10 @@ NodeImportResult scaleHelper(IImporterContext* ctx, nvinfer1::ITensor& tensor_,
     power.type = *dtype_ptr;
     auto* layer = ctx->network()->addScaleNd(*tensor_ptr, mode, shift, scale, power, 1);
     ASSERT(layer, ErrorCode::kUNSUPPORTED_NODE);
+    if (scaleLayer)
+    {
+        *scaleLayer = layer;
+    }
     tensor_ptr = layer->getOutput(0);
 
     if (needToExpandDims)
@@ -1411,6 +2264,16 @@ NodeImportResult scaleHelper(IImporterContext* ctx, nvinfer1::ITensor& tensor_,
     return {{tensor_ptr}};
 }
 
+ShapedWeights scaleWeights(IImporterContext* ctx, ShapedWeights const& weights, float scale)
+{
+    assert(weights.type == ::ONNX_NAMESPACE::TensorProto::FLOAT);
+    ShapedWeights scaled = ctx->createTempWeights(weights.type, weights.shape);
+    const float* src = static_cast<const float*>(weights.values);
+    float* dst = static_cast<float*>(scaled.values);
+    std::transform(src, src + weights.count(), dst, [scale](float value) { return value * scale; });
+    return scaled;
+}
+
 void setAttr(
     nvinfer1::Dims* trtAttr, ::ONNX_NAMESPACE::AttributeProto const* onnxAttr, int nbSpatialDims, int defaultVal)
 {
@@ -1429,6 +2292,60 @@ void setAttr(
     }
 }
 
+NodeImportResult softmaxHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node,
+    std::vector<TensorOrWeights>& inputs, bool isLogSoftmax)
+{
+    OnnxAttrs attrs(node, ctx);
+    // "input : T"
+    nvinfer1::ITensor& input = convertToTensor(inputs.at(0), ctx);
+    const nvinfer1::Dims inputDims = input.getDimensions();
+
+    // "axis : int (default is 1)"
+    int axis = attrs.get("axis", 1);
+
+    // "Negative value means counting dimensions from the back.
+    // Accepted range is [-r, r-1] where r = rank(input)."
+    TRT_CHECK(convertAxis(axis, inputDims.nbDims));
+
+    // "The input does not need to explicitly be a 2D vector; rather, it will be coerced into one."
+    // The softmax is over the dimensions from axis onwards. If at most one of them can differ from 1, it is a softmax
+    // over that dimension alone, which TRT can compute in place.
+    int softmaxAxis = axis;
+    int nbNonUnitDims = 0;
+    for (int i = axis; i < inputDims.nbDims; ++i)
+    {
+        if (inputDims.d[i] != 1)
+        {
+            softmaxAxis = i;
+            ++nbNonUnitDims;
+        }
+    }
+    nvinfer1::ITensor* tensor = &input;
+    const bool flatten = nbNonUnitDims > 1;
+    if (flatten)
+    {
+        tensor = flattenTensor(ctx, input, axis);
+        // ONNX softmax is then on the second dimension.
+        softmaxAxis = 1;
+    }
+    nvinfer1::ISoftMaxLayer* softMax = ctx->network()->addSoftMax(*tensor);
+    ASSERT(softMax, ErrorCode::kUNSUPPORTED_NODE);
+    softMax->setAxes(1 << softmaxAxis);
+    tensor = softMax->getOutput(0);
+
+    // Take the log before restoring the shape, so that the builder can fuse it with the softmax.
+    if (isLogSoftmax)
+    {
+        tensor = ctx->network()->addUnary(*tensor, nvinfer1::UnaryOperation::kLOG)->getOutput(0);
+    }
+    if (flatten)
+    {
+        // Reshape back to original shape
+        tensor = addShuffle(ctx, *tensor, shapeOf(ctx, input))->getOutput(0);
+    }
+    return {{tensor}};
+}
+
 nvinfer1::ITensor* squeezeTensor(IImporterContext* ctx, nvinfer1::ITensor& tensor, const std::vector<int>& axes)
 {
     const ShapeTensor dims = shapeOf(ctx, tensor);
@@ -1529,6 +2446,7 @@ NodeImportResult convMultiInput(
     bool exclude_padding;
     getKernelParams(
         ctx, node, &filter_dim, &strides, &beg_padding, &end_padding, paddingMode, exclude_padding, &dilations);
+    addFoldedPadding(ctx, node, beg_padding, end_padding);
 
     for (int i = 1; i <= nbSpatialDims; ++i)
     {
@@ -95,6 +95,8 @@ static std::ostream& operator<<(std::ostream& stream, const nvinfer1::DataType&
 namespace onnx2trt
 {
 
+class ShapeTensor;
+
 // Helper function to calculate the volume of a Dims object
 int64_t volume(const nvinfer1::Dims& dims);
 
@@ -131,6 +133,24 @@ enum ScaleOp
     kPOWER,
 };
 
+// ONNX Resize attributes that determine how output positions map to input values.
+struct ResizeParams
+{
+    std::string mode;
+    std::string transformationMode;
+    std::string nearestMode;
+    float cubicCoeffA;
+    bool excludeOutside;
+};
+
+// Interpolation along one axis, as output[i] = sum over taps k of input[indices[k][i]] * weights[k][i]. Nearest
+// resizing has a single tap and no weights. Input positions past the edges are clamped, as in the ONNX reference.
+struct ResizeTaps
+{
+    std::vector<std::vector<int32_t>> indices;
+    std::vector<std::vector<float>> weights;
+};
+
 // Helper function to import ONNX activation nodes into TRT
 NodeImportResult activationHelper(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node,
     std::vector<TensorOrWeights>& inputs, nvinfer1::ActivationType op, float* alpha = nullptr, float* beta = nullptr);
@@ -138,6 +158,21 @@ NodeImportResult activationHelper(IImporterContext* ctx, const ::ONNX_NAMESPACE:
 // Add clipping to a tensor if clip is a valid value.
 nvinfer1::ITensor* addClip(IImporterContext* ctx, nvinfer1::ITensor* input, float clip);
 
+// Helper function to build the taps of one Resize axis in the network, for axes whose input or output size is
+// only known at runtime. Weights are shaped to broadcast along axis.
+Status addDynamicResizeTaps(IImporterContext* ctx, ResizeParams const& params, ShapeTensor const& inSize,
+    ShapeTensor const& outSize, nvinfer1::ITensor& scale, int rank, int axis, nvinfer1::DataType type,
+    std::vector<nvinfer1::ITensor*>& indices, std::vector<nvinfer1::ITensor*>& weights);
+
+// Helper function to add the padding of a Pad node that was folded into this Conv or pooling node (see the Pad
+// importer) to the padding of its spatial dimensions
+void addFoldedPadding(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, nvinfer1::Dims& begPadding,
+    nvinfer1::Dims& endPadding);
+
+// Helper function to interpolate along one axis, as the sum over taps k of gather(input, indices[k], axis) * weights[k]
+nvinfer1::ITensor* applyResizeTaps(IImporterContext* ctx, nvinfer1::ITensor& input, int axis,
+    std::vector<nvinfer1::ITensor*> const& indices, std::vector<nvinfer1::ITensor*> const& weights);
+
 // Helper function to import ArgMax and ArgMin nodes into TRT
 NodeImportResult argMinMaxHelper(IImporterContext* ctx, const ::ONNX_NAMESPACE::NodeProto& node,
     std::vector<TensorOrWeights>& inputs, nvinfer1::TopKOperation op);
@@ -148,9 +183,21 @@ Status broadcastTensors(IImporterContext* ctx, nvinfer1::ITensor*& t1, nvinfer1:
 // Helper function to broadcast three tensors to the largest one's shape
 Status broadcastTensors(IImporterContext* ctx, nvinfer1::ITensor*& t1, nvinfer1::ITensor*& t2, nvinfer1::ITensor*& t3);
 
+// Helper function to check whether a QuantizeLinear or DequantizeLinear node can be folded into constant weights or a
+// dynamic range. Logs the reason when it cannot.
+bool canFoldQuantization(
+    IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs);
+
 // Helper function to check that linear resize can be used
 bool canUseLinearResize(const size_t scaleSize, const float* scaleFactors);
 
+// Helper function to check whether an LSTM, GRU or RNN node can be imported as a fused (cuDNN) IRNNv2Layer. Logs the
+// reason when it cannot.
+bool canUseRNNv2(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs);
+
+// Helper function to compute the taps of one Resize axis whose input and output sizes are known when building
+ResizeTaps computeResizeTaps(ResizeParams const& params, int64_t inSize, int64_t outSize, double scale);
+
 // Helper function for constantOfShape operator. Input shape must be a shape tensor
 nvinfer1::ITensor* constantOfShape(IImporterContext* ctx, nvinfer1::ITensor* constant, nvinfer1::ITensor* shape);
 
@@ -194,13 +241,25 @@ int divCeil(int n, int d);
 // Helper function to check that the input data types for an elementwise operation are supported
 bool elementwiseCheck(const std::vector<TensorOrWeights>& inputs, const nvinfer1::ElementWiseOperation op);
 
-// Helper function to import an ONNX elementwise op into TRT
+// Helper function to import an ONNX elementwise op into TRT. A binary op with a constant operand that is uniform or
+// per-channel is simplified where possible, e.g. to an identity, a unary op or a scale layer.
 NodeImportResult elementwiseHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node,
     std::vector<TensorOrWeights>& inputs, nvinfer1::ElementWiseOperation binary_op);
 
 // Helper function to flatten a tensor on a given axis
 nvinfer1::ITensor* flattenTensor(IImporterContext* ctx, nvinfer1::ITensor& tensor, int axis = 0);
 
+// Helper function to fold a QuantizeLinear or DequantizeLinear node that passes canFoldQuantization(). Constant inputs
+// are quantized or dequantized on the host, and activations are passed through with their dynamic range set.
+NodeImportResult foldQuantizationHelper(
+    IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs);
+
+// Helper function to multiply a matrix of shape [..., M, K] by constant weights using a fully connected layer, giving
+// [..., M, N]. If transposeInput is set, the input must be 2D and is transposed first. The kernel must be laid out as
+// [N, K], and the bias must either have N elements or be empty. The layer is returned through fcLayer if requested.
+nvinfer1::ITensor* fullyConnectedHelper(IImporterContext* ctx, nvinfer1::ITensor& input, bool transposeInput,
+    ShapedWeights const& kernel, ShapedWeights const& bias, nvinfer1::IFullyConnectedLayer** fcLayer = nullptr);
+
 // Gathers the specified dimension from a shape tensor. e.g. gatherDimension(shape=(7, 6, 5), dim=2) would return 5.
 // shape specifies the shape of the returned Tensor. Must have a volume of 1.
 nvinfer1::ITensor* gatherDimension(
@@ -227,6 +286,10 @@ int getConvOutputSize(int input_size, int filter_size, int stride, int dilation_
 // Helper function to get the TRT datatype given an ONNX datatype
 const char* getDtypeName(int32_t onnxDtype);
 
+// Helper function to check whether scale is exactly num / den with den a power of two no larger than 256, so that
+// the output size floor(inSize * scale) can be computed with integer shape arithmetic
+bool getDyadicScale(float scale, int64_t& num, int64_t& den);
+
 // Helper function to get kernel attributes for various ONNX nodes
 void getKernelParams(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& onnx_node, nvinfer1::Dims* kernel_size,
     nvinfer1::Dims* strides, nvinfer1::Dims* beg_padding, nvinfer1::Dims* end_padding,
@@ -239,24 +302,33 @@ nvinfer1::ScaleMode getScaleMode(nvinfer1::Dims const& weights_shape, nvinfer1::
 // Helper function to map ONNX Global Pooling ops into TensorRT.
 nvinfer1::ITensor* globalPoolingHelper(IImporterContext* ctx, nvinfer1::ITensor& tensor, nvinfer1::ReduceOperation op);
 
+// Helper function to register the built-in TensorRT plugins under the namespace that the parser looks them up in.
+// The plugin registry is process-wide, so this only registers them on the first call. Engines that use plugins
+// created by the parser need this before they are deserialized.
+void initPluginLibrary();
+
 // Helper function to get a plugin from the PluginRegistry
 nvinfer1::IPluginV2* importPluginFromRegistry(IImporterContext* ctx, const std::string& pluginName,
     const std::string& pluginVersion, const std::string& nodeName,
     const std::vector<nvinfer1::PluginField>& pluginFields);
 
+// Helper function to import InstanceNormalization as reduce, elementwise and scale layers. Unlike the
+// InstanceNormalization_TRT plugin, this supports dynamic spatial dimensions.
+NodeImportResult instanceNormHelper(IImporterContext* ctx, nvinfer1::ITensor& input, ShapedWeights const& scale,
+    ShapedWeights const& bias, float epsilon);
+
 // Helper function to determine if a shape contains dynamic dimensions
 bool isDynamic(const nvinfer1::Dims& shape);
 
+// Helper function to check whether Resize taps copy each input value to the same position
+bool isIdentityResize(ResizeTaps const& taps, int64_t inSize);
+
 // Helper function to determine if a ONNX tensor is empty
 bool isOnnxTensorEmpty(const ::ONNX_NAMESPACE::TensorProto& onnxTensor);
 
 // Helper function to determine if a transpose is required
 bool isTransposeRequired(nvinfer1::Dims const& shape, nvinfer1::Permutation const& perm);
 
-// Helper function to import LSTM ops through the legacy CUDNN path
-NodeImportResult lstmLegacyImporter(
-    IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs);
-
 // Helper function to create and fill a Dims object with defined values
 nvinfer1::Dims makeDims(int nbDims, int val);
 
@@ -271,14 +343,26 @@ NodeImportResult reduceTensor(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto
 // Helper function to shape a Tensor given a new shape
 nvinfer1::ITensor* reshapeTensor(IImporterContext* ctx, nvinfer1::ITensor& tensor, nvinfer1::Dims shape);
 
-// Helper function to map attributes to a TRT scale layer
+// Helper function to import an LSTM, GRU or RNN node as a fused IRNNv2Layer. The node must pass canUseRNNv2().
+NodeImportResult rnnv2Helper(
+    IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node, std::vector<TensorOrWeights>& inputs);
+
+// Helper function to map attributes to a TRT scale layer. If scaleLayer is not null, it is set to the layer created.
 NodeImportResult scaleHelper(IImporterContext* ctx, nvinfer1::ITensor& tensor_, nvinfer1::ScaleMode mode,
-    nvinfer1::Weights shift, nvinfer1::Weights scale, nvinfer1::Weights power);
+    nvinfer1::Weights shift, nvinfer1::Weights scale, nvinfer1::Weights power,
+    nvinfer1::IScaleLayer** scaleLayer = nullptr);
+
+// Helper function to multiply FLOAT weights by a scalar. The result is a new set of weights.
+ShapedWeights scaleWeights(IImporterContext* ctx, ShapedWeights const& weights, float scale);
 
 // Helper function to set an ONNX attribute
 void setAttr(
     nvinfer1::Dims* trtAttr, ::ONNX_NAMESPACE::AttributeProto const* onnxAttr, int nbSpatialDims, int defaultVal);
 
+// Helper function to import Softmax and LogSoftmax nodes into TRT
+NodeImportResult softmaxHelper(IImporterContext* ctx, ::ONNX_NAMESPACE::NodeProto const& node,
+    std::vector<TensorOrWeights>& inputs, bool isLogSoftmax);
+
 // Helper function to squeeze a tensor on a given set of axes
 nvinfer1::ITensor* squeezeTensor(IImporterContext* ctx, nvinfer1::ITensor& tensor, const std::vector<int>& axes);
 
@@ -1,13 +1,30 @@
 #include "NvOnnxParser.h"
 #include "common.hpp"
+#include "onnx2trt_utils.hpp"
 #include "onnx/onnxifi.h"
+#include "onnx_trt_backend.h"
+#include "onnx_trt_backend_allocator.hpp"
+#include "onnx_trt_backend_batcher.hpp"
 #include <cuda_runtime.h>
 #include <NvInfer.h>
+#include <algorithm>
 #include <atomic>
+#include <climits>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
 #include <ctime>
+#include <deque>
+#include <dirent.h>
+#include <fstream>
+#include <map>
 #include <mutex>
+#include <sstream>
+#include <sys/stat.h>
 #include <thrust/device_vector.h>
+#include <unistd.h>
 #include <unordered_map>
+#include <utime.h>
 
 
 #define BACKEND_NAME          "TensorRT"
@@ -62,25 +79,30 @@ public:
   }
 };
 
+// Checks a tensor against the dimensions of a binding, including the batch
+// dimension. Dynamic (-1) dimensions match any size. With allow_same_size, a
+// tensor with the same number of elements matches too, which is an implicit
+// reshape of an output.
 onnxStatus CheckShape(const nvinfer1::Dims &dims,
                       const onnxTensorDescriptorV1 &desc,
                       bool allow_same_size) {
   bool matched = false;
-  if (desc.dimensions == static_cast<uint32_t>(dims.nbDims) + 1) {
+  if (desc.dimensions == static_cast<uint32_t>(dims.nbDims)) {
     matched = true;
     for (int i = 0; i < dims.nbDims; ++i) {
-      if (desc.shape[i + 1] != static_cast<uint64_t>(dims.d[i])) {
-        return ONNXIFI_STATUS_MISMATCHING_SHAPE;
+      if (dims.d[i] >= 0 &&
+          desc.shape[i] != static_cast<uint64_t>(dims.d[i])) {
+        matched = false;
       }
     }
-  } else if (allow_same_size && desc.dimensions > 1) {
+  }
+  if (!matched && allow_same_size) {
     size_t dim_size = 1;
     for (int i = 0; i < dims.nbDims; ++i) {
       dim_size *= dims.d[i];
     }
     size_t desc_size = 1;
-    // Skip the first dim which is batch size
-    for (uint32_t i = 1; i < desc.dimensions; ++i) {
+    for (uint32_t i = 0; i < desc.dimensions; ++i) {
       desc_size *= desc.shape[i];
     }
     matched = (dim_size == desc_size) ? true : false;
@@ -130,11 +152,185 @@ size_t GetTensorFootprint(const onnxTensorDescriptorV1 &input) {
   return acc * multiplier;
 }
 
+size_t DataTypeSize(nvinfer1::DataType type) {
+  switch (type) {
+  case nvinfer1::DataType::kFLOAT:
+  case nvinfer1::DataType::kINT32:
+    return 4;
+  case nvinfer1::DataType::kHALF:
+    return 2;
+  case nvinfer1::DataType::kINT8:
+  case nvinfer1::DataType::kBOOL:
+    return 1;
+  }
+  return 0;
+}
+
+// Whether tensors of an ONNXIFI data type can be bound to a binding of type.
+// ONNXIFI has no boolean type, so BOOL bindings take UINT8 tensors, which
+// have the same size.
+bool MatchesDataType(nvinfer1::DataType type, onnxEnum data_type) {
+  switch (type) {
+  case nvinfer1::DataType::kFLOAT:
+    return data_type == ONNXIFI_DATATYPE_FLOAT32;
+  case nvinfer1::DataType::kHALF:
+    return data_type == ONNXIFI_DATATYPE_FLOAT16;
+  case nvinfer1::DataType::kINT8:
+    return data_type == ONNXIFI_DATATYPE_INT8;
+  case nvinfer1::DataType::kINT32:
+    return data_type == ONNXIFI_DATATYPE_INT32;
+  case nvinfer1::DataType::kBOOL:
+    return data_type == ONNXIFI_DATATYPE_UINT8;
+  }
+  return false;
+}
+
+// Shapes of the network inputs in an optimization profile, by input name and
+// indexed by nvinfer1::OptProfileSelector. Ordered, so that they hash the same
+// way every time.
+struct ProfileShapes {
+  std::map<std::string, nvinfer1::Dims> shapes[3];
+};
+
+// Parses comma-separated "input:d0xd1x..." shapes into shapes. Returns false
+// if str is malformed.
+bool ParseShapes(const char *str,
+                 std::map<std::string, nvinfer1::Dims> *shapes) {
+  std::istringstream items(str);
+  std::string item;
+  while (std::getline(items, item, ',')) {
+    const size_t colon = item.rfind(':');
+    if (colon == std::string::npos || colon == 0) {
+      return false;
+    }
+    nvinfer1::Dims dims;
+    dims.nbDims = 0;
+    std::istringstream sizes(item.substr(colon + 1));
+    std::string size;
+    while (std::getline(sizes, size, 'x')) {
+      if (dims.nbDims == nvinfer1::Dims::MAX_DIMS || size.empty() ||
+          size.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+      }
+      dims.d[dims.nbDims++] = std::atoi(size.c_str());
+    }
+    // Scalars have no dynamic dimensions
+    if (dims.nbDims == 0) {
+      return false;
+    }
+    (*shapes)[item.substr(0, colon)] = dims;
+  }
+  return true;
+}
+
+// Builder and runtime settings of a graph: the defaults of its backend, from
+// the environment and the properties of onnxInitBackend, overridden by the
+// properties of onnxInitGraph. See onnx_trt_backend.h.
+struct GraphConfig {
+  size_t max_workspace_size{1024UL * 1024UL * 1024UL * 2UL};
+  bool fp16{false};
+  bool int8{false};
+  int dla_core{-1}; // Run on the GPU
+  size_t max_batch_size{128};
+  int num_execution_contexts{1};
+  std::string engine_cache_dir;
+  ProfileShapes profile_shapes;
+  bool dynamic_batching{false};
+  uint64_t batching_delay_us{1000};
+  bool cuda_graphs{false};
+
+  static GraphConfig FromEnvironment() {
+    GraphConfig config;
+    if (const char *dir = std::getenv("ONNX_TRT_ENGINE_CACHE_DIR")) {
+      config.engine_cache_dir = dir;
+    }
+    if (const char *contexts = std::getenv("ONNX_TRT_EXECUTION_CONTEXTS")) {
+      config.num_execution_contexts = std::max(1, std::atoi(contexts));
+    }
+    return config;
+  }
+
+  // Applies a property list. Returns ONNXIFI_STATUS_INVALID_PROPERTY for
+  // unknown properties and invalid values.
+  onnxStatus Update(const uint64_t *properties) {
+    if (!properties) {
+      return ONNXIFI_STATUS_SUCCESS;
+    }
+    for (; properties[0] != ONNXIFI_GRAPH_PROPERTY_NONE; properties += 2) {
+      const uint64_t value = properties[1];
+      const auto *str = reinterpret_cast<const char *>(value);
+      bool valid = true;
+      switch (properties[0]) {
+      case ONNXIFI_BACKEND_PROPERTY_OPTIMIZATION:
+      case ONNXIFI_BACKEND_PROPERTY_LOG_LEVEL:
+        // Standard hints, which the builder has no use for
+        break;
+      case ONNX_TRT_PROPERTY_MAX_WORKSPACE_SIZE:
+        max_workspace_size = value;
+        break;
+      case ONNX_TRT_PROPERTY_FP16:
+        fp16 = value != 0;
+        break;
+      case ONNX_TRT_PROPERTY_INT8:
+        int8 = value != 0;
+        break;
+      case ONNX_TRT_PROPERTY_DLA_CORE:
+        valid = value < INT_MAX || value == UINT64_MAX;
+        dla_core = value == UINT64_MAX ? -1 : static_cast<int>(value);
+        break;
+      case ONNX_TRT_PROPERTY_MAX_BATCH_SIZE:
+        valid = value > 0 && value <= INT_MAX;
+        max_batch_size = value;
+        break;
+      case ONNX_TRT_PROPERTY_EXECUTION_CONTEXTS:
+        valid = value > 0 && value <= INT_MAX;
+        num_execution_contexts = static_cast<int>(value);
+        break;
+      case ONNX_TRT_PROPERTY_ENGINE_CACHE_DIR:
+        engine_cache_dir = str ? str : "";
+        break;
+      case ONNX_TRT_PROPERTY_DYNAMIC_BATCHING:
+        dynamic_batching = value != 0;
+        break;
+      case ONNX_TRT_PROPERTY_BATCHING_DELAY_US:
+        batching_delay_us = value;
+        break;
+      case ONNX_TRT_PROPERTY_CUDA_GRAPHS:
+        cuda_graphs = value != 0;
+        break;
+      case ONNX_TRT_PROPERTY_MIN_SHAPES:
+      case ONNX_TRT_PROPERTY_OPT_SHAPES:
+      case ONNX_TRT_PROPERTY_MAX_SHAPES: {
+        const int selector = static_cast<int>(
+            properties[0] == ONNX_TRT_PROPERTY_MIN_SHAPES
+                ? nvinfer1::OptProfileSelector::kMIN
+                : properties[0] == ONNX_TRT_PROPERTY_OPT_SHAPES
+                      ? nvinfer1::OptProfileSelector::kOPT
+                      : nvinfer1::OptProfileSelector::kMAX);
+        valid = str && ParseShapes(str, &profile_shapes.shapes[selector]);
+        break;
+      }
+      default:
+        std::cerr << "Unknown property " << properties[0] << std::endl;
+        return ONNXIFI_STATUS_INVALID_PROPERTY;
+      }
+      if (!valid) {
+        std::cerr << "Invalid value of property " << properties[0]
+                  << std::endl;
+        return ONNXIFI_STATUS_INVALID_PROPERTY;
+      }
+    }
+    return ONNXIFI_STATUS_SUCCESS;
+  }
+};
+
 struct OnnxTensorRTBackendID {
   OnnxTensorRTBackendID(int i) : device_id(i) {}
   int device_id{0};
 };
 
+class OnnxTensorRTEventPool;
+
 class OnnxTensorRTEvent {
 public:
   OnnxTensorRTEvent(cudaStream_t s) : stream_(s) {
@@ -154,19 +350,31 @@ public:
 
     if (cudaEventRecord(event_, stream_) == cudaSuccess) {
       fired_ = true;
+      signalled_.notify_all();
       return ONNXIFI_STATUS_SUCCESS;
     } else {
       return ONNXIFI_STATUS_INTERNAL_ERROR;
     }
   }
 
+  // Blocks until the event is signalled and the work before it is done
   onnxStatus Wait() {
-    std::lock_guard<std::mutex> guard(mutex_);
+    WaitForSignal();
     return (cudaEventSynchronize(event_) == cudaSuccess)
                ? ONNXIFI_STATUS_SUCCESS
                : ONNXIFI_STATUS_INTERNAL_ERROR;
   }
 
+  // Makes the work enqueued on stream from now on wait for the event, without
+  // blocking the host on the GPU work before it. The host only blocks if the
+  // event has not been signalled yet.
+  onnxStatus StreamWait(cudaStream_t stream) {
+    WaitForSignal();
+    return (cudaStreamWaitEvent(stream, event_, 0) == cudaSuccess)
+               ? ONNXIFI_STATUS_SUCCESS
+               : ONNXIFI_STATUS_INTERNAL_ERROR;
+  }
+
   onnxStatus CheckState(onnxEventState *state) {
     std::lock_guard<std::mutex> guard(mutex_);
     if (!fired_) {
@@ -188,10 +396,69 @@ public:
   }
 
 private:
+  friend class OnnxTensorRTEventPool;
+
+  void WaitForSignal() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    signalled_.wait(lock, [this] { return fired_.load(); });
+  }
+
+  // Makes a released event ready to be signalled again on another stream
+  void Reset(cudaStream_t s) {
+    std::lock_guard<std::mutex> guard(mutex_);
+    fired_ = false;
+    stream_ = s;
+  }
+
   std::mutex mutex_;
+  std::condition_variable signalled_;
   std::atomic<bool> fired_{false};
   cudaStream_t stream_{0};
   cudaEvent_t event_;
+  // Set while the event is handed out by a pool, which gets it back on release
+  std::shared_ptr<OnnxTensorRTEventPool> pool_;
+};
+
+// Recycles the events that onnxRunGraph hands out as output fences, and that
+// the caller gives back with onnxReleaseEvent, so that a run does not create
+// a CUDA event.
+class OnnxTensorRTEventPool
+    : public std::enable_shared_from_this<OnnxTensorRTEventPool> {
+public:
+  // Returns an event that is signalled when recorded on stream
+  OnnxTensorRTEvent *Acquire(cudaStream_t stream) {
+    std::unique_ptr<OnnxTensorRTEvent> event;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      if (!free_events_.empty()) {
+        event = std::move(free_events_.back());
+        free_events_.pop_back();
+      }
+    }
+    if (event) {
+      event->Reset(stream);
+    } else {
+      event.reset(new OnnxTensorRTEvent(stream));
+    }
+    event->pool_ = shared_from_this();
+    return event.release();
+  }
+
+  // Takes back an event from Acquire. Returns false for other events.
+  static bool Release(OnnxTensorRTEvent *event) {
+    // Events in the free list do not keep the pool alive
+    std::shared_ptr<OnnxTensorRTEventPool> pool = std::move(event->pool_);
+    if (!pool) {
+      return false;
+    }
+    std::lock_guard<std::mutex> guard(pool->mutex_);
+    pool->free_events_.emplace_back(event);
+    return true;
+  }
+
+private:
+  std::mutex mutex_;
+  std::vector<std::unique_ptr<OnnxTensorRTEvent>> free_events_;
 };
 
 class CudaDeviceGuard {
@@ -218,38 +485,419 @@ private:
   int saved_device_{-1};
   bool need_restore_{false};
 };
+
+// Device memory for the CachingAllocator of a backend.
+class CudaRawAllocator : public onnx2trt::RawAllocator {
+public:
+  explicit CudaRawAllocator(int device_id) : device_id_(device_id) {}
+
+  // Callers set the device with a CudaDeviceGuard
+  void *Allocate(size_t size) override {
+    void *ptr = nullptr;
+    return cudaMalloc(&ptr, size) == cudaSuccess ? ptr : nullptr;
+  }
+
+  // Buffers may be freed when the allocator is destroyed, from any device
+  void Free(void *ptr) override {
+    int saved_device = device_id_;
+    cudaGetDevice(&saved_device);
+    cudaSetDevice(device_id_);
+    cudaFree(ptr);
+    cudaSetDevice(saved_device);
+  }
+
+private:
+  int device_id_;
+};
+
+// Runs the batches of a DynamicBatcher on an execution context of an engine
+// whose inputs and outputs only have a dynamic batch dimension. Inputs are
+// gathered into pinned buffers, so that they are copied to the device
+// asynchronously.
+class EngineBatchExecutor : public onnx2trt::BatchExecutor {
+public:
+  static bool CanBatch(const nvinfer1::ICudaEngine &engine) {
+    const int nbindings =
+        engine.getNbBindings() / engine.getNbOptimizationProfiles();
+    for (int b = 0; b < nbindings; ++b) {
+      const nvinfer1::Dims dims = engine.getBindingDimensions(b);
+      if (dims.nbDims == 0 || dims.d[0] >= 0 ||
+          std::any_of(dims.d + 1, dims.d + dims.nbDims,
+                      [](int d) { return d < 0; })) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  EngineBatchExecutor(std::shared_ptr<nvinfer1::ICudaEngine> engine,
+                      int device_id,
+                      std::shared_ptr<onnx2trt::CachingAllocator> allocator)
+      : engine_(std::move(engine)), device_id_(device_id),
+        allocator_(std::move(allocator)) {
+    CudaDeviceGuard guard(device_id_);
+    if (cudaStreamCreateWithFlags(&stream_, cudaStreamNonBlocking) !=
+        cudaSuccess) {
+      throw std::runtime_error("Cannot create cudaStream");
+    }
+    if (cudaEventCreateWithFlags(&inputs_copied_, cudaEventDisableTiming) !=
+        cudaSuccess) {
+      cudaStreamDestroy(stream_);
+      throw std::runtime_error("Cannot create cudaEvent");
+    }
+    // Uses the first optimization profile
+    context_ = infer_object(engine_->createExecutionContext());
+    const int nbindings =
+        engine_->getNbBindings() / engine_->getNbOptimizationProfiles();
+    max_batch_size_ = SIZE_MAX;
+    for (int b = 0; b < nbindings; ++b) {
+      if (engine_->bindingIsInput(b)) {
+        const nvinfer1::Dims max_dims = engine_->getProfileDimensions(
+            b, 0, nvinfer1::OptProfileSelector::kMAX);
+        max_batch_size_ =
+            std::min(max_batch_size_, static_cast<size_t>(max_dims.d[0]));
+      }
+    }
+    bindings_.assign(engine_->getNbBindings(), nullptr);
+    for (int b = 0; b < nbindings; ++b) {
+      const nvinfer1::Dims dims = engine_->getBindingDimensions(b);
+      size_t row_size = DataTypeSize(engine_->getBindingDataType(b));
+      for (int i = 1; i < dims.nbDims; ++i) {
+        row_size *= dims.d[i];
+      }
+      bindings_[b] = allocator_->Allocate(max_batch_size_ * row_size);
+      if (!bindings_[b]) {
+        throw std::runtime_error("Cannot allocate batch buffers");
+      }
+      if (engine_->bindingIsInput(b)) {
+        void *host = nullptr;
+        if (cudaHostAlloc(&host, max_batch_size_ * row_size,
+                          cudaHostAllocDefault) != cudaSuccess) {
+          throw std::runtime_error("Cannot allocate batch buffers");
+        }
+        host_inputs_.push_back(host);
+        input_bindings_.push_back(b);
+        input_row_sizes_.push_back(row_size);
+      } else {
+        output_bindings_.push_back(b);
+        output_row_sizes_.push_back(row_size);
+      }
+    }
+  }
+
+  ~EngineBatchExecutor() {
+    cudaStreamSynchronize(stream_);
+    for (void *host : host_inputs_) {
+      cudaFreeHost(host);
+    }
+    for (void *device : bindings_) {
+      allocator_->Free(device);
+    }
+    cudaEventDestroy(inputs_copied_);
+    cudaStreamDestroy(stream_);
+  }
+
+  size_t max_batch_size() const override { return max_batch_size_; }
+  const std::vector<size_t> &input_row_sizes() const override {
+    return input_row_sizes_;
+  }
+  const std::vector<size_t> &output_row_sizes() const override {
+    return output_row_sizes_;
+  }
+  cudaStream_t stream() const { return stream_; }
+
+  std::vector<void *> BeginBatch() override {
+    // The inputs of the previous batch must be copied out of the buffers
+    if (cudaEventSynchronize(inputs_copied_) != cudaSuccess) {
+      return {};
+    }
+    return host_inputs_;
+  }
+
+  bool Launch(size_t batch_size) override {
+    CudaDeviceGuard guard(device_id_);
+    for (size_t i = 0; i < input_bindings_.size(); ++i) {
+      const int b = input_bindings_[i];
+      nvinfer1::Dims dims = engine_->getBindingDimensions(b);
+      dims.d[0] = static_cast<int>(batch_size);
+      if (!context_->setBindingDimensions(b, dims)) {
+        return false;
+      }
+      cudaMemcpyAsync(bindings_[b], host_inputs_[i],
+                      batch_size * input_row_sizes_[i],
+                      cudaMemcpyHostToDevice, stream_);
+    }
+    cudaEventRecord(inputs_copied_, stream_);
+    return context_->enqueueV2(bindings_.data(), stream_, nullptr);
+  }
+
+  // The outputs are pageable, which makes each copy return once it is done,
+  // so that a request is completed as soon as its slice is on the host
+  bool CopyOutputs(size_t row, size_t rows,
+                   const std::vector<void *> &outputs) override {
+    CudaDeviceGuard guard(device_id_);
+    for (size_t o = 0; o < output_bindings_.size(); ++o) {
+      const auto *src = static_cast<const char *>(
+                            bindings_[output_bindings_[o]]) +
+                        row * output_row_sizes_[o];
+      if (cudaMemcpyAsync(outputs[o], src, rows * output_row_sizes_[o],
+                          cudaMemcpyDeviceToHost, stream_) != cudaSuccess) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+private:
+  std::shared_ptr<nvinfer1::ICudaEngine> engine_;
+  std::shared_ptr<nvinfer1::IExecutionContext> context_;
+  int device_id_;
+  std::shared_ptr<onnx2trt::CachingAllocator> allocator_;
+  cudaStream_t stream_;
+  cudaEvent_t inputs_copied_;
+  size_t max_batch_size_{0};
+  // Indexed by engine binding
+  std::vector<void *> bindings_;
+  // Indexed like the row sizes
+  std::vector<int> input_bindings_;
+  std::vector<int> output_bindings_;
+  std::vector<void *> host_inputs_;
+  std::vector<size_t> input_row_sizes_;
+  std::vector<size_t> output_row_sizes_;
+};
+
+// An engine whose runs are coalesced by a batcher, shared by the graphs of
+// the same model on a backend
+struct BatchedEngine {
+  std::shared_ptr<nvinfer1::ICudaEngine> engine;
+  size_t max_batch_size{0};
+  cudaStream_t stream; // Of the batcher's executor
+  // Destroyed first, as it runs the requests that are still queued
+  std::unique_ptr<onnx2trt::DynamicBatcher> batcher;
+};
+
+// 64-bit FNV-1a hash, used to key the engine cache.
+class Fnv1aHash {
+public:
+  void Update(const void *data, size_t size) {
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash_ = (hash_ ^ bytes[i]) * UINT64_C(0x100000001b3);
+    }
+  }
+  template <typename T> void Update(const T &value) {
+    Update(&value, sizeof(value));
+  }
+  void Update(const char *str) { Update(str, strlen(str) + 1); }
+
+  uint64_t value() const { return hash_; }
+
+private:
+  uint64_t hash_{UINT64_C(0xcbf29ce484222325)};
+};
+
+const char kEngineCacheMagic[] = "ONNXTRT1";
+const char kEngineCacheExtension[] = ".engine";
+
+// On-disk cache of serialized engines, so that a graph which was initialized
+// before (in this process, an earlier one or another replica sharing the
+// directory) is deserialized instead of being built again. It is enabled by
+// setting ONNX_TRT_PROPERTY_ENGINE_CACHE_DIR or ONNX_TRT_ENGINE_CACHE_DIR to
+// an existing directory. Once the plans in it exceed
+// ONNX_TRT_ENGINE_CACHE_MAX_MB (4096 by default), the least recently used
+// ones are removed.
+class EngineCache {
+public:
+  explicit EngineCache(const std::string &dir) : dir_(dir) {
+    if (const char *max_mb = std::getenv("ONNX_TRT_ENGINE_CACHE_MAX_MB")) {
+      max_size_ = std::strtoull(max_mb, nullptr, 10) << 20;
+    }
+  }
+
+  // Returns the plan stored for key, or an empty vector if there is none.
+  std::vector<char> Load(uint64_t key) const {
+    std::vector<char> plan;
+    const std::string path = PathOf(key);
+    std::ifstream file(path, std::ios::binary);
+    Header header;
+    if (!file ||
+        !file.read(reinterpret_cast<char *>(&header), sizeof(header))) {
+      return plan;
+    }
+    if (memcmp(header.magic, kEngineCacheMagic, sizeof(header.magic)) != 0 ||
+        header.key != key) {
+      return plan;
+    }
+    // A truncated or corrupted file is removed, so that the engine is rebuilt
+    // rather than a bogus size being allocated
+    const std::streamoff data_offset = file.tellg();
+    file.seekg(0, std::ios::end);
+    const std::streamoff file_size = file.tellg();
+    if (data_offset < 0 || file_size < data_offset ||
+        header.size != static_cast<uint64_t>(file_size - data_offset)) {
+      std::cerr << "Corrupted engine cache file " << path << ", removing it"
+                << std::endl;
+      std::remove(path.c_str());
+      return plan;
+    }
+    file.seekg(data_offset);
+    plan.resize(header.size);
+    if (!file.read(plan.data(), plan.size())) {
+      plan.clear();
+      return plan;
+    }
+    // Plans are evicted by modification time, so mark this one as recently used
+    utime(path.c_str(), nullptr);
+    return plan;
+  }
+
+  // Stores a plan for key. The plan is written to a temporary file that is
+  // then renamed, so that concurrent readers never see a partial plan.
+  void Store(uint64_t key, const void *plan, size_t size) const {
+    static std::atomic<unsigned> counter{0};
+    const std::string path = PathOf(key);
+    const std::string tmp_path = path + ".tmp." + std::to_string(getpid()) +
+                                 "." + std::to_string(counter++);
+    Header header;
+    memcpy(header.magic, kEngineCacheMagic, sizeof(header.magic));
+    header.key = key;
+    header.size = size;
+    {
+      std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      file.write(static_cast<const char *>(plan), size);
+      if (!file.flush()) {
+        std::cerr << "Cannot write engine cache file " << tmp_path
+                  << std::endl;
+        std::remove(tmp_path.c_str());
+        return;
+      }
+    }
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+      std::cerr << "Cannot write engine cache file " << path << std::endl;
+      std::remove(tmp_path.c_str());
+      return;
+    }
+    Evict();
+  }
+
+  void Remove(uint64_t key) const { std::remove(PathOf(key).c_str()); }
+
+private:
+  struct Header {
+    char magic[8];
+    uint64_t key;
+    uint64_t size;
+  };
+  std::string PathOf(uint64_t key) const {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx",
+             static_cast<unsigned long long>(key));
+    return dir_ + "/" + name + kEngineCacheExtension;
+  }
+
+  // Removes the least recently used plans until the cache fits its size cap
+  void Evict() const {
+    struct Entry {
+      std::string path;
+      off_t size;
+      time_t mtime;
+    };
+    std::vector<Entry> entries;
+    uint64_t total_size = 0;
+    DIR *dir = opendir(dir_.c_str());
+    if (!dir) {
+      return;
+    }
+    const size_t extension_length = strlen(kEngineCacheExtension);
+    while (const dirent *entry = readdir(dir)) {
+      const std::string name = entry->d_name;
+      struct stat st;
+      if (name.size() <= extension_length ||
+          name.compare(name.size() - extension_length, extension_length,
+                       kEngineCacheExtension) != 0 ||
+          stat((dir_ + "/" + name).c_str(), &st) != 0) {
+        continue;
+      }
+      entries.push_back({dir_ + "/" + name, st.st_size, st.st_mtime});
+      total_size += st.st_size;
+    }
+    closedir(dir);
+    std::sort(entries.begin(), entries.end(),
+              [](const Entry &a, const Entry &b) { return a.mtime < b.mtime; });
+    for (const auto &entry : entries) {
+      if (total_size <= max_size_) {
+        break;
+      }
+      if (std::remove(entry.path.c_str()) == 0) {
+        total_size -= entry.size;
+      }
+    }
+  }
+
+  std::string dir_;
+  uint64_t max_size_{UINT64_C(4096) << 20};
+};
+
+// The parser only supports networks with an explicit batch dimension
+const nvinfer1::NetworkDefinitionCreationFlags kExplicitBatch =
+    1U << static_cast<uint32_t>(
+        nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+
 class OnnxTensorRTBackendRep {
 public:
-  OnnxTensorRTBackendRep(const OnnxTensorRTBackendID &backend_id)
-      : device_id_(backend_id.device_id) {
+  OnnxTensorRTBackendRep(const OnnxTensorRTBackendID &backend_id,
+                         const GraphConfig &config)
+      : device_id_(backend_id.device_id), config_(config) {
     trt_builder_ = infer_object(nvinfer1::createInferBuilder(trt_logger_));
-    trt_builder_->setMaxBatchSize(max_batch_size_);
-    trt_builder_->setMaxWorkspaceSize(max_workspace_size_);
-    trt_network_ = infer_object(trt_builder_->createNetwork());
-    parser_ = infer_object(
-        nvonnxparser::createParser(*trt_network_, trt_logger_));
+    trt_runtime_ = infer_object(nvinfer1::createInferRuntime(trt_logger_));
     CudaDeviceGuard guard(device_id_);
     if (cudaStreamCreate(&stream_) != cudaSuccess) {
       throw std::runtime_error("Cannot create cudaStream");
     }
+    allocator_ = std::make_shared<onnx2trt::CachingAllocator>(
+        std::unique_ptr<onnx2trt::RawAllocator>(
+            new CudaRawAllocator(device_id_)));
+    event_pool_ = std::make_shared<OnnxTensorRTEventPool>();
   }
 
-  ~OnnxTensorRTBackendRep() { cudaStreamDestroy(stream_); }
+  ~OnnxTensorRTBackendRep() {
+    const auto stats = allocator_->stats();
+    std::ostringstream msg;
+    msg << "I/O buffer pool: peak " << stats.peak_allocated_bytes
+        << " bytes in use, peak " << stats.peak_reserved_bytes
+        << " bytes reserved, " << stats.num_cache_hits << " of "
+        << stats.num_allocations << " allocations served from the pool";
+    trt_logger_.log(nvinfer1::ILogger::Severity::kINFO, msg.str().c_str());
+    cudaStreamDestroy(stream_);
+  }
 
   int device_id() const { return device_id_; }
   cudaStream_t stream() const { return stream_; }
+  // Defaults of the settings of this backend's graphs
+  const GraphConfig &config() const { return config_; }
+  // Shared by the graphs of this backend, so that their I/O buffers are
+  // recycled across onnxSetGraphIO calls and graphs
+  const std::shared_ptr<onnx2trt::CachingAllocator> &allocator() const {
+    return allocator_;
+  }
+  // Output fences of the runs of this backend's graphs
+  const std::shared_ptr<OnnxTensorRTEventPool> &event_pool() const {
+    return event_pool_;
+  }
 
-  onnxStatus ImportModel(void const *serialized_onnx_model,
+  onnxStatus ImportModel(nvonnxparser::IParser &parser,
+                         void const *serialized_onnx_model,
                          size_t serialized_onnx_model_size,
                          uint32_t weight_count,
                          onnxTensorDescriptorV1 const *weight_descriptors) {
-    auto succeeded = parser_->parseWithWeightDescriptors(
+    auto succeeded = parser.parseWithWeightDescriptors(
         serialized_onnx_model, serialized_onnx_model_size, weight_count,
         weight_descriptors);
     if (!succeeded) {
-      const auto num_errors = parser_->getNbErrors();
+      const auto num_errors = parser.getNbErrors();
       if (num_errors > 0) {
-        const auto *error = parser_->getError(num_errors - 1);
+        const auto *error = parser.getError(num_errors - 1);
         std::cerr << "Parsing error: " << error->desc() << " at "
                   << error->file() << ":" << error->line() << " ("
                   << error->func() << ")." << std::endl;
@@ -275,75 +923,580 @@ public:
     return ONNXIFI_STATUS_SUCCESS;
   }
 
-  nvinfer1::ICudaEngine *buildCudaEngine() {
-    return trt_builder_->buildCudaEngine(*trt_network_);
+  // Parses a model into a new network and builds its engine, with an
+  // optimization profile per execution context if it has dynamic inputs
+  onnxStatus BuildEngine(void const *serialized_onnx_model,
+                         size_t serialized_onnx_model_size,
+                         uint32_t weight_count,
+                         onnxTensorDescriptorV1 const *weight_descriptors,
+                         const GraphConfig &config,
+                         nvinfer1::ICudaEngine **engine) {
+    auto trt_network =
+        infer_object(trt_builder_->createNetworkV2(kExplicitBatch));
+    // The parser owns weights of the network, so it must outlive the build
+    auto parser =
+        infer_object(nvonnxparser::createParser(*trt_network, trt_logger_));
+    auto ret = ImportModel(*parser, serialized_onnx_model,
+                           serialized_onnx_model_size, weight_count,
+                           weight_descriptors);
+    if (ret != ONNXIFI_STATUS_SUCCESS) {
+      return ret;
+    }
+
+    auto trt_config = infer_object(trt_builder_->createBuilderConfig());
+    trt_config->setMaxWorkspaceSize(config.max_workspace_size);
+    if (config.fp16) {
+      trt_config->setFlag(nvinfer1::BuilderFlag::kFP16);
+    }
+    if (config.int8) {
+      trt_config->setFlag(nvinfer1::BuilderFlag::kINT8);
+    }
+    if (config.dla_core >= 0) {
+      if (config.dla_core >= trt_builder_->getNbDLACores()) {
+        std::cerr << "No DLA core " << config.dla_core << std::endl;
+        return ONNXIFI_STATUS_INVALID_PROPERTY;
+      }
+      // The DLA only runs FP16 and INT8 layers
+      if (!config.int8) {
+        trt_config->setFlag(nvinfer1::BuilderFlag::kFP16);
+      }
+      trt_config->setDefaultDeviceType(nvinfer1::DeviceType::kDLA);
+      trt_config->setDLACore(config.dla_core);
+      trt_config->setFlag(nvinfer1::BuilderFlag::kGPU_FALLBACK);
+    }
+    ret = AddOptimizationProfiles(*trt_network, config, *trt_config);
+    if (ret != ONNXIFI_STATUS_SUCCESS) {
+      return ret;
+    }
+    *engine = trt_builder_->buildEngineWithConfig(*trt_network, *trt_config);
+    return *engine ? ONNXIFI_STATUS_SUCCESS : ONNXIFI_STATUS_INTERNAL_ERROR;
+  }
+
+  // Computes the key of a model and the settings its engine is built with,
+  // which keys the engine cache and the batched engines. Returns false if
+  // the model has no key because its weights are not in CPU memory.
+  bool ModelKey(void const *serialized_onnx_model,
+                size_t serialized_onnx_model_size, uint32_t weight_count,
+                onnxTensorDescriptorV1 const *weight_descriptors,
+                const GraphConfig &config, uint64_t *key) const {
+    Fnv1aHash hash;
+    hash.Update(serialized_onnx_model_size);
+    hash.Update(serialized_onnx_model, serialized_onnx_model_size);
+    hash.Update(weight_count);
+    for (uint32_t i = 0; i < weight_count; ++i) {
+      const auto &weight = weight_descriptors[i];
+      if (weight.memoryType != ONNXIFI_MEMORY_TYPE_CPU) {
+        return false;
+      }
+      hash.Update(weight.name);
+      hash.Update(weight.dataType);
+      hash.Update(weight.dimensions);
+      hash.Update(weight.shape, weight.dimensions * sizeof(uint64_t));
+      hash.Update(reinterpret_cast<const void *>(weight.buffer),
+                  GetTensorFootprint(weight));
+    }
+    // Plans are specific to the builder settings, the TensorRT version and
+    // the device
+    for (const auto &shapes : config.profile_shapes.shapes) {
+      hash.Update(shapes.size());
+      for (const auto &kv : shapes) {
+        hash.Update(kv.first.c_str());
+        hash.Update(kv.second.nbDims);
+        hash.Update(kv.second.d, kv.second.nbDims * sizeof(int));
+      }
+    }
+    hash.Update(config.max_batch_size);
+    hash.Update(config.max_workspace_size);
+    hash.Update(config.fp16);
+    hash.Update(config.int8);
+    hash.Update(config.dla_core);
+    hash.Update(config.num_execution_contexts);
+    hash.Update(getInferLibVersion());
+    cudaDeviceProp properties;
+    if (cudaGetDeviceProperties(&properties, device_id_) != cudaSuccess) {
+      return false;
+    }
+    hash.Update(properties.name);
+    hash.Update(properties.major);
+    hash.Update(properties.minor);
+    *key = hash.value();
+    return true;
+  }
+
+  // Returns the engine stored in engine_cache for key, or nullptr if there
+  // is none or it cannot be deserialized.
+  nvinfer1::ICudaEngine *LoadCachedEngine(const EngineCache &engine_cache,
+                                          uint64_t key, int dla_core) {
+    const std::vector<char> plan = engine_cache.Load(key);
+    if (plan.empty()) {
+      return nullptr;
+    }
+    // Engines may use plugins that would otherwise be registered by parsing,
+    // under the namespace that the parser creates them in
+    onnx2trt::initPluginLibrary();
+    nvinfer1::ICudaEngine *engine = nullptr;
+    {
+      // The runtime is shared by the graphs of this backend, so its DLA core
+      // is set for every load, back to the default for GPU-only ones
+      std::lock_guard<std::mutex> lock(trt_runtime_mutex_);
+      trt_runtime_->setDLACore(std::max(dla_core, 0));
+      engine = trt_runtime_->deserializeCudaEngine(plan.data(), plan.size(),
+                                                   nullptr);
+    }
+    if (!engine) {
+      std::cerr << "Cannot deserialize cached engine, rebuilding it"
+                << std::endl;
+      engine_cache.Remove(key);
+    }
+    return engine;
+  }
+
+  void StoreCachedEngine(const EngineCache &engine_cache, uint64_t key,
+                         nvinfer1::ICudaEngine &engine) {
+    auto plan = infer_object(engine.serialize());
+    engine_cache.Store(key, plan->data(), plan->size());
+  }
+
+  // Returns the batched engine that graphs with the same model key and
+  // batching delay share, or nullptr if there is none
+  std::shared_ptr<BatchedEngine> FindBatchedEngine(uint64_t key,
+                                                   uint64_t delay_us) {
+    std::lock_guard<std::mutex> lock(batched_engines_mutex_);
+    const auto it = batched_engines_.find(std::make_pair(key, delay_us));
+    return it == batched_engines_.end() ? nullptr : it->second.lock();
   }
 
-  size_t max_batch_size() const { return max_batch_size_; }
+  // Creates the batched engine of engine, which it takes ownership of, and
+  // shares it under key if shared. If another graph has created one for key
+  // in the meantime, returns that one instead.
+  std::shared_ptr<BatchedEngine> AddBatchedEngine(uint64_t key, bool shared,
+                                                  nvinfer1::ICudaEngine *engine,
+                                                  uint64_t delay_us) {
+    auto trt_engine = infer_object(engine);
+    std::lock_guard<std::mutex> lock(batched_engines_mutex_);
+    for (auto it = batched_engines_.begin(); it != batched_engines_.end();) {
+      it = it->second.expired() ? batched_engines_.erase(it) : std::next(it);
+    }
+    const auto batch_key = std::make_pair(key, delay_us);
+    if (shared && batched_engines_.count(batch_key)) {
+      return batched_engines_[batch_key].lock();
+    }
+    std::unique_ptr<EngineBatchExecutor> executor(
+        new EngineBatchExecutor(trt_engine, device_id_, allocator_));
+    auto batched = std::make_shared<BatchedEngine>();
+    batched->engine = trt_engine;
+    batched->max_batch_size = executor->max_batch_size();
+    batched->stream = executor->stream();
+    batched->batcher.reset(new onnx2trt::DynamicBatcher(
+        std::move(executor), std::chrono::microseconds(delay_us)));
+    if (shared) {
+      batched_engines_[batch_key] = batched;
+    }
+    return batched;
+  }
 
 private:
+  // Adds the optimization profiles of a network with dynamic input
+  // dimensions. The ranges of an input come from the profile shapes, except
+  // that a dynamic leading (batch) dimension defaults to [1, max batch size].
+  // Each execution context needs a profile of its own, so the profile is
+  // added once per context.
+  onnxStatus AddOptimizationProfiles(nvinfer1::INetworkDefinition &network,
+                                     const GraphConfig &config,
+                                     nvinfer1::IBuilderConfig &trt_config) {
+    std::vector<nvinfer1::IOptimizationProfile *> profiles;
+    for (int i = 0; i < network.getNbInputs(); ++i) {
+      nvinfer1::ITensor *input = network.getInput(i);
+      const nvinfer1::Dims dims = input->getDimensions();
+      if (std::none_of(dims.d, dims.d + dims.nbDims,
+                       [](int d) { return d < 0; })) {
+        continue;
+      }
+      if (input->isShapeTensor()) {
+        std::cerr << "Dynamic shape tensor input " << input->getName()
+                  << " is not supported" << std::endl;
+        return ONNXIFI_STATUS_UNSUPPORTED_SHAPE;
+      }
+      nvinfer1::Dims ranges[3];
+      for (int s = 0; s < 3; ++s) {
+        const auto &shapes = config.profile_shapes.shapes[s];
+        const auto it = shapes.find(input->getName());
+        if (it != shapes.end()) {
+          if (it->second.nbDims != dims.nbDims) {
+            std::cerr << "Profile shape of input " << input->getName()
+                      << " has the wrong rank" << std::endl;
+            return ONNXIFI_STATUS_MISMATCHING_SHAPE;
+          }
+          ranges[s] = it->second;
+          continue;
+        }
+        ranges[s] = dims;
+        for (int d = 0; d < dims.nbDims; ++d) {
+          if (dims.d[d] >= 0) {
+            continue;
+          }
+          if (d != 0) {
+            std::cerr << "No profile shapes given for dynamic input "
+                      << input->getName() << std::endl;
+            return ONNXIFI_STATUS_UNSUPPORTED_SHAPE;
+          }
+          ranges[s].d[d] =
+              s == static_cast<int>(nvinfer1::OptProfileSelector::kMIN)
+                  ? 1
+                  : static_cast<int>(config.max_batch_size);
+        }
+      }
+      if (profiles.empty()) {
+        for (int c = 0; c < config.num_execution_contexts; ++c) {
+          profiles.push_back(trt_builder_->createOptimizationProfile());
+        }
+      }
+      for (auto *profile : profiles) {
+        for (int s = 0; s < 3; ++s) {
+          profile->setDimensions(input->getName(),
+                                 static_cast<nvinfer1::OptProfileSelector>(s),
+                                 ranges[s]);
+        }
+      }
+    }
+    for (auto *profile : profiles) {
+      if (!profile->isValid() ||
+          trt_config.addOptimizationProfile(profile) < 0) {
+        std::cerr << "Invalid optimization profile shapes" << std::endl;
+        return ONNXIFI_STATUS_INVALID_SHAPE;
+      }
+    }
+    return ONNXIFI_STATUS_SUCCESS;
+  }
+
   TRT_Logger trt_logger_;
+  std::mutex trt_runtime_mutex_;
+  std::shared_ptr<nvinfer1::IRuntime> trt_runtime_{nullptr};
+  std::shared_ptr<onnx2trt::CachingAllocator> allocator_{nullptr};
+  std::shared_ptr<OnnxTensorRTEventPool> event_pool_{nullptr};
   cudaStream_t stream_;
   std::shared_ptr<nvinfer1::IBuilder> trt_builder_{nullptr};
-  std::shared_ptr<nvinfer1::INetworkDefinition> trt_network_{nullptr};
-  std::shared_ptr<nvonnxparser::IParser> parser_{nullptr};
-  // TODO: configerable max batch size
   int device_id_{0};
-  size_t max_batch_size_{128};
-  size_t max_workspace_size_{1024UL * 1024UL * 1024UL * 2UL};
+  GraphConfig config_;
+  std::mutex batched_engines_mutex_;
+  std::map<std::pair<uint64_t, uint64_t>, std::weak_ptr<BatchedEngine>>
+      batched_engines_;
 };
 
+// CPU-resident buffers at least this large are page-locked with
+// cudaHostRegister rather than copied through a staging buffer
+const size_t kHostRegisterThreshold = 1UL << 20;
+// Staged host-to-device copies are split into chunks of this size, so that
+// the DMA of one chunk overlaps with staging the next one
+const size_t kCopyChunkSize = 4UL << 20;
+
 class GraphRep {
 public:
-  GraphRep(OnnxTensorRTBackendRep *backendrep)
-      : device_id_(backendrep->device_id()),
-        max_batch_size_(backendrep->max_batch_size()),
-        stream_(backendrep->stream()) {
-    if (cudaSetDevice(device_id_) != cudaSuccess) {
-      throw std::runtime_error("Cannot set CUDA device");
+  GraphRep(OnnxTensorRTBackendRep *backendrep, nvinfer1::ICudaEngine *engine,
+           const GraphConfig &config)
+      : use_cuda_graphs_(config.cuda_graphs),
+        device_id_(backendrep->device_id()),
+        allocator_(backendrep->allocator()),
+        event_pool_(backendrep->event_pool()) {
+    trt_engine_ = infer_object(engine);
+    // The bindings of profile p are those of profile 0, offset by p times
+    // the number of bindings per profile
+    const int num_profiles = trt_engine_->getNbOptimizationProfiles();
+    bindings_per_profile_ = trt_engine_->getNbBindings() / num_profiles;
+    bool dynamic = false;
+    for (int b = 0; b < bindings_per_profile_; ++b) {
+      const nvinfer1::Dims dims = trt_engine_->getBindingDimensions(b);
+      dynamic |= std::any_of(dims.d, dims.d + dims.nbDims,
+                             [](int d) { return d < 0; });
+    }
+    // Contexts of an engine with dynamic shapes cannot share a profile
+    int num_contexts = config.num_execution_contexts;
+    if (dynamic) {
+      num_contexts = std::min(num_contexts, num_profiles);
+    }
+    for (int i = 0; i < num_contexts; ++i) {
+      std::unique_ptr<ExecutionSlot> slot(new ExecutionSlot);
+      // Contexts share the engine's weights, and only add activation memory
+      slot->context = infer_object(trt_engine_->createExecutionContext());
+      if (dynamic) {
+        if (!slot->context->setOptimizationProfile(i)) {
+          throw std::runtime_error("Cannot set optimization profile");
+        }
+        slot->binding_offset = i * bindings_per_profile_;
+      }
+      if (cudaStreamCreateWithFlags(&slot->stream, cudaStreamNonBlocking) !=
+          cudaSuccess) {
+        throw std::runtime_error("Cannot create cudaStream");
+      }
+      // Never resized, so that host functions queued on the stream can point
+      // into it
+      slot->host_transfers.resize(bindings_per_profile_);
+      if (cudaEventCreateWithFlags(&slot->inputs_copied,
+                                   cudaEventDisableTiming) != cudaSuccess) {
+        cudaStreamDestroy(slot->stream);
+        throw std::runtime_error("Cannot create cudaEvent");
+      }
+      free_slots_.push_back(slot.get());
+      slots_.push_back(std::move(slot));
     }
-    trt_engine_ = infer_object(backendrep->buildCudaEngine());
-    max_batch_size_ = backendrep->max_batch_size();
   }
 
-  ~GraphRep() { ClearDeviceBuffers(); }
+  // A graph whose runs are submitted to the batcher of a batched engine
+  GraphRep(OnnxTensorRTBackendRep *backendrep,
+           std::shared_ptr<BatchedEngine> batched)
+      : device_id_(backendrep->device_id()),
+        allocator_(backendrep->allocator()),
+        event_pool_(backendrep->event_pool()), batched_(std::move(batched)) {
+    trt_engine_ = batched_->engine;
+    bindings_per_profile_ = trt_engine_->getNbBindings() /
+                            trt_engine_->getNbOptimizationProfiles();
+  }
 
+  ~GraphRep() {
+    ClearDeviceBuffers();
+    for (auto &slot : slots_) {
+      for (auto &transfer : slot->host_transfers) {
+        cudaFreeHost(transfer.staging);
+      }
+      cudaEventDestroy(slot->inputs_copied);
+      cudaStreamDestroy(slot->stream);
+    }
+  }
+
+  // Must not be called concurrently with Run
   onnxStatus InitIO(uint32_t inputsCount,
                     const onnxTensorDescriptorV1 *inputDescriptors,
                     uint32_t outputsCount,
                     const onnxTensorDescriptorV1 *outputDescriptors);
 
-  onnxStatus Run();
-
-  cudaStream_t stream() const { return stream_; }
+  // Enqueues a run on one of the execution contexts, or submits it to the
+  // batcher, once input_fence (if not null) is signalled, and sets
+  // output_fence to an event signalled when it is done. Thread-safe.
+  onnxStatus Run(OnnxTensorRTEvent *input_fence,
+                 OnnxTensorRTEvent **output_fence);
 
 private:
+  // How a CPU-resident binding is copied to and from its device buffer.
+  // Pageable buffers go through a pinned staging buffer, because CUDA makes
+  // copies from pageable memory synchronous.
+  struct HostTransfer {
+    void *host{nullptr};
+    void *device{nullptr}; // Allocated from the backend's pool
+    size_t size{0};
+    bool direct{false};     // The caller's buffer is pinned
+    bool registered{false}; // ... because PrepareHostTransfer registered it
+    void *staging{nullptr}; // Kept across InitIO calls
+    size_t staging_size{0};
+  };
+
+  // An execution context with its own stream, bindings and buffers, so that
+  // runs on different contexts of the pool proceed concurrently
+  struct ExecutionSlot {
+    std::shared_ptr<nvinfer1::IExecutionContext> context;
+    // Index of the first binding of the context's optimization profile
+    int binding_offset{0};
+    cudaStream_t stream;
+    // Recorded once the inputs of a run are copied out of the staging buffers
+    cudaEvent_t inputs_copied;
+    // Indexed by engine binding, i.e. including the bindings of the other
+    // profiles, which stay null
+    std::vector<void *> bindings;
+    // Indexed by binding of profile 0
+    std::vector<HostTransfer> host_transfers;
+    // Some inputs are copied to staging buffers, i.e. read by the host
+    bool stages_inputs{false};
+    // With CUDA graphs, the run captured after the first one since InitIO,
+    // and whether capturing failed
+    bool ran{false};
+    cudaGraphExec_t graph{nullptr};
+    bool graph_failed{false};
+  };
+
+  using TensorMap =
+      std::unordered_map<std::string, const onnxTensorDescriptorV1 *>;
+
   void ClearDeviceBuffers();
 
-  onnxStatus CheckAndBindTensor(const nvinfer1::Dims &dims,
+  onnxStatus InitBatchedIO(const TensorMap &input_map,
+                           const TensorMap &output_map);
+
+  onnxStatus RunBatched(OnnxTensorRTEvent *input_fence,
+                        OnnxTensorRTEvent **output_fence);
+
+  onnxStatus CheckAndBindTensor(int binding, const nvinfer1::Dims &dims,
                                 const onnxTensorDescriptorV1 &tensor,
                                 bool is_output);
 
+  onnxStatus PrepareHostTransfer(HostTransfer &transfer,
+                                 const onnxTensorDescriptorV1 &tensor,
+                                 size_t size);
+
+  // Copies through the staging buffer unless staged, i.e. unless it already
+  // holds the input
+  void CopyToDevice(const HostTransfer &transfer, cudaStream_t stream,
+                    bool staged = false);
+
+  // Enqueues the copies of the inputs, the TensorRT kernels and the copies of
+  // the outputs
+  onnxStatus Enqueue(ExecutionSlot *slot, bool staged);
+
+  // Captures a run into a CUDA graph for its slot. Returns false if the run
+  // cannot be captured, in which case nothing was enqueued.
+  bool CaptureGraph(ExecutionSlot *slot);
+
+  onnxStatus CopyToHost(HostTransfer &transfer, cudaStream_t stream);
+
+  static void CopyFromStaging(void *transfer);
+
+  // Checks out the context that has been idle longest, waiting for one if
+  // they are all in use, so that consecutive runs go to different streams
+  ExecutionSlot *AcquireSlot();
+
+  void ReleaseSlot(ExecutionSlot *slot);
+
   std::shared_ptr<nvinfer1::ICudaEngine> trt_engine_{nullptr};
-  std::shared_ptr<nvinfer1::IExecutionContext> trt_executor_{nullptr};
-  std::vector<void *> bindings_;
-  std::unordered_map<std::string, const onnxTensorDescriptorV1 *> input_map_;
-  std::unordered_map<std::string, const onnxTensorDescriptorV1 *> output_map_;
-  std::unordered_map<std::string, void *> device_buffers_;
+  int bindings_per_profile_{0};
+  std::vector<std::unique_ptr<ExecutionSlot>> slots_;
+  std::deque<ExecutionSlot *> free_slots_;
+  std::mutex slots_mutex_;
+  std::condition_variable slot_released_;
+  // The plan compiled by InitIO, shared by all contexts: the bindings whose
+  // data is copied from and to CPU memory by Run, in binding order
+  std::vector<int> input_copies_;
+  std::vector<int> output_copies_;
+  bool io_ready_{false};
+  bool use_cuda_graphs_{false};
   int device_id_{0};
-  size_t max_batch_size_{0};
-  size_t batch_size_{0};
-  cudaStream_t stream_;
+  std::shared_ptr<onnx2trt::CachingAllocator> allocator_;
+  std::shared_ptr<OnnxTensorRTEventPool> event_pool_;
+  // Set for graphs with dynamic batching, which have no execution contexts
+  // of their own. Their runs submit the CPU tensors set by InitBatchedIO.
+  std::shared_ptr<BatchedEngine> batched_;
+  size_t batch_rows_{0};
+  std::vector<const void *> batch_inputs_;
+  std::vector<void *> batch_outputs_;
 };
 
 void GraphRep::ClearDeviceBuffers() {
-  for (auto kv : device_buffers_) {
-    cudaFree(kv.second);
+  for (auto &slot : slots_) {
+    // Buffers may still be read by work queued on the stream
+    cudaStreamSynchronize(slot->stream);
+    for (auto &transfer : slot->host_transfers) {
+      allocator_->Free(transfer.device);
+      transfer.device = nullptr;
+      if (transfer.registered) {
+        cudaHostUnregister(transfer.host);
+        transfer.registered = false;
+      }
+    }
+    slot->bindings.clear();
+    slot->stages_inputs = false;
+    // A captured graph has the bindings and shapes of the old I/O baked in
+    if (slot->graph) {
+      cudaGraphExecDestroy(slot->graph);
+      slot->graph = nullptr;
+    }
+    slot->ran = false;
+    slot->graph_failed = false;
+  }
+  input_copies_.clear();
+  output_copies_.clear();
+}
+
+onnxStatus GraphRep::PrepareHostTransfer(HostTransfer &transfer,
+                                         const onnxTensorDescriptorV1 &tensor,
+                                         size_t size) {
+  transfer.host = (void *)(tensor.buffer);
+  transfer.size = size;
+  transfer.direct = false;
+  cudaPointerAttributes attributes;
+  if (cudaPointerGetAttributes(&attributes, transfer.host) == cudaSuccess &&
+      attributes.type == cudaMemoryTypeHost) {
+    transfer.direct = true;
+    return ONNXIFI_STATUS_SUCCESS;
+  }
+  // Per onnxSetGraphIO, the buffer stays valid until the I/O is set again or
+  // the graph is released, so it can be page-locked until then. This fails
+  // e.g. if it shares pages with another registered buffer, or was already
+  // registered for another context.
+  if (size >= kHostRegisterThreshold &&
+      cudaHostRegister(transfer.host, size, cudaHostRegisterDefault) ==
+          cudaSuccess) {
+    transfer.direct = transfer.registered = true;
+    return ONNXIFI_STATUS_SUCCESS;
   }
-  device_buffers_.clear();
+  // Clear the error of the failed calls above
+  cudaGetLastError();
+  if (transfer.staging_size < size) {
+    cudaFreeHost(transfer.staging);
+    transfer.staging = nullptr;
+    transfer.staging_size = 0;
+    if (cudaHostAlloc(&transfer.staging, size, cudaHostAllocDefault) !=
+        cudaSuccess) {
+      return ONNXIFI_STATUS_NO_SYSTEM_MEMORY;
+    }
+    transfer.staging_size = size;
+  }
+  return ONNXIFI_STATUS_SUCCESS;
+}
+
+void GraphRep::CopyToDevice(const HostTransfer &transfer,
+                            cudaStream_t stream, bool staged) {
+  if (transfer.direct || staged) {
+    cudaMemcpyAsync(transfer.device,
+                    transfer.direct ? transfer.host : transfer.staging,
+                    transfer.size, cudaMemcpyHostToDevice, stream);
+    return;
+  }
+  auto *dst = static_cast<char *>(transfer.device);
+  auto *src = static_cast<const char *>(transfer.host);
+  auto *staging = static_cast<char *>(transfer.staging);
+  for (size_t offset = 0; offset < transfer.size; offset += kCopyChunkSize) {
+    const size_t chunk = std::min(kCopyChunkSize, transfer.size - offset);
+    memcpy(staging + offset, src + offset, chunk);
+    cudaMemcpyAsync(dst + offset, staging + offset, chunk,
+                    cudaMemcpyHostToDevice, stream);
+  }
+}
+
+onnxStatus GraphRep::CopyToHost(HostTransfer &transfer, cudaStream_t stream) {
+  if (transfer.direct) {
+    cudaMemcpyAsync(transfer.host, transfer.device, transfer.size,
+                    cudaMemcpyDeviceToHost, stream);
+    return ONNXIFI_STATUS_SUCCESS;
+  }
+  cudaMemcpyAsync(transfer.staging, transfer.device, transfer.size,
+                  cudaMemcpyDeviceToHost, stream);
+  // Copy on to the caller's buffer in stream order, so that the output fence
+  // is only signalled once the output is there
+  return cudaLaunchHostFunc(stream, CopyFromStaging, &transfer) == cudaSuccess
+             ? ONNXIFI_STATUS_SUCCESS
+             : ONNXIFI_STATUS_INTERNAL_ERROR;
 }
 
-onnxStatus GraphRep::CheckAndBindTensor(const nvinfer1::Dims &dims,
+void GraphRep::CopyFromStaging(void *transfer) {
+  const auto *t = static_cast<const HostTransfer *>(transfer);
+  memcpy(t->host, t->staging, t->size);
+}
+
+GraphRep::ExecutionSlot *GraphRep::AcquireSlot() {
+  std::unique_lock<std::mutex> lock(slots_mutex_);
+  slot_released_.wait(lock, [this] { return !free_slots_.empty(); });
+  ExecutionSlot *slot = free_slots_.front();
+  free_slots_.pop_front();
+  return slot;
+}
+
+void GraphRep::ReleaseSlot(ExecutionSlot *slot) {
+  {
+    std::lock_guard<std::mutex> lock(slots_mutex_);
+    free_slots_.push_back(slot);
+  }
+  slot_released_.notify_one();
+}
+
+onnxStatus GraphRep::CheckAndBindTensor(int binding,
+                                        const nvinfer1::Dims &dims,
                                         const onnxTensorDescriptorV1 &tensor,
                                         bool is_output) {
   // Check memory type
@@ -360,18 +1513,31 @@ onnxStatus GraphRep::CheckAndBindTensor(const nvinfer1::Dims &dims,
   // For CPU tensor, we need to create a device memory and the bind. For CUDA
   // tensor, we can bind directly
   if (tensor.memoryType == ONNXIFI_MEMORY_TYPE_CPU) {
-    void *cuda_buffer;
     size_t footprint = GetTensorFootprint(tensor);
     if (!footprint) {
       return ONNXIFI_STATUS_INVALID_SHAPE;
     }
-    if (cudaMalloc(&cuda_buffer, footprint) != cudaSuccess) {
-      return ONNXIFI_STATUS_NO_DEVICE_MEMORY;
+    // Each context gets its own device buffer, so that concurrent runs do not
+    // overwrite each other's data
+    for (auto &slot : slots_) {
+      HostTransfer &transfer = slot->host_transfers[binding];
+      transfer.device = allocator_->Allocate(footprint);
+      if (!transfer.device) {
+        return ONNXIFI_STATUS_NO_DEVICE_MEMORY;
+      }
+      ret = PrepareHostTransfer(transfer, tensor, footprint);
+      if (ret != ONNXIFI_STATUS_SUCCESS) {
+        return ret;
+      }
+      slot->bindings[binding + slot->binding_offset] = transfer.device;
+      slot->stages_inputs |= !is_output && !transfer.direct;
     }
-    device_buffers_.emplace(tensor.name, cuda_buffer);
-    bindings_.push_back(cuda_buffer);
+    (is_output ? output_copies_ : input_copies_).push_back(binding);
   } else {
-    bindings_.push_back((void *)(tensor.buffer));
+    for (auto &slot : slots_) {
+      slot->bindings[binding + slot->binding_offset] =
+          (void *)(tensor.buffer);
+    }
   }
 
   return ONNXIFI_STATUS_SUCCESS;
@@ -382,8 +1548,12 @@ onnxStatus GraphRep::InitIO(uint32_t inputsCount,
                             uint32_t outputsCount,
                             const onnxTensorDescriptorV1 *outputDescriptors) {
   CudaDeviceGuard guard(device_id_);
+  // Until the new plan is complete, Run must not use it
+  io_ready_ = false;
   ClearDeviceBuffers();
-  // Setup the input/output bindings and decide batch size
+  TensorMap input_map;
+  TensorMap output_map;
+  // Setup the input/output bindings
   for (unsigned i = 0; i < inputsCount; ++i) {
     if (inputDescriptors[i].tag != ONNXIFI_TAG_TENSOR_DESCRIPTOR_V1) {
       return ONNXIFI_STATUS_UNSUPPORTED_TAG;
@@ -391,27 +1561,13 @@ onnxStatus GraphRep::InitIO(uint32_t inputsCount,
     if (!inputDescriptors[i].name) {
       return ONNXIFI_STATUS_INVALID_NAME;
     }
-    // We only support NCHW
-    if (inputDescriptors[i].dimensions != 4) {
+    if (inputDescriptors[i].dimensions > nvinfer1::Dims::MAX_DIMS) {
       return ONNXIFI_STATUS_INVALID_SHAPE;
     }
-    if (i == 0) {
-      batch_size_ = inputDescriptors[i].shape[0];
-    } else {
-      if (batch_size_ != inputDescriptors[i].shape[0]) {
-        return ONNXIFI_STATUS_INVALID_SHAPE;
-      }
-    }
     std::cerr << "Adding input " << i << ": " << inputDescriptors[i].name
               << ", type: " << inputDescriptors[i].memoryType << std::endl;
-    input_map_.emplace(std::string(inputDescriptors[i].name),
-                       inputDescriptors + i);
-  }
-
-  // We don't support the case when batch size is larger than max batch size
-  // yet, but this is not a hard constraint.
-  if (batch_size_ > max_batch_size_) {
-    return ONNXIFI_STATUS_NO_DEVICE_RESOURCES;
+    input_map.emplace(std::string(inputDescriptors[i].name),
+                      inputDescriptors + i);
   }
 
   for (unsigned i = 0; i < outputsCount; ++i) {
@@ -421,81 +1577,277 @@ onnxStatus GraphRep::InitIO(uint32_t inputsCount,
     if (!outputDescriptors[i].name) {
       return ONNXIFI_STATUS_INVALID_NAME;
     }
-    output_map_.emplace(std::string(outputDescriptors[i].name),
-                        outputDescriptors + i);
+    output_map.emplace(std::string(outputDescriptors[i].name),
+                       outputDescriptors + i);
+  }
+  if (batched_) {
+    return InitBatchedIO(input_map, output_map);
   }
 
   int nbindings = trt_engine_->getNbBindings();
-  for (int b = 0; b < nbindings; ++b) {
-    nvinfer1::Dims dims = trt_engine_->getBindingDimensions(b);
-    // Check data type consistency
-    auto binding_datatype = trt_engine_->getBindingDataType(b);
-    if (binding_datatype != nvinfer1::DataType::kFLOAT) {
-      return ONNXIFI_STATUS_MISMATCHING_DATATYPE;
-    }
-
-    if (trt_engine_->bindingIsInput(b)) {
-      std::cerr << "Input: " << trt_engine_->getBindingName(b)
-                << ", Dim: " << dims.d[0] << ", " << dims.d[1] << ", "
-                << dims.d[2] << std::endl;
-      const auto it = input_map_.find(trt_engine_->getBindingName(b));
-      if (it == input_map_.end()) {
+  for (auto &slot : slots_) {
+    slot->bindings.assign(nbindings, nullptr);
+  }
+  // Output shapes follow from the input shapes, so inputs go first
+  for (bool is_output : {false, true}) {
+    for (int b = 0; b < bindings_per_profile_; ++b) {
+      if (trt_engine_->bindingIsInput(b) == is_output) {
+        continue;
+      }
+      const auto &tensor_map = is_output ? output_map : input_map;
+      const auto it = tensor_map.find(trt_engine_->getBindingName(b));
+      if (it == tensor_map.end()) {
         return ONNXIFI_STATUS_UNIDENTIFIED_NAME;
       }
-      if (auto ret = CheckAndBindTensor(dims, *it->second, false) !=
-                     ONNXIFI_STATUS_SUCCESS) {
+      const onnxTensorDescriptorV1 &tensor = *it->second;
+      // Check data type consistency
+      if (!MatchesDataType(trt_engine_->getBindingDataType(b),
+                           tensor.dataType)) {
+        return ONNXIFI_STATUS_MISMATCHING_DATATYPE;
+      }
+
+      nvinfer1::Dims dims = trt_engine_->getBindingDimensions(b);
+      if (!is_output) {
+        auto ret = CheckShape(dims, tensor, false);
+        if (ret != ONNXIFI_STATUS_SUCCESS) {
+          return ret;
+        }
+        dims.nbDims = tensor.dimensions;
+        for (uint32_t i = 0; i < tensor.dimensions; ++i) {
+          dims.d[i] = static_cast<int>(tensor.shape[i]);
+        }
+        // Fails if the shape is outside of the optimization profile
+        for (auto &slot : slots_) {
+          if (!slot->context->setBindingDimensions(b + slot->binding_offset,
+                                                   dims)) {
+            return ONNXIFI_STATUS_UNSUPPORTED_SHAPE;
+          }
+        }
+      } else {
+        // All contexts have the same input shapes
+        const auto &slot = slots_.front();
+        if (!slot->context->allInputDimensionsSpecified()) {
+          return ONNXIFI_STATUS_INVALID_SHAPE;
+        }
+        dims = slot->context->getBindingDimensions(b + slot->binding_offset);
+      }
+      // Outputs can be bound to tensors of another shape with the same size,
+      // and are reshaped implicitly in `CheckAndBindTensor`
+      auto ret = CheckAndBindTensor(b, dims, tensor, is_output);
+      if (ret != ONNXIFI_STATUS_SUCCESS) {
         return ret;
       }
-    } else {
-      // output: for output, we enforce 4D dim although it can be in 2D, we do
-      // an implicit reshape in `CheckAndBindTensor`
-      const auto it = output_map_.find(trt_engine_->getBindingName(b));
-      if (it == output_map_.end()) {
+    }
+  }
+
+  io_ready_ = true;
+  return ONNXIFI_STATUS_SUCCESS;
+}
+
+// The tensors of a batched graph stay in CPU memory. The batcher gathers its
+// inputs into a batch and scatters the outputs back.
+onnxStatus GraphRep::InitBatchedIO(const TensorMap &input_map,
+                                   const TensorMap &output_map) {
+  batch_rows_ = 0;
+  batch_inputs_.clear();
+  batch_outputs_.clear();
+  // In binding order, like the rows of the executor
+  for (bool is_output : {false, true}) {
+    for (int b = 0; b < bindings_per_profile_; ++b) {
+      if (trt_engine_->bindingIsInput(b) == is_output) {
+        continue;
+      }
+      const auto &tensor_map = is_output ? output_map : input_map;
+      const auto it = tensor_map.find(trt_engine_->getBindingName(b));
+      if (it == tensor_map.end()) {
         return ONNXIFI_STATUS_UNIDENTIFIED_NAME;
       }
-      if (auto ret = CheckAndBindTensor(dims, *it->second, true) !=
-                     ONNXIFI_STATUS_SUCCESS) {
+      const onnxTensorDescriptorV1 &tensor = *it->second;
+      if (tensor.memoryType != ONNXIFI_MEMORY_TYPE_CPU) {
+        return ONNXIFI_STATUS_INVALID_MEMORY_TYPE;
+      }
+      if (!MatchesDataType(trt_engine_->getBindingDataType(b),
+                           tensor.dataType)) {
+        return ONNXIFI_STATUS_MISMATCHING_DATATYPE;
+      }
+      // Only the batch dimension is dynamic, and all tensors have the same
+      // batch size
+      auto ret = CheckShape(trt_engine_->getBindingDimensions(b), tensor,
+                            false);
+      if (ret != ONNXIFI_STATUS_SUCCESS) {
         return ret;
       }
+      if (batch_rows_ == 0) {
+        batch_rows_ = tensor.shape[0];
+      } else if (tensor.shape[0] != batch_rows_) {
+        return ONNXIFI_STATUS_MISMATCHING_SHAPE;
+      }
+      if (is_output) {
+        batch_outputs_.push_back((void *)(tensor.buffer));
+      } else {
+        batch_inputs_.push_back((const void *)(tensor.buffer));
+      }
     }
   }
+  if (batch_rows_ == 0 || batch_rows_ > batched_->max_batch_size) {
+    return ONNXIFI_STATUS_UNSUPPORTED_SHAPE;
+  }
 
-  trt_executor_ = infer_object(trt_engine_->createExecutionContext());
+  io_ready_ = true;
   return ONNXIFI_STATUS_SUCCESS;
 }
 
-onnxStatus GraphRep::Run() {
+onnxStatus GraphRep::RunBatched(OnnxTensorRTEvent *input_fence,
+                                OnnxTensorRTEvent **output_fence) {
+  // The inputs are gathered on the host, by the batcher's thread
+  if (input_fence) {
+    auto ret = input_fence->Wait();
+    if (ret != ONNXIFI_STATUS_SUCCESS) {
+      return ret;
+    }
+  }
+
+  OnnxTensorRTEvent *event = event_pool_->Acquire(batched_->stream);
+  onnx2trt::BatchRequest request;
+  request.rows = batch_rows_;
+  request.inputs = batch_inputs_;
+  request.outputs = batch_outputs_;
+  const int device_id = device_id_;
+  request.done = [event, device_id](bool ok) {
+    if (!ok) {
+      std::cerr << "Batched run failed" << std::endl;
+    }
+    // Signalled even if the run failed, so that waiting callers do not hang
+    try {
+      CudaDeviceGuard guard(device_id);
+      event->Signal();
+    } catch (const std::exception &e) {
+      std::cerr << "Internal Error: " << e.what() << std::endl;
+    }
+  };
+  if (!batched_->batcher->Submit(std::move(request))) {
+    OnnxTensorRTEventPool::Release(event);
+    return ONNXIFI_STATUS_INTERNAL_ERROR;
+  }
+  *output_fence = event;
+  return ONNXIFI_STATUS_SUCCESS;
+}
+
+onnxStatus GraphRep::Run(OnnxTensorRTEvent *input_fence,
+                         OnnxTensorRTEvent **output_fence) {
+  *output_fence = nullptr;
+  if (!io_ready_) {
+    return ONNXIFI_STATUS_INVALID_STATE;
+  }
   CudaDeviceGuard guard(device_id_);
-  // Copy input if necessary
-  // TODO: cache tensor footprint
-  for (auto kv : device_buffers_) {
-    auto it = input_map_.find(kv.first);
-    if (it != input_map_.end()) {
-      cudaMemcpyAsync(kv.second, (void *)(it->second->buffer),
-                      GetTensorFootprint(*it->second), cudaMemcpyHostToDevice,
-                      stream_);
-    } else if (output_map_.find(kv.first) == output_map_.end()) {
-      return ONNXIFI_STATUS_UNIDENTIFIED_NAME;
+  if (batched_) {
+    return RunBatched(input_fence, output_fence);
+  }
+  ExecutionSlot *slot = AcquireSlot();
+  // The context can run again as soon as this run is enqueued
+  std::shared_ptr<ExecutionSlot> release(
+      slot, [this](ExecutionSlot *s) { ReleaseSlot(s); });
+
+  if (input_fence) {
+    // Inputs copied through staging buffers are read by the host, which must
+    // wait for them to be ready. Otherwise only the stream needs to wait.
+    auto ret = slot->stages_inputs ? input_fence->Wait()
+                                   : input_fence->StreamWait(slot->stream);
+    if (ret != ONNXIFI_STATUS_SUCCESS) {
+      return ret;
     }
   }
 
+  // The staging buffers can be refilled once the previous run's inputs are
+  // copied out of them, while its compute may still be running
+  cudaEventSynchronize(slot->inputs_copied);
+  // The first run after InitIO is not captured: TensorRT sets up a context
+  // for new shapes on its first enqueue, which cannot be captured
+  const bool use_graph = use_cuda_graphs_ && slot->ran && !slot->graph_failed;
+  if (use_graph) {
+    // A graph only copies from the staging buffers, so they are filled first
+    for (int b : input_copies_) {
+      const HostTransfer &transfer = slot->host_transfers[b];
+      if (!transfer.direct) {
+        memcpy(transfer.staging, transfer.host, transfer.size);
+      }
+    }
+  }
+  if (use_graph && (slot->graph || CaptureGraph(slot))) {
+    if (cudaGraphLaunch(slot->graph, slot->stream) != cudaSuccess) {
+      return ONNXIFI_STATUS_INTERNAL_ERROR;
+    }
+  } else {
+    auto ret = Enqueue(slot, use_graph);
+    if (ret != ONNXIFI_STATUS_SUCCESS) {
+      return ret;
+    }
+  }
+  if (use_graph) {
+    // Recorded after the whole run, since a graph cannot record it
+    cudaEventRecord(slot->inputs_copied, slot->stream);
+  }
+  slot->ran = true;
+
+  *output_fence = event_pool_->Acquire(slot->stream);
+  return (*output_fence)->Signal();
+}
+
+onnxStatus GraphRep::Enqueue(ExecutionSlot *slot, bool staged) {
+  // Copy input if necessary
+  for (int b : input_copies_) {
+    CopyToDevice(slot->host_transfers[b], slot->stream, staged);
+  }
+  // Staged runs may be captured, so Run records it after them
+  if (!staged) {
+    cudaEventRecord(slot->inputs_copied, slot->stream);
+  }
+
   // Run TensorRT
-  trt_executor_->enqueue(batch_size_, bindings_.data(), stream_, nullptr);
+  if (!slot->context->enqueueV2(slot->bindings.data(), slot->stream,
+                                nullptr)) {
+    return ONNXIFI_STATUS_INTERNAL_ERROR;
+  }
 
   // Copy output if necessary
-  for (auto kv : device_buffers_) {
-    auto it = output_map_.find(kv.first);
-    if (it != output_map_.end()) {
-      cudaMemcpyAsync((void *)(it->second->buffer), kv.second,
-                      GetTensorFootprint(*it->second), cudaMemcpyDeviceToHost,
-                      stream_);
-    } else if (input_map_.find(kv.first) == input_map_.end()) {
-      return ONNXIFI_STATUS_UNIDENTIFIED_NAME;
+  for (int b : output_copies_) {
+    auto ret = CopyToHost(slot->host_transfers[b], slot->stream);
+    if (ret != ONNXIFI_STATUS_SUCCESS) {
+      return ret;
     }
   }
   return ONNXIFI_STATUS_SUCCESS;
 }
 
+bool GraphRep::CaptureGraph(ExecutionSlot *slot) {
+  // Thread-local, so that runs on the other contexts are not captured, nor
+  // break the capture
+  cudaGraph_t graph = nullptr;
+  bool captured = cudaStreamBeginCapture(slot->stream,
+                                         cudaStreamCaptureModeThreadLocal) ==
+                  cudaSuccess;
+  if (captured) {
+    const bool enqueued = Enqueue(slot, true) == ONNXIFI_STATUS_SUCCESS;
+    // The capture has to be ended even if enqueuing failed
+    captured = cudaStreamEndCapture(slot->stream, &graph) == cudaSuccess &&
+               enqueued &&
+               cudaGraphInstantiate(&slot->graph, graph, nullptr, nullptr,
+                                    0) == cudaSuccess;
+  }
+  if (graph) {
+    cudaGraphDestroy(graph);
+  }
+  if (!captured) {
+    // Clear the error of the failed capture
+    cudaGetLastError();
+    slot->graph = nullptr;
+    slot->graph_failed = true;
+    std::cerr << "Cannot capture a CUDA graph, running without it"
+              << std::endl;
+  }
+  return captured;
+}
+
 template <class F> onnxStatus OnnxifiTryCatch(F &&tryBlock) {
   try {
     return tryBlock();
@@ -836,7 +2188,7 @@ onnxGetBackendCompatibility(onnxBackendID backendID, size_t onnxModelSize,
 
     TRT_Logger trt_logger;
     std::shared_ptr<nvinfer1::IBuilder> trt_builder = infer_object(nvinfer1::createInferBuilder(trt_logger));
-    std::shared_ptr<nvinfer1::INetworkDefinition> trt_network = infer_object(trt_builder->createNetwork());
+    std::shared_ptr<nvinfer1::INetworkDefinition> trt_network = infer_object(trt_builder->createNetworkV2(kExplicitBatch));
     auto parser = infer_object(nvonnxparser::createParser(*trt_network, trt_logger));
     SubGraphCollection_t subgraphcollection;
     if (parser->supportsModel(onnxModel, onnxModelSize, subgraphcollection)) {
@@ -847,14 +2199,8 @@ onnxGetBackendCompatibility(onnxBackendID backendID, size_t onnxModelSize,
   });
 }
 
-// NB: Passing arguments to backend is tricky. And we need more documentation
-// for it I didn't put any arguments here for now.
-// TODO: submit arguments for
-// - setMaxBatchSize (size_t)
-// - setMaxWorkspaceSize (size_t)
-// - setHalf2Mode (bool)
-// - setInt8Mode (bool)
-// - setDebugSync (bool)
+// The properties (see onnx_trt_backend.h) set the defaults of the graphs of
+// the backend
 ONNXIFI_PUBLIC ONNXIFI_CHECK_RESULT onnxStatus ONNXIFI_ABI
 onnxInitBackend(onnxBackendID backendID, const uint64_t *auxPropertiesList,
                 onnxBackend *backend) {
@@ -863,7 +2209,12 @@ onnxInitBackend(onnxBackendID backendID, const uint64_t *auxPropertiesList,
     if (!backend_id) {
       return ONNXIFI_STATUS_INVALID_ID;
     }
-    *backend = (onnxBackend)(new OnnxTensorRTBackendRep(*backend_id));
+    GraphConfig config = GraphConfig::FromEnvironment();
+    auto ret = config.Update(auxPropertiesList);
+    if (ret != ONNXIFI_STATUS_SUCCESS) {
+      return ret;
+    }
+    *backend = (onnxBackend)(new OnnxTensorRTBackendRep(*backend_id, config));
     return ONNXIFI_STATUS_SUCCESS;
   });
   if (ret != ONNXIFI_STATUS_SUCCESS) {
@@ -948,7 +2299,10 @@ onnxReleaseEvent(onnxEvent event) {
     if (!trt_event) {
       return ONNXIFI_STATUS_INVALID_EVENT;
     }
-    delete trt_event;
+    // Output fences go back to the pool they came from
+    if (!OnnxTensorRTEventPool::Release(trt_event)) {
+      delete trt_event;
+    }
     return ONNXIFI_STATUS_SUCCESS;
   });
 }
@@ -975,15 +2329,63 @@ ONNXIFI_PUBLIC ONNXIFI_CHECK_RESULT onnxStatus ONNXIFI_ABI onnxInitGraph(
       }
     }
 
-    // Parse the model
-    auto ret = backendrep->ImportModel(onnxModel, onnxModelSize, weightsCount,
-                                       weightDescriptors);
+    // The graph's properties override the defaults of the backend
+    GraphConfig config = backendrep->config();
+    auto ret = config.Update(auxPropertiesList);
     if (ret != ONNXIFI_STATUS_SUCCESS) {
       return ret;
     }
 
-    // Create the TRT engine
-    *graph = (onnxGraph)(new GraphRep(backendrep));
+    CudaDeviceGuard guard(backendrep->device_id());
+    // Hashing the model and its weights is only worth it to find a shared or
+    // cached engine
+    uint64_t model_key = 0;
+    const bool keyed =
+        (config.dynamic_batching || !config.engine_cache_dir.empty()) &&
+        backendrep->ModelKey(onnxModel, onnxModelSize, weightsCount,
+                             weightDescriptors, config, &model_key);
+    // Graphs of the same model share the engine that batches their runs
+    if (config.dynamic_batching && keyed) {
+      if (auto batched = backendrep->FindBatchedEngine(
+              model_key, config.batching_delay_us)) {
+        *graph = (onnxGraph)(new GraphRep(backendrep, batched));
+        return ONNXIFI_STATUS_SUCCESS;
+      }
+    }
+
+    // Reuse the engine built for this graph before, if it is in the cache
+    const EngineCache engine_cache(config.engine_cache_dir);
+    const bool cacheable = keyed && !config.engine_cache_dir.empty();
+    nvinfer1::ICudaEngine *engine =
+        cacheable
+            ? backendrep->LoadCachedEngine(engine_cache, model_key,
+                                           config.dla_core)
+            : nullptr;
+
+    if (!engine) {
+      // Parse the model and create the TRT engine
+      ret = backendrep->BuildEngine(onnxModel, onnxModelSize, weightsCount,
+                                    weightDescriptors, config, &engine);
+      if (ret != ONNXIFI_STATUS_SUCCESS) {
+        return ret;
+      }
+      if (cacheable) {
+        backendrep->StoreCachedEngine(engine_cache, model_key, *engine);
+      }
+    }
+    if (config.dynamic_batching) {
+      if (EngineBatchExecutor::CanBatch(*engine)) {
+        *graph = (onnxGraph)(new GraphRep(
+            backendrep,
+            backendrep->AddBatchedEngine(model_key, keyed, engine,
+                                         config.batching_delay_us)));
+        return ONNXIFI_STATUS_SUCCESS;
+      }
+      std::cerr << "Runs of a graph with dynamic dimensions other than the "
+                   "batch dimension are not batched"
+                << std::endl;
+    }
+    *graph = (onnxGraph)(new GraphRep(backendrep, engine, config));
     return ONNXIFI_STATUS_SUCCESS;
   });
   if (ret != ONNXIFI_STATUS_SUCCESS) {
@@ -1023,21 +2425,19 @@ onnxRunGraph(onnxGraph graph, const onnxMemoryFenceV1 *inputFence,
         outputFence->tag != ONNXIFI_TAG_MEMORY_FENCE_V1) {
       return ONNXIFI_STATUS_UNSUPPORTED_TAG;
     }
-    auto *trt_event = reinterpret_cast<OnnxTensorRTEvent *>(inputFence->event);
-    auto ret = trt_event->Wait();
-    if (ret != ONNXIFI_STATUS_SUCCESS) {
-      return ret;
-    }
     auto *graph_rep = reinterpret_cast<GraphRep *>(graph);
     if (!graph_rep) {
       return ONNXIFI_STATUS_INVALID_GRAPH;
     }
 
-    ret = graph_rep->Run();
-    auto output_event = new OnnxTensorRTEvent(graph_rep->stream());
+    // The input fence is waited for on the stream of the run, not by blocking
+    // this thread (unless the host has to read the inputs)
+    auto *input_event =
+        reinterpret_cast<OnnxTensorRTEvent *>(inputFence->event);
+    OnnxTensorRTEvent *output_event = nullptr;
+    auto ret = graph_rep->Run(input_event, &output_event);
     outputFence->event = reinterpret_cast<onnxEvent>(output_event);
     outputFence->type = ONNXIFI_SYNCHRONIZATION_EVENT;
-    output_event->Signal();
     return ret;
   });
 }
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ONNX_TRT_BACKEND_H
+#define ONNX_TRT_BACKEND_H
+
+/*
+ * Properties of the TensorRT ONNXIFI backend (libtrt_onnxify).
+ *
+ * They can be passed in the auxPropertiesList of onnxInitBackend, where they
+ * set the defaults of all the graphs of the backend, and of onnxInitGraph,
+ * where they override them for one graph. A property list is a sequence of
+ * (property, value) pairs of uint64_t, terminated by
+ * ONNXIFI_BACKEND_PROPERTY_NONE or ONNXIFI_GRAPH_PROPERTY_NONE. String values
+ * are pointers cast to uint64_t, and are copied by the call.
+ *
+ * Unknown properties are rejected with ONNXIFI_STATUS_INVALID_PROPERTY.
+ */
+
+/*
+ * Maximum size in bytes of the scratch memory that a layer may use.
+ * Default: 2 GiB.
+ */
+#define ONNX_TRT_PROPERTY_MAX_WORKSPACE_SIZE 0x54525410
+
+/*
+ * Nonzero to let TensorRT pick FP16 kernels. Default: 0.
+ */
+#define ONNX_TRT_PROPERTY_FP16 0x54525411
+
+/*
+ * Nonzero to let TensorRT pick INT8 kernels. There is no calibrator, so only
+ * tensors with dynamic ranges in the model can be INT8. Default: 0.
+ */
+#define ONNX_TRT_PROPERTY_INT8 0x54525412
+
+/*
+ * Index of the DLA core to run the graph on, or (uint64_t)-1 for the GPU.
+ * Layers that the DLA does not support fall back to the GPU. The DLA only
+ * runs FP16 and INT8 layers, so this implies ONNX_TRT_PROPERTY_FP16 unless
+ * ONNX_TRT_PROPERTY_INT8 is set. Default: (uint64_t)-1.
+ */
+#define ONNX_TRT_PROPERTY_DLA_CORE 0x54525413
+
+/*
+ * Upper bound of a dynamic leading (batch) dimension of an input that has no
+ * profile shapes. Default: 128.
+ */
+#define ONNX_TRT_PROPERTY_MAX_BATCH_SIZE 0x54525414
+
+/*
+ * Number of execution contexts of a graph, i.e. how many runs of the graph
+ * can be in flight concurrently. Default: the ONNX_TRT_EXECUTION_CONTEXTS
+ * environment variable, or 1.
+ */
+#define ONNX_TRT_PROPERTY_EXECUTION_CONTEXTS 0x54525415
+
+/*
+ * Directory of the on-disk engine cache (a string), or null or empty to
+ * disable it. Default: the ONNX_TRT_ENGINE_CACHE_DIR environment variable.
+ */
+#define ONNX_TRT_PROPERTY_ENGINE_CACHE_DIR 0x54525416
+
+/*
+ * Nonzero to coalesce the runs of the graphs of the same model on a backend
+ * into batches. Such graphs share one engine, and their runs are queued and
+ * concatenated along the batch dimension, up to the maximum batch size of the
+ * optimization profile or until ONNX_TRT_PROPERTY_BATCHING_DELAY_US passes.
+ * It needs a model whose inputs and outputs only have a dynamic batch
+ * dimension, and CPU-resident inputs and outputs. Default: 0.
+ */
+#define ONNX_TRT_PROPERTY_DYNAMIC_BATCHING 0x54525417
+
+/*
+ * How long in microseconds a run may wait for other runs to batch with.
+ * Default: 1000.
+ */
+#define ONNX_TRT_PROPERTY_BATCHING_DELAY_US 0x54525418
+
+/*
+ * Nonzero to replay runs as CUDA graphs. The second run after each
+ * onnxSetGraphIO call on an execution context is captured into a graph: the
+ * copies of its CPU-resident inputs and outputs and the TensorRT kernels. The
+ * following runs launch that graph, which saves the CPU cost of enqueuing
+ * them one by one. Graphs that cannot be captured run as usual. Not used with
+ * ONNX_TRT_PROPERTY_DYNAMIC_BATCHING. Default: 0.
+ */
+#define ONNX_TRT_PROPERTY_CUDA_GRAPHS 0x54525419
+
+/*
+ * Ranges of the dynamic input dimensions, i.e. the optimization profile of a
+ * graph: the minimum, optimal and maximum shapes of its inputs. Values are
+ * strings of comma-separated "input:d0xd1x..." shapes, e.g.
+ * "data:1x3x224x224". Inputs with dynamic dimensions other than the leading
+ * one need all three.
+ */
+#define ONNX_TRT_PROPERTY_MIN_SHAPES 0x54525401
+#define ONNX_TRT_PROPERTY_OPT_SHAPES 0x54525402
+#define ONNX_TRT_PROPERTY_MAX_SHAPES 0x54525403
+
+#endif /* ONNX_TRT_BACKEND_H */
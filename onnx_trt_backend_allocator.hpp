@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace onnx2trt {
+
+// Source of the memory recycled by a CachingAllocator, e.g. cudaMalloc.
+class RawAllocator {
+public:
+  virtual ~RawAllocator() {}
+  // Returns nullptr if the memory cannot be allocated.
+  virtual void *Allocate(size_t size) = 0;
+  virtual void Free(void *ptr) = 0;
+};
+
+// Host memory stand-in for device memory, so that the pooling logic can be
+// exercised without a GPU.
+class HostRawAllocator : public RawAllocator {
+public:
+  void *Allocate(size_t size) override { return std::malloc(size); }
+  void Free(void *ptr) override { std::free(ptr); }
+};
+
+struct AllocatorStats {
+  size_t allocated_bytes{0};      // Size of the buffers in use
+  size_t reserved_bytes{0};       // Size of the buffers in use or cached
+  size_t peak_allocated_bytes{0}; // High-water mark of allocated_bytes
+  size_t peak_reserved_bytes{0};  // High-water mark of reserved_bytes
+  size_t num_allocations{0};      // Calls to Allocate
+  size_t num_cache_hits{0};       // Allocations served from the cache
+  size_t num_raw_allocations{0};  // Allocations from the RawAllocator
+  size_t num_raw_frees{0};        // Buffers returned to the RawAllocator
+};
+
+// Caching allocator that rounds sizes up to size classes and keeps freed
+// buffers on a free list per class, so that rebinding I/O reuses buffers
+// instead of paying for cudaMalloc and cudaFree (which synchronizes the
+// device). Cached buffers are only returned to the RawAllocator when an
+// allocation fails, by ReleaseCached, or on destruction. Thread-safe.
+class CachingAllocator {
+public:
+  explicit CachingAllocator(std::unique_ptr<RawAllocator> raw)
+      : raw_(std::move(raw)) {}
+
+  ~CachingAllocator() {
+    ReleaseCached();
+    for (const auto &kv : in_use_) {
+      raw_->Free(kv.first);
+    }
+  }
+
+  CachingAllocator(const CachingAllocator &) = delete;
+  CachingAllocator &operator=(const CachingAllocator &) = delete;
+
+  // Smallest size class. Larger sizes have four classes per power of two, so
+  // at most a quarter of a buffer is wasted.
+  static constexpr size_t kMinSizeClass = 256;
+
+  static size_t SizeClass(size_t size) {
+    if (size <= kMinSizeClass) {
+      return kMinSizeClass;
+    }
+    size_t power = kMinSizeClass;
+    while (power * 2 < size) {
+      power *= 2;
+    }
+    const size_t step = power / 4;
+    return (size + step - 1) / step * step;
+  }
+
+  // Returns a buffer of at least size bytes, or nullptr if the memory cannot
+  // be allocated even after releasing the cached buffers.
+  void *Allocate(size_t size) {
+    const size_t size_class = SizeClass(size);
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.num_allocations;
+    void *ptr = nullptr;
+    auto it = free_lists_.find(size_class);
+    if (it != free_lists_.end() && !it->second.empty()) {
+      ptr = it->second.back();
+      it->second.pop_back();
+      ++stats_.num_cache_hits;
+    } else {
+      ptr = raw_->Allocate(size_class);
+      if (!ptr) {
+        // Retry after giving the memory of all cached buffers back
+        ReleaseCachedLocked();
+        ptr = raw_->Allocate(size_class);
+        if (!ptr) {
+          return nullptr;
+        }
+      }
+      ++stats_.num_raw_allocations;
+      stats_.reserved_bytes += size_class;
+      stats_.peak_reserved_bytes =
+          std::max(stats_.peak_reserved_bytes, stats_.reserved_bytes);
+    }
+    in_use_.emplace(ptr, size_class);
+    stats_.allocated_bytes += size_class;
+    stats_.peak_allocated_bytes =
+        std::max(stats_.peak_allocated_bytes, stats_.allocated_bytes);
+    return ptr;
+  }
+
+  // Returns a buffer from Allocate to the cache.
+  void Free(void *ptr) {
+    if (!ptr) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = in_use_.find(ptr);
+    if (it == in_use_.end()) {
+      return;
+    }
+    free_lists_[it->second].push_back(ptr);
+    stats_.allocated_bytes -= it->second;
+    in_use_.erase(it);
+  }
+
+  // Returns all cached buffers to the RawAllocator.
+  void ReleaseCached() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ReleaseCachedLocked();
+  }
+
+  AllocatorStats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+private:
+  void ReleaseCachedLocked() {
+    for (auto &kv : free_lists_) {
+      for (void *ptr : kv.second) {
+        raw_->Free(ptr);
+        ++stats_.num_raw_frees;
+        stats_.reserved_bytes -= kv.first;
+      }
+    }
+    free_lists_.clear();
+  }
+
+  std::unique_ptr<RawAllocator> raw_;
+  mutable std::mutex mutex_;
+  std::map<size_t, std::vector<void *>> free_lists_;
+  std::unordered_map<void *, size_t> in_use_;
+  AllocatorStats stats_;
+};
+
+} // namespace onnx2trt
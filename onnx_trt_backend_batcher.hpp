@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace onnx2trt {
+
+// Runs the batches of a DynamicBatcher, e.g. on a TensorRT execution context.
+// All calls come from the batcher's thread: BeginBatch, Launch, and then
+// CopyOutputs for each request of the batch. Inputs and outputs are
+// batch-major, i.e. row r of a tensor starts r row sizes into its buffer.
+class BatchExecutor {
+public:
+  virtual ~BatchExecutor() {}
+  virtual size_t max_batch_size() const = 0;
+  // Size in bytes of a row of each input and output
+  virtual const std::vector<size_t> &input_row_sizes() const = 0;
+  virtual const std::vector<size_t> &output_row_sizes() const = 0;
+  // Returns the buffers, one per input with room for max_batch_size() rows,
+  // to gather the inputs of the next batch into, or an empty vector if the
+  // batch cannot run.
+  virtual std::vector<void *> BeginBatch() = 0;
+  // Runs the model on the first batch_size rows of the input buffers
+  virtual bool Launch(size_t batch_size) = 0;
+  // Copies rows [row, row + rows) of each output of the last batch to
+  // outputs. An asynchronous executor may only enqueue the copies, as long as
+  // the work that the request's done callback enqueues next runs after them.
+  virtual bool CopyOutputs(size_t row, size_t rows,
+                           const std::vector<void *> &outputs) = 0;
+};
+
+struct BatchRequest {
+  size_t rows{0};
+  // One buffer of rows rows per input and output of the executor
+  std::vector<const void *> inputs;
+  std::vector<void *> outputs;
+  // Called from the batcher's thread once the outputs of the request are
+  // copied, with false if its batch failed
+  std::function<void(bool)> done;
+};
+
+struct BatcherStats {
+  size_t num_requests{0};
+  size_t num_batches{0};
+  size_t num_rows{0}; // Rows of all batches
+};
+
+// Coalesces the requests that are submitted concurrently into batches, and
+// runs them on an executor. A batch is launched once its requests fill the
+// executor's max batch size, or max_delay after the oldest of them was
+// submitted. Requests are batched whole and in order, and each one is
+// completed as soon as its outputs are copied, before the rest of the batch
+// is scattered. Thread-safe.
+class DynamicBatcher {
+public:
+  DynamicBatcher(std::unique_ptr<BatchExecutor> executor,
+                 std::chrono::microseconds max_delay)
+      : executor_(std::move(executor)), max_delay_(max_delay) {
+    thread_ = std::thread([this] { Loop(); });
+  }
+
+  // Runs the requests that are still queued before returning
+  ~DynamicBatcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+    }
+    queued_.notify_all();
+    thread_.join();
+  }
+
+  DynamicBatcher(const DynamicBatcher &) = delete;
+  DynamicBatcher &operator=(const DynamicBatcher &) = delete;
+
+  // Queues a request. Returns false, without calling its done callback, if
+  // the request does not fit in a batch or does not match the executor's
+  // inputs and outputs.
+  bool Submit(BatchRequest request) {
+    if (request.rows == 0 || request.rows > executor_->max_batch_size() ||
+        request.inputs.size() != executor_->input_row_sizes().size() ||
+        request.outputs.size() != executor_->output_row_sizes().size()) {
+      return false;
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      queued_rows_ += request.rows;
+      queue_.push_back({std::move(request), Clock::now()});
+    }
+    queued_.notify_one();
+    return true;
+  }
+
+  BatcherStats stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+  }
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct QueuedRequest {
+    BatchRequest request;
+    Clock::time_point submitted;
+  };
+
+  void Loop() {
+    const size_t max_batch_size = executor_->max_batch_size();
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      queued_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+      if (queue_.empty()) {
+        return;
+      }
+      // Wait for more requests until the batch is full or the oldest request
+      // has waited long enough
+      const Clock::time_point deadline = queue_.front().submitted + max_delay_;
+      queued_.wait_until(lock, deadline, [&] {
+        return stopping_ || queued_rows_ >= max_batch_size;
+      });
+      std::vector<BatchRequest> batch;
+      size_t rows = 0;
+      while (!queue_.empty() &&
+             rows + queue_.front().request.rows <= max_batch_size) {
+        rows += queue_.front().request.rows;
+        batch.push_back(std::move(queue_.front().request));
+        queue_.pop_front();
+      }
+      queued_rows_ -= rows;
+      stats_.num_requests += batch.size();
+      ++stats_.num_batches;
+      stats_.num_rows += rows;
+      lock.unlock();
+      RunBatch(batch, rows);
+      lock.lock();
+    }
+  }
+
+  void RunBatch(std::vector<BatchRequest> &batch, size_t rows) {
+    const auto &input_row_sizes = executor_->input_row_sizes();
+    std::vector<void *> buffers = executor_->BeginBatch();
+    bool ok = buffers.size() == input_row_sizes.size();
+    if (ok) {
+      size_t row = 0;
+      for (const auto &request : batch) {
+        for (size_t i = 0; i < buffers.size(); ++i) {
+          std::memcpy(static_cast<char *>(buffers[i]) +
+                          row * input_row_sizes[i],
+                      request.inputs[i], request.rows * input_row_sizes[i]);
+        }
+        row += request.rows;
+      }
+      ok = executor_->Launch(rows);
+    }
+    size_t row = 0;
+    for (auto &request : batch) {
+      request.done(ok &&
+                   executor_->CopyOutputs(row, request.rows, request.outputs));
+      row += request.rows;
+    }
+  }
+
+  std::unique_ptr<BatchExecutor> executor_;
+  std::chrono::microseconds max_delay_;
+  mutable std::mutex mutex_;
+  std::condition_variable queued_;
+  std::deque<QueuedRequest> queue_;
+  size_t queued_rows_{0};
+  bool stopping_{false};
+  BatcherStats stats_;
+  std::thread thread_;
+};
+
+} // namespace onnx2trt
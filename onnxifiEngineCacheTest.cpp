@@ -0,0 +1,243 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "apiTestHelpers.hpp"
+#include "onnx/onnxifi.h"
+#include "onnx_trt_backend.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+namespace {
+
+constexpr int kCHANNELS = 3;
+constexpr int kHEIGHT = 8;
+constexpr int kWIDTH = 8;
+constexpr float kEPSILON = 1e-5f;
+const std::vector<float> kSCALE{1.f, 0.5f, -2.f};
+const std::vector<float> kBIAS{0.f, 1.f, -0.25f};
+
+void print_usage() {
+  cout << "This program checks that an engine which uses a plugin survives the ONNXIFI engine cache. A first process "
+       << "builds a static-shape InstanceNormalization model (InstanceNormalization_TRT plugin) and stores its "
+       << "engine, and a second process, which has not registered any plugins yet, must load it from the cache "
+       << "instead of rebuilding it. Both runs are compared against a reference." << endl;
+  cout << "Usage: onnxifiEngineCacheTest [-t tolerance (default 1e-3)]" << endl;
+}
+
+// A static (1, C, H, W) input imports InstanceNormalization through the plugin.
+std::string makeModel() {
+  ::ONNX_NAMESPACE::ModelProto model = apitest::makeModel("instance_norm");
+  ::ONNX_NAMESPACE::GraphProto* graph = model.mutable_graph();
+  const std::vector<int64_t> dims{1, kCHANNELS, kHEIGHT, kWIDTH};
+  apitest::addInput(graph, "x", dims);
+  apitest::addOutput(graph, "y", &dims);
+  apitest::addInitializer(graph, "scale", kSCALE);
+  apitest::addInitializer(graph, "bias", kBIAS);
+  ::ONNX_NAMESPACE::NodeProto* node = apitest::addNode(graph, "InstanceNormalization", {"x", "scale", "bias"}, {"y"});
+  apitest::addFloatAttribute(node, "epsilon", kEPSILON);
+  std::string serialized;
+  model.SerializeToString(&serialized);
+  return serialized;
+}
+
+// Each plane alternates between a and -a, so it normalizes to +-a / sqrt(a^2 + epsilon) before scale and bias.
+void makeInput(std::vector<float>& x, std::vector<float>& expected) {
+  const size_t planeSize = kHEIGHT * kWIDTH;
+  x.resize(kCHANNELS * planeSize);
+  expected.resize(x.size());
+  for (int c = 0; c < kCHANNELS; ++c) {
+    const float a = c + 1.f;
+    const float normalized = a / std::sqrt(a * a + kEPSILON);
+    for (size_t i = 0; i < planeSize; ++i) {
+      const float sign = i % 2 ? -1.f : 1.f;
+      x[c * planeSize + i] = sign * a;
+      expected[c * planeSize + i] = sign * normalized * kSCALE[c] + kBIAS[c];
+    }
+  }
+}
+
+// Initializes a graph of the model on the first backend, with the engine cache in cacheDir, runs it once and
+// compares the output with the reference. Returns true if it matches.
+bool runModel(std::string const& model, std::string const& cacheDir, float tolerance) {
+  size_t numBackends = 0;
+  onnxGetBackendIDs(nullptr, &numBackends);
+  if (numBackends == 0) {
+    cerr << "  No ONNXIFI backend" << endl;
+    return false;
+  }
+  std::vector<onnxBackendID> backendIDs(numBackends);
+  if (onnxGetBackendIDs(backendIDs.data(), &numBackends) != ONNXIFI_STATUS_SUCCESS) {
+    cerr << "  Cannot get the ONNXIFI backends" << endl;
+    return false;
+  }
+
+  const uint64_t properties[] = {ONNX_TRT_PROPERTY_ENGINE_CACHE_DIR, reinterpret_cast<uint64_t>(cacheDir.c_str()),
+                                 ONNXIFI_BACKEND_PROPERTY_NONE};
+  onnxBackend backend = nullptr;
+  onnxGraph graph = nullptr;
+  std::vector<float> x;
+  std::vector<float> expected;
+  makeInput(x, expected);
+  std::vector<float> y(x.size());
+  const uint64_t shape[] = {1, kCHANNELS, kHEIGHT, kWIDTH};
+  const onnxTensorDescriptorV1 input{ONNXIFI_TAG_TENSOR_DESCRIPTOR_V1, "x", ONNXIFI_DATATYPE_FLOAT32,
+                                     ONNXIFI_MEMORY_TYPE_CPU, 4, shape, reinterpret_cast<onnxPointer>(x.data())};
+  const onnxTensorDescriptorV1 output{ONNXIFI_TAG_TENSOR_DESCRIPTOR_V1, "y", ONNXIFI_DATATYPE_FLOAT32,
+                                      ONNXIFI_MEMORY_TYPE_CPU, 4, shape, reinterpret_cast<onnxPointer>(y.data())};
+  onnxMemoryFenceV1 inputFence{};
+  inputFence.tag = ONNXIFI_TAG_MEMORY_FENCE_V1;
+  inputFence.type = ONNXIFI_SYNCHRONIZATION_EVENT;
+  onnxMemoryFenceV1 outputFence{};
+  outputFence.tag = ONNXIFI_TAG_MEMORY_FENCE_V1;
+
+  bool ok = onnxInitBackend(backendIDs[0], properties, &backend) == ONNXIFI_STATUS_SUCCESS
+      && onnxInitGraph(backend, nullptr, model.size(), model.data(), 0, nullptr, &graph) == ONNXIFI_STATUS_SUCCESS
+      && onnxSetGraphIO(graph, 1, &input, 1, &output) == ONNXIFI_STATUS_SUCCESS
+      && onnxInitEvent(backend, &inputFence.event) == ONNXIFI_STATUS_SUCCESS
+      && onnxSignalEvent(inputFence.event) == ONNXIFI_STATUS_SUCCESS
+      && onnxRunGraph(graph, &inputFence, &outputFence) == ONNXIFI_STATUS_SUCCESS
+      && onnxWaitEvent(outputFence.event) == ONNXIFI_STATUS_SUCCESS;
+  for (onnxEvent event : {inputFence.event, outputFence.event}) {
+    if (event) {
+      onnxReleaseEvent(event);
+    }
+  }
+  if (graph) {
+    onnxReleaseGraph(graph);
+  }
+  if (backend) {
+    onnxReleaseBackend(backend);
+  }
+  for (onnxBackendID id : backendIDs) {
+    onnxReleaseBackendID(id);
+  }
+
+  const float maxError = ok ? apitest::maxAbsError(y, expected) : 0.f;
+  const bool passed = ok && maxError <= tolerance;
+  cout << "  " << (ok ? "" : "ONNXIFI call failed, ") << "max abs error " << maxError
+       << (passed ? " PASSED" : " FAILED") << endl;
+  return passed;
+}
+
+// Runs the model in a child process, so that each run starts with an empty plugin registry.
+bool runModelInChild(std::string const& model, std::string const& cacheDir, float tolerance) {
+  // Output buffered before the fork would be written by both processes
+  cout.flush();
+  const pid_t pid = fork();
+  if (pid == 0) {
+    const bool passed = runModel(model, cacheDir, tolerance);
+    cout.flush();
+    _exit(passed ? 0 : 1);
+  }
+  int status = 0;
+  return pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Returns the paths of the cached engines in dir.
+std::vector<std::string> listEngines(std::string const& dir) {
+  std::vector<std::string> engines;
+  if (DIR* handle = opendir(dir.c_str())) {
+    while (const dirent* entry = readdir(handle)) {
+      const std::string name = entry->d_name;
+      if (name.size() > 7 && name.compare(name.size() - 7, 7, ".engine") == 0) {
+        engines.push_back(dir + "/" + name);
+      }
+    }
+    closedir(handle);
+  }
+  return engines;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    apitest::Options options;
+    if (!apitest::parseOptions(argc, argv, options, print_usage))
+    {
+        return 0;
+    }
+
+    char rootTemplate[] = "/tmp/onnxifiEngineCacheTest.XXXXXX";
+    if (!mkdtemp(rootTemplate))
+    {
+        cerr << "Cannot create a temporary directory" << endl;
+        return 1;
+    }
+    const std::string root = rootTemplate;
+    const std::string cacheDir = root + "/cache";
+    const std::string pinPath = root + "/pin";
+    mkdir(cacheDir.c_str(), 0700);
+    const std::string model = makeModel();
+
+    int failures = 0;
+    cout << "Building and storing the engine:" << endl;
+    failures += runModelInChild(model, cacheDir, options.tolerance) ? 0 : 1;
+    const std::vector<std::string> stored = listEngines(cacheDir);
+    struct stat storedStat{};
+    // The hard link keeps the inode of the stored engine allocated, so that a rebuilt engine, which is written to a
+    // new file and renamed over it, cannot get the same inode.
+    const bool pinned = stored.size() == 1 && link(stored[0].c_str(), pinPath.c_str()) == 0
+        && stat(pinPath.c_str(), &storedStat) == 0;
+    if (!pinned)
+    {
+        cout << "  Expected one cached engine, found " << stored.size() << " FAILED" << endl;
+        ++failures;
+    }
+
+    cout << "Loading the engine in a new process:" << endl;
+    failures += runModelInChild(model, cacheDir, options.tolerance) ? 0 : 1;
+    if (pinned)
+    {
+        const std::vector<std::string> loaded = listEngines(cacheDir);
+        struct stat loadedStat{};
+        const bool hit = loaded.size() == 1 && stat(loaded[0].c_str(), &loadedStat) == 0
+            && loadedStat.st_ino == storedStat.st_ino;
+        cout << "  " << (hit ? "Cache hit PASSED" : "Engine was rebuilt instead of loaded FAILED") << endl;
+        failures += hit ? 0 : 1;
+    }
+
+    for (std::string const& path : listEngines(cacheDir))
+    {
+        std::remove(path.c_str());
+    }
+    std::remove(pinPath.c_str());
+    rmdir(cacheDir.c_str());
+    rmdir(root.c_str());
+
+    cout << (failures ? "FAILED" : "PASSED") << endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h> // For ::getopt
+#include <vector>
+#include "NvOnnxParser.h"
+#include "apiTestHelpers.hpp"
+#include "common.hpp"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+void print_usage() {
+  cout << "This program parses ONNX models concurrently from several threads, each thread using its own "
+       << "parser and network. Without -m, it parses models that it generates, which import through plugins, "
+       << "shape tensors and subgraphs. Configure with -DONNX2TRT_ENABLE_TSAN=ON to check the parser for data "
+       << "races." << endl;
+  cout << "Usage: parallelParseAPITest [-m onnx_model.pb [-m other_model.pb ...]]" << endl;
+  cout << "Optional arguments: -t num_threads (default 8) -i iterations_per_thread (default 4)" << endl;
+}
+
+std::vector<char> serialize(::ONNX_NAMESPACE::ModelProto const& model) {
+  std::string serialized;
+  model.SerializeToString(&serialized);
+  return std::vector<char>(serialized.begin(), serialized.end());
+}
+
+// InstanceNormalization on a static input, which creates a plugin layer.
+::ONNX_NAMESPACE::ModelProto makeInstanceNormModel() {
+  ::ONNX_NAMESPACE::ModelProto model = apitest::makeModel("instance_norm");
+  ::ONNX_NAMESPACE::GraphProto* graph = model.mutable_graph();
+  const std::vector<int64_t> dims{1, 2, 4, 4};
+  apitest::addInput(graph, "x", dims);
+  apitest::addOutput(graph, "y", &dims);
+  apitest::addInitializer(graph, "scale", std::vector<float>{1.f, 2.f});
+  apitest::addInitializer(graph, "bias", std::vector<float>{0.f, -1.f});
+  apitest::addNode(graph, "InstanceNormalization", {"x", "scale", "bias"}, {"y"});
+  return model;
+}
+
+// Linear Resize with dynamic height and width, whose output size is computed with shape tensors.
+::ONNX_NAMESPACE::ModelProto makeResizeModel() {
+  ::ONNX_NAMESPACE::ModelProto model = apitest::makeModel("resize");
+  ::ONNX_NAMESPACE::GraphProto* graph = model.mutable_graph();
+  apitest::addInput(graph, "x", {1, 1, -1, -1});
+  apitest::addOutput(graph, "y");
+  apitest::addInitializer(graph, "roi", std::vector<float>{});
+  apitest::addInitializer(graph, "scales", std::vector<float>{1.f, 1.f, 2.f, 0.5f});
+  ::ONNX_NAMESPACE::NodeProto* node = apitest::addNode(graph, "Resize", {"x", "roi", "scales"}, {"y"});
+  apitest::addStringAttribute(node, "mode", "linear");
+  return model;
+}
+
+// A Loop whose body is imported as a subgraph, with a scan output.
+::ONNX_NAMESPACE::ModelProto makeLoopModel() {
+  ::ONNX_NAMESPACE::ModelProto model = apitest::makeModel("loop");
+  ::ONNX_NAMESPACE::GraphProto* graph = model.mutable_graph();
+  apitest::addInput(graph, "x", {2});
+  apitest::addOutput(graph, "x_final");
+  apitest::addOutput(graph, "scan");
+  apitest::addInitializer(graph, "one", std::vector<float>{1.f});
+  apitest::addScalarInitializer(graph, "trip", ::ONNX_NAMESPACE::TensorProto::INT64)->add_int64_data(3);
+  apitest::addScalarInitializer(graph, "cond", ::ONNX_NAMESPACE::TensorProto::BOOL)->add_int32_data(1);
+
+  ::ONNX_NAMESPACE::GraphProto body;
+  body.set_name("loop_body");
+  const std::vector<int64_t> scalar{};
+  const std::vector<int64_t> state{2};
+  apitest::addInput(&body, "i", scalar, ::ONNX_NAMESPACE::TensorProto::INT64);
+  apitest::addInput(&body, "cond_in", scalar, ::ONNX_NAMESPACE::TensorProto::BOOL);
+  apitest::addInput(&body, "x_state", state);
+  apitest::addOutput(&body, "cond_out", nullptr, ::ONNX_NAMESPACE::TensorProto::BOOL);
+  apitest::addOutput(&body, "x_out", &state);
+  apitest::addOutput(&body, "scan_out", &state);
+  apitest::addNode(&body, "Identity", {"cond_in"}, {"cond_out"});
+  apitest::addNode(&body, "Add", {"x_state", "one"}, {"x_out"});
+  apitest::addNode(&body, "Identity", {"x_state"}, {"scan_out"});
+
+  ::ONNX_NAMESPACE::NodeProto* loop = apitest::addNode(graph, "Loop", {"trip", "cond", "x"}, {"x_final", "scan"});
+  apitest::addGraphAttribute(loop, "body", body);
+  return model;
+}
+
+// The parsers share one logger, so it must be safe to call from several threads.
+class SynchronizedLogger : public nvinfer1::ILogger {
+  std::mutex _mutex;
+  common::TRT_Logger _logger;
+public:
+  explicit SynchronizedLogger(Severity verbosity) : _logger(verbosity) {}
+  void log(Severity severity, const char* msg) override {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _logger.log(severity, msg);
+  }
+};
+
+bool readFile(const std::string& filename, std::vector<char>& buf) {
+  std::ifstream file(filename.c_str(), std::ios::binary | std::ios::ate);
+  std::streamsize file_size = file.tellg();
+  if (file_size < 0) {
+    return false;
+  }
+  file.seekg(0, std::ios::beg);
+  buf.resize(file_size);
+  return static_cast<bool>(file.read(buf.data(), buf.size()));
+}
+
+int main(int argc, char* argv[]) {
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    std::vector<std::string> onnx_filenames;
+    int num_threads = 8;
+    int num_iterations = 4;
+    int c;
+    while ((c = getopt (argc, argv, "m:t:i:h")) != -1)
+    {
+        switch(c)
+        {
+            case 'm':
+                    onnx_filenames.push_back(optarg);
+                    break;
+            case 't':
+                    num_threads = atoi(optarg);
+                    break;
+            case 'i':
+                    num_iterations = atoi(optarg);
+                    break;
+            case 'h':
+                    print_usage();
+                    return 0;
+        }
+    }
+
+    if (num_threads < 1 || num_iterations < 1)
+    {
+        print_usage();
+        return -1;
+    }
+
+    std::vector<std::vector<char>> onnx_bufs(onnx_filenames.size());
+    for (size_t i = 0; i < onnx_filenames.size(); ++i)
+    {
+        if (!readFile(onnx_filenames[i], onnx_bufs[i]))
+        {
+            cerr << "ERROR: Failed to read from file " << onnx_filenames[i] << endl;
+            return -1;
+        }
+    }
+    if (onnx_bufs.empty())
+    {
+        onnx_bufs = {serialize(makeInstanceNormModel()), serialize(makeResizeModel()), serialize(makeLoopModel())};
+    }
+
+    SynchronizedLogger trt_logger(nvinfer1::ILogger::Severity::kWARNING);
+    auto trt_builder = common::infer_object(nvinfer1::createInferBuilder(trt_logger));
+    std::mutex builder_mutex;
+    std::atomic<int> failures(0);
+
+    auto worker = [&](int thread_idx) {
+        const auto explicitBatch = 1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+        std::shared_ptr<nvinfer1::INetworkDefinition> trt_network;
+        {
+            // The builder itself is not reentrant; only network creation goes through it.
+            std::lock_guard<std::mutex> lock(builder_mutex);
+            trt_network = common::infer_object(trt_builder->createNetworkV2(explicitBatch));
+        }
+        auto trt_parser = common::infer_object(nvonnxparser::createParser(*trt_network, trt_logger));
+        for (int iter = 0; iter < num_iterations; ++iter)
+        {
+            // Stagger the models across threads so that different models are imported concurrently.
+            const std::vector<char>& onnx_buf = onnx_bufs[(thread_idx + iter) % onnx_bufs.size()];
+            std::shared_ptr<nvinfer1::INetworkDefinition> next_network;
+            {
+                std::lock_guard<std::mutex> lock(builder_mutex);
+                next_network = common::infer_object(trt_builder->createNetworkV2(explicitBatch));
+            }
+            if (!trt_parser->parseNext(*next_network, onnx_buf.data(), onnx_buf.size()))
+            {
+                ++failures;
+            }
+            trt_network = next_network;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < num_threads; ++t)
+    {
+        threads.emplace_back(worker, t);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    if (failures)
+    {
+        cout << failures << " of " << num_threads * num_iterations << " parses failed" << endl;
+        return -1;
+    }
+    cout << "All " << num_threads * num_iterations << " parses succeeded" << endl;
+    return 0;
+}
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2018, NVIDIA CORPORATION. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL
+ * THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "NvInferPlugin.h"
+#include "NvOnnxParser.h"
+#include "apiTestHelpers.hpp"
+#include "common.hpp"
+
+using std::cout;
+using std::endl;
+
+namespace {
+
+struct Shape {
+  int height;
+  int width;
+};
+
+struct ResizeCase {
+  const char* mode;
+  const char* transformationMode;
+  const char* nearestMode;
+  bool excludeOutside;
+};
+
+// How the output size of the Resize node is given.
+enum class SizeSource {
+  kSTATIC_SCALES,  // Static input shape, scales initializer.
+  kDYNAMIC_SCALES, // Dynamic height and width, scales initializer.
+  kDYNAMIC_SIZES,  // Dynamic height and width, sizes computed at runtime from the input shape.
+};
+
+// Scales for the static and dynamic scale cases, and size multipliers for the runtime sizes case.
+const std::vector<float> kSTATIC_SCALES{1.f, 1.f, 2.f, 1.5f};
+const std::vector<float> kDYNAMIC_SCALES{1.f, 1.f, 0.5f, 2.f};
+const std::vector<int64_t> kSIZE_MULTIPLIERS{1, 1, 3, 2};
+
+void print_usage() {
+  cout << "This program checks the Resize importer against a CPU port of the ONNX reference implementation, for "
+       << "each interpolation, coordinate transformation and nearest rounding mode, with static shapes, dynamic "
+       << "shapes and sizes computed at runtime." << endl;
+  cout << "Usage: resizeAPITest [-t tolerance (default 1e-3)] [-v]" << endl;
+}
+
+// Builds a model with a single Resize node on a (1, 1, H, W) input. If shape is null, H and W are dynamic.
+::ONNX_NAMESPACE::ModelProto makeModel(ResizeCase const& resizeCase, SizeSource source, Shape const* shape) {
+  ::ONNX_NAMESPACE::ModelProto model = apitest::makeModel("resize");
+  ::ONNX_NAMESPACE::GraphProto* graph = model.mutable_graph();
+  apitest::addInput(graph, "x", {1, 1, shape ? shape->height : -1, shape ? shape->width : -1});
+  apitest::addOutput(graph, "y");
+  apitest::addInitializer(graph, "roi", std::vector<float>{});
+  if (source == SizeSource::kDYNAMIC_SIZES) {
+    apitest::addInitializer(graph, "scales", std::vector<float>{});
+    apitest::addInitializer(graph, "multipliers", kSIZE_MULTIPLIERS);
+    apitest::addNode(graph, "Shape", {"x"}, {"x_shape"});
+    apitest::addNode(graph, "Mul", {"x_shape", "multipliers"}, {"sizes"});
+  } else {
+    apitest::addInitializer(graph, "scales", source == SizeSource::kSTATIC_SCALES ? kSTATIC_SCALES : kDYNAMIC_SCALES);
+  }
+
+  ::ONNX_NAMESPACE::NodeProto* node = apitest::addNode(graph, "Resize", {"x", "roi", "scales"}, {"y"});
+  if (source == SizeSource::kDYNAMIC_SIZES) {
+    node->add_input("sizes");
+  }
+  apitest::addStringAttribute(node, "mode", resizeCase.mode);
+  apitest::addStringAttribute(node, "coordinate_transformation_mode", resizeCase.transformationMode);
+  apitest::addStringAttribute(node, "nearest_mode", resizeCase.nearestMode);
+  apitest::addIntAttribute(node, "exclude_outside", resizeCase.excludeOutside ? 1 : 0);
+  return model;
+}
+
+// Port of interpolate_1d_with_x from the ONNX reference implementation (onnx/backend/test/case/node/resize.py).
+float interpolate1D(ResizeCase const& resizeCase, float const* data, int stride, int inSize, double scale, int x) {
+  const std::string transformationMode = resizeCase.transformationMode;
+  const double outSize = scale * inSize;
+  double xOriginal;
+  if (transformationMode == "align_corners") {
+    xOriginal = outSize == 1 ? 0. : x * (inSize - 1) / (outSize - 1);
+  } else if (transformationMode == "asymmetric") {
+    xOriginal = x / scale;
+  } else if (transformationMode == "pytorch_half_pixel") {
+    xOriginal = outSize == 1 ? -0.5 : (x + 0.5) / scale - 0.5;
+  } else if (transformationMode == "tf_half_pixel_for_nn") {
+    xOriginal = (x + 0.5) / scale;
+  } else {
+    xOriginal = (x + 0.5) / scale - 0.5;
+  }
+  const double xFloor = std::floor(xOriginal);
+  const bool isInteger = xOriginal == xFloor;
+  const double ratio = isInteger ? 1. : xOriginal - xFloor;
+
+  const std::string mode = resizeCase.mode;
+  const std::string nearestMode = resizeCase.nearestMode;
+  std::vector<double> coeffs;
+  if (mode == "nearest") {
+    if (isInteger || nearestMode == "ceil") {
+      coeffs = {0., 1.};
+    } else if (nearestMode == "floor") {
+      coeffs = {1., 0.};
+    } else if (nearestMode == "round_prefer_ceil") {
+      coeffs = {ratio < 0.5 ? 1. : 0., ratio >= 0.5 ? 1. : 0.};
+    } else {
+      coeffs = {ratio <= 0.5 ? 1. : 0., ratio > 0.5 ? 1. : 0.};
+    }
+  } else if (mode == "linear") {
+    coeffs = {1. - ratio, ratio};
+  } else {
+    const double a = -0.75;
+    const double r = ratio;
+    coeffs = {((a * (r + 1) - 5 * a) * (r + 1) + 8 * a) * (r + 1) - 4 * a,
+              ((a + 2) * r - (a + 3)) * r * r + 1,
+              ((a + 2) * (1 - r) - (a + 3)) * (1 - r) * (1 - r) + 1,
+              ((a * (2 - r) - 5 * a) * (2 - r) + 8 * a) * (2 - r) - 4 * a};
+  }
+
+  // The n points nearest to xOriginal in the edge-padded input, preferring the lower index on ties.
+  const int n = coeffs.size();
+  const int pad = (n + 1) / 2;
+  std::vector<int> indices(inSize + 2 * pad);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = static_cast<int>(i) - pad;
+  }
+  std::stable_sort(indices.begin(), indices.end(),
+                   [xOriginal](int a, int b) { return std::abs(xOriginal - a) < std::abs(xOriginal - b); });
+  indices.resize(n);
+  std::sort(indices.begin(), indices.end());
+
+  double sum = 0.;
+  double coeffSum = 0.;
+  for (int i = 0; i < n; ++i) {
+    if (resizeCase.excludeOutside && (indices[i] < 0 || indices[i] >= inSize)) {
+      continue;
+    }
+    const int index = std::min(std::max(indices[i], 0), inSize - 1);
+    sum += coeffs[i] * data[index * stride];
+    coeffSum += coeffs[i];
+  }
+  return static_cast<float>(resizeCase.excludeOutside ? sum / coeffSum : sum);
+}
+
+// Resizes height, then width.
+std::vector<float> reference(ResizeCase const& resizeCase, std::vector<float> const& x, Shape in, Shape out,
+                             double heightScale, double widthScale) {
+  std::vector<float> tmp(out.height * in.width);
+  for (int h = 0; h < out.height; ++h) {
+    for (int w = 0; w < in.width; ++w) {
+      tmp[h * in.width + w] = interpolate1D(resizeCase, x.data() + w, in.width, in.height, heightScale, h);
+    }
+  }
+  std::vector<float> y(out.height * out.width);
+  for (int h = 0; h < out.height; ++h) {
+    for (int w = 0; w < out.width; ++w) {
+      y[h * out.width + w] = interpolate1D(resizeCase, tmp.data() + h * in.width, 1, in.width, widthScale, w);
+    }
+  }
+  return y;
+}
+
+// Expected output shape of the Resize node.
+Shape outputShape(SizeSource source, Shape in) {
+  if (source == SizeSource::kDYNAMIC_SIZES) {
+    return Shape{static_cast<int>(in.height * kSIZE_MULTIPLIERS[2]), static_cast<int>(in.width * kSIZE_MULTIPLIERS[3])};
+  }
+  std::vector<float> const& scales = source == SizeSource::kSTATIC_SCALES ? kSTATIC_SCALES : kDYNAMIC_SCALES;
+  return Shape{static_cast<int>(std::floor(in.height * scales[2])), static_cast<int>(std::floor(in.width * scales[3]))};
+}
+
+// Runs the engine on each shape and returns the number of shapes whose output differs from the reference.
+int checkEngine(nvinfer1::ICudaEngine& engine, ResizeCase const& resizeCase, SizeSource source,
+                std::vector<Shape> const& shapes, float tolerance, std::mt19937& rng) {
+  auto context = common::infer_object(engine.createExecutionContext());
+  int failures = 0;
+  for (Shape const& shape : shapes) {
+    const Shape expectedShape = outputShape(source, shape);
+    const nvinfer1::Dims4 dims{1, 1, shape.height, shape.width};
+    const std::vector<float> x = apitest::randomValues(apitest::volume(dims), rng);
+    std::map<std::string, apitest::HostTensor> outputs;
+    bool ok = apitest::execute(*context, {{"x", {dims, x}}}, outputs);
+    const nvinfer1::Dims outputDims = outputs["y"].dims;
+    ok = ok && outputDims.nbDims == 4 && outputDims.d[2] == expectedShape.height
+        && outputDims.d[3] == expectedShape.width;
+
+    float maxError = 0.f;
+    if (ok) {
+      // As in ONNX, scales given by sizes are the ratio of output to input size.
+      const bool hasScales = source != SizeSource::kDYNAMIC_SIZES;
+      std::vector<float> const& scales = source == SizeSource::kSTATIC_SCALES ? kSTATIC_SCALES : kDYNAMIC_SCALES;
+      const double heightScale = hasScales ? scales[2] : static_cast<double>(expectedShape.height) / shape.height;
+      const double widthScale = hasScales ? scales[3] : static_cast<double>(expectedShape.width) / shape.width;
+      maxError = apitest::maxAbsError(
+          outputs["y"].values, reference(resizeCase, x, shape, expectedShape, heightScale, widthScale));
+    }
+    const bool passed = ok && maxError <= tolerance;
+    cout << "    " << shape.height << "x" << shape.width << " -> " << expectedShape.height << "x"
+         << expectedShape.width << ": " << (ok ? "" : "execution failed, ") << "max abs error " << maxError
+         << (passed ? " PASSED" : " FAILED") << endl;
+    failures += passed ? 0 : 1;
+  }
+  return failures;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+
+    GOOGLE_PROTOBUF_VERIFY_VERSION;
+
+    apitest::Options options;
+    if (!apitest::parseOptions(argc, argv, options, print_usage))
+    {
+        return 0;
+    }
+
+    common::TRT_Logger trt_logger(options.verbose ? nvinfer1::ILogger::Severity::kVERBOSE
+                                                  : nvinfer1::ILogger::Severity::kWARNING);
+    initLibNvInferPlugins(&trt_logger, "");
+    auto trt_builder = common::infer_object(nvinfer1::createInferBuilder(trt_logger));
+    const auto explicitBatch = 1U << static_cast<uint32_t>(nvinfer1::NetworkDefinitionCreationFlag::kEXPLICIT_BATCH);
+
+    const std::vector<ResizeCase> cases{
+        {"nearest", "half_pixel", "round_prefer_floor", false},
+        {"nearest", "pytorch_half_pixel", "round_prefer_ceil", false},
+        {"nearest", "asymmetric", "ceil", false},
+        {"nearest", "align_corners", "floor", false},
+        {"nearest", "tf_half_pixel_for_nn", "round_prefer_floor", false},
+        {"linear", "half_pixel", "round_prefer_floor", false},
+        {"linear", "pytorch_half_pixel", "round_prefer_floor", false},
+        {"linear", "align_corners", "round_prefer_floor", false},
+        {"linear", "asymmetric", "round_prefer_floor", false},
+        {"cubic", "half_pixel", "round_prefer_floor", false},
+        {"cubic", "align_corners", "round_prefer_floor", false},
+        {"cubic", "asymmetric", "round_prefer_floor", false},
+        {"cubic", "half_pixel", "round_prefer_floor", true},
+    };
+    // Heights are even so that the dynamic 0.5 scale gives exact output sizes.
+    const Shape minShape{2, 2};
+    const Shape maxShape{16, 16};
+    const std::vector<Shape> shapes{{4, 6}, {6, 5}, {8, 3}, {16, 16}};
+    std::mt19937 rng(0);
+
+    int failures = 0;
+    for (ResizeCase const& resizeCase : cases)
+    {
+        for (SizeSource source : {SizeSource::kSTATIC_SCALES, SizeSource::kDYNAMIC_SCALES, SizeSource::kDYNAMIC_SIZES})
+        {
+            const bool dynamic = source != SizeSource::kSTATIC_SCALES;
+            // exclude_outside needs static input dimensions.
+            if (dynamic && resizeCase.excludeOutside)
+            {
+                continue;
+            }
+            std::vector<Shape> const& testShapes = dynamic ? shapes : std::vector<Shape>{shapes[1]};
+            cout << resizeCase.mode << ", " << resizeCase.transformationMode << ", " << resizeCase.nearestMode
+                 << (resizeCase.excludeOutside ? ", exclude_outside" : "")
+                 << (source == SizeSource::kSTATIC_SCALES
+                     ? " (static scales):" : source == SizeSource::kDYNAMIC_SCALES
+                     ? " (dynamic scales):" : " (runtime sizes):") << endl;
+
+            auto trt_network = common::infer_object(trt_builder->createNetworkV2(explicitBatch));
+            auto trt_parser = common::infer_object(nvonnxparser::createParser(*trt_network, trt_logger));
+            if (!apitest::parseModel(*trt_parser, makeModel(resizeCase, source, dynamic ? nullptr : &testShapes[0]),
+                    "    "))
+            {
+                ++failures;
+                continue;
+            }
+
+            auto trt_config = common::infer_object(trt_builder->createBuilderConfig());
+            if (dynamic)
+            {
+                apitest::addProfile(*trt_builder, *trt_config, "x",
+                    nvinfer1::Dims4{1, 1, minShape.height, minShape.width},
+                    nvinfer1::Dims4{1, 1, shapes[0].height, shapes[0].width},
+                    nvinfer1::Dims4{1, 1, maxShape.height, maxShape.width});
+            }
+            auto trt_engine = apitest::buildEngine(*trt_builder, *trt_network, *trt_config, "    ");
+            if (!trt_engine)
+            {
+                ++failures;
+                continue;
+            }
+            failures += checkEngine(*trt_engine, resizeCase, source, testShapes, options.tolerance, rng);
+        }
+    }
+
+    cout << (failures ? "FAILED" : "PASSED") << endl;
+    return failures ? 1 : 0;
+}